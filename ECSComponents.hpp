@@ -7,8 +7,14 @@
 
 namespace cmp
 {
+	// a point light at the entity's translation, its color comes from cmp::Color
 	struct Light
-	{};
+	{
+		float radius = 100.f;
+
+		Light() noexcept = default;
+		Light(float radius) : radius(radius) {}
+	};
 
     struct Sprite
     {
@@ -57,4 +63,10 @@ namespace cmp
     struct PlayerControl
     {
     };
+
+	// the model's collision mesh hides other models in the occlusion test,
+	// meant for walls and other large meshes
+	struct Occluder
+	{
+	};
 }
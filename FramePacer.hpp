@@ -0,0 +1,111 @@
+#pragma once
+#include "TimeHelper.hpp"
+#include <thread>
+#include <algorithm>
+#include <cstddef>
+
+// Sleeps most of the way to the deadline, then yields for the remainder.
+// OS sleeps routinely overshoot by a scheduler tick, so the last stretch
+// is not left to them.
+static void SleepUntil(TimePoint_ns deadline, nanoseconds spinThreshold = std::chrono::milliseconds(2))
+{
+    auto remaining = deadline - NowNanoseconds();
+    if (remaining > spinThreshold)
+    {
+        std::this_thread::sleep_for(remaining - spinThreshold);
+    }
+    while (NowNanoseconds() < deadline)
+    {
+        std::this_thread::yield();
+    }
+}
+
+// Fixed timestep accumulator with an optional frame rate cap.
+// Each frame: BeginFrame, StepUpdate until it returns false, draw with
+// GetInterpolation, then EndFrame.
+class FramePacer
+{
+    nanoseconds updateStep;
+    nanoseconds targetFrameTime;
+    size_t maxUpdatesPerFrame;
+    TimePoint_ns simulationTime;
+    TimePoint_ns frameStart;
+    nanoseconds accumulator = nanoseconds::zero();
+
+public:
+    // a targetFrameTime of zero leaves pacing to vsync
+    FramePacer(
+        nanoseconds updateStep,
+        nanoseconds targetFrameTime = nanoseconds::zero(),
+        size_t maxUpdatesPerFrame = 5)
+        : updateStep(updateStep),
+          targetFrameTime(targetFrameTime),
+          maxUpdatesPerFrame(std::max(maxUpdatesPerFrame, size_t(1)))
+    {
+    }
+
+    void Start(TimePoint_ns now)
+    {
+        simulationTime = now;
+        frameStart = now;
+        accumulator = nanoseconds::zero();
+    }
+
+    // adds the real time since the last frame, dropping whatever exceeds
+    // maxUpdatesPerFrame steps so a long stall cannot snowball
+    void BeginFrame(TimePoint_ns now)
+    {
+        accumulator += now - frameStart;
+        frameStart = now;
+        auto maxAccumulated = updateStep * static_cast<int64_t>(maxUpdatesPerFrame);
+        if (accumulator > maxAccumulated)
+        {
+            simulationTime += accumulator - maxAccumulated;
+            accumulator = maxAccumulated;
+        }
+    }
+
+    // consumes one update step if enough time has accumulated
+    bool StepUpdate()
+    {
+        if (accumulator < updateStep)
+        {
+            return false;
+        }
+        accumulator -= updateStep;
+        simulationTime += updateStep;
+        return true;
+    }
+
+    TimePoint_ns GetSimulationTime() const
+    {
+        return simulationTime;
+    }
+
+    // fraction of an update step between the last update and now, for
+    // blending the last two simulation states when drawing
+    float GetInterpolation() const
+    {
+        return static_cast<float>(
+            static_cast<double>(accumulator.count()) / static_cast<double>(updateStep.count()));
+    }
+
+    // when StepUpdate will next succeed, as of the last BeginFrame
+    TimePoint_ns GetNextUpdateTime() const
+    {
+        return frameStart + (updateStep - accumulator);
+    }
+
+    TimePoint_ns GetFrameDeadline() const
+    {
+        return frameStart + targetFrameTime;
+    }
+
+    void EndFrame()
+    {
+        if (targetFrameTime > nanoseconds::zero())
+        {
+            SleepUntil(GetFrameDeadline());
+        }
+    }
+};
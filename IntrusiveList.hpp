@@ -6,11 +6,11 @@ class IntrusiveList
 public:
     void push_front(T* element)
     {
+        element->previous = nullptr;
+        element->next = root;
         if (root != nullptr)
         {
-            auto prevRoot = root;
-            prevRoot->previous = element;
-            element->next = prevRoot;
+            root->previous = element;
         }
         root = element;
         ++count;
@@ -18,7 +18,12 @@ public:
 
     void pop_front()
     {
+        auto element = root;
         root = root->next;
+        if (root != nullptr)
+            root->previous = nullptr;
+        element->next = nullptr;
+        element->previous = nullptr;
         if (count > 0)
             --count;
     }
@@ -28,18 +33,29 @@ public:
         return root;
     }
 
+    // elements not in the list are left alone
     void erase(T* element)
     {
+        if (!contains(element))
+            return;
         if (element->previous != nullptr)
             element->previous->next = element->next;
         if (element->next != nullptr)
             element->next->previous = element->previous;
         if (root == element)
-            root = nullptr;
+            root = element->next;
+        element->next = nullptr;
+        element->previous = nullptr;
         if (count > 0)
             --count;
     }
 
+    // only valid for elements that are in this list or in none
+    bool contains(const T* element) const
+    {
+        return element == root || element->previous != nullptr;
+    }
+
     const size_t& size() { return count; }
 private:
     T* root = nullptr;
@@ -3,6 +3,7 @@
 #include <vector>
 #include <algorithm>
 #include <memory>
+#include <cmath>
 #include "IntrusiveList.hpp"
 
 namespace QT
@@ -39,6 +40,15 @@ namespace QT
                     (rect.GetBottom() <= GetBottom());
         }
 
+        // touching edges count as overlap
+        bool Intersects(const Rect& rect) const
+        {
+            return  (rect.GetLeft()   <= GetRight())  &&
+                    (rect.GetRight()  >= GetLeft())   &&
+                    (rect.GetTop()    <= GetBottom()) &&
+                    (rect.GetBottom() >= GetTop());
+        }
+
         double GetLeft() const
         {
             return x - xRadius;
@@ -85,6 +95,7 @@ namespace QT
     class Tree
     {
     public:
+        static constexpr size_t Depths = 8;
         static constexpr size_t TotalNodes = 1 + (2*2) + (4*4) + (8*8) + (16*16) + (32*32) + (64*64) + (128*128);
 
         struct Node
@@ -101,6 +112,7 @@ namespace QT
             Node& operator=(Rect&& region)
             {
                 rect = std::move(region);
+                return *this;
             }
 
             ObjectType* begin()
@@ -118,6 +130,11 @@ namespace QT
                 objects.erase(objectPtr);
             }
 
+            bool ContainsObject(const ObjectType* objectPtr) const
+            {
+                return objects.contains(objectPtr);
+            }
+
             void SetRegion(const Rect& region)
             {
                 rect = region;
@@ -203,12 +220,12 @@ namespace QT
         // radius must be positive
         Tree(const double& radius) : 
             radius(radius),
-            inverseRadius(255.0/(radius * 2))
+            inverseRadius(256.0/(radius * 2))
         {
             nodes.resize(TotalNodes);
             auto radiusAtDepth = radius;
             auto nodeIndex = 0U;
-            for (auto depth = 0U; depth < 7U; ++depth)
+            for (auto depth = 0U; depth < Depths; ++depth)
             {
                 auto cellsPerAxis = 1U << depth;
                 for (auto y = 0U; y < cellsPerAxis; y++)
@@ -247,8 +264,16 @@ namespace QT
             // if it is unchanged from old, return
             auto newIndex = ChooseIndex(objectPtr->boundingBox);
             auto oldIndex = objectPtr->nodeIndex;
-            nodes[oldIndex].RemoveObject(objectPtr);
+            if (nodes[oldIndex].ContainsObject(objectPtr))
+            {
+                if (newIndex == oldIndex)
+                {
+                    return;
+                }
+                nodes[oldIndex].RemoveObject(objectPtr);
+            }
             nodes[newIndex].InsertObject(objectPtr);
+            objectPtr->nodeIndex = newIndex;
         }
 
         void Remove(ObjectType* objectPtr)
@@ -271,18 +296,61 @@ namespace QT
                 return;
         }
 
+        // iterates the objects of every node overlapping region, a superset of
+        // the objects that overlap it
         RegionIterator GetIteratorForRegion(const Rect& region)
         {
-            auto regionIndex = ChooseIndex(region);
-
             std::vector<Node*> nodePtrsTemp;
-            RecurseTree(nodePtrsTemp, &nodes[regionIndex]);
+            CollectNodes(nodePtrsTemp, root, region);
             
             RegionIterator iter = RegionIterator(std::move(nodePtrsTemp));
             return iter;
         }
 
+        // appends the objects whose bounding boxes overlap region; only nodes
+        // overlapping region are visited, so the cost follows the region's
+        // contents rather than the tree's
+        void Query(const Rect& region, std::vector<ObjectType*>& found)
+        {
+            QueryNode(root, region, found);
+        }
+
     private:
+        void CollectNodes(std::vector<Node*>& nodePtrs, Node* node, const Rect& region)
+        {
+            if (node->size() > 0)
+            {
+                nodePtrs.push_back(node);
+            }
+            for (Node* child : node->children)
+            {
+                if (child != nullptr && child->rect.Intersects(region))
+                {
+                    CollectNodes(nodePtrs, child, region);
+                }
+            }
+        }
+
+        // objects outside the root's region are kept in the root, so it is
+        // always visited
+        void QueryNode(Node* node, const Rect& region, std::vector<ObjectType*>& found)
+        {
+            for (auto objectPtr = node->begin(); objectPtr != nullptr; objectPtr = objectPtr->next)
+            {
+                if (objectPtr->boundingBox.Intersects(region))
+                {
+                    found.push_back(objectPtr);
+                }
+            }
+            for (Node* child : node->children)
+            {
+                if (child != nullptr && child->rect.Intersects(region))
+                {
+                    QueryNode(child, region, found);
+                }
+            }
+        }
+
         static uint8_t HighestBit(const uint8_t& bits)
         {
             static constexpr uint8_t Bit7 = 1 << 7;
@@ -0,0 +1,94 @@
+#pragma once
+#include "QuadTree.hpp"
+#include "glm/glm.hpp"
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <algorithm>
+#include <limits>
+
+// world space bounds of a left, top, right, bottom rect placed by transform
+static QT::Rect TransformedBounds(const glm::mat4& transform, const glm::vec4& rect)
+{
+    glm::vec2 minimum(std::numeric_limits<float>::max());
+    glm::vec2 maximum(std::numeric_limits<float>::lowest());
+    for (auto corner : { glm::vec2(rect.x, rect.y), glm::vec2(rect.z, rect.y), glm::vec2(rect.x, rect.w), glm::vec2(rect.z, rect.w) })
+    {
+        auto position = glm::vec2(transform * glm::vec4(corner, 0.f, 1.f));
+        minimum = glm::min(minimum, position);
+        maximum = glm::max(maximum, position);
+    }
+    auto center = (minimum + maximum) * 0.5f;
+    auto radius = (maximum - minimum) * 0.5f;
+    return QT::Rect(center.x, center.y, radius.x, radius.y);
+}
+
+// the world region a 2D view projection shows, found by unprojecting the
+// corners of clip space so camera rotation or zoom need no special cases
+static QT::Rect ViewRegion(const glm::mat4& viewProjection)
+{
+    auto inverse = glm::inverse(viewProjection);
+    return TransformedBounds(inverse, glm::vec4(-1.f, -1.f, 1.f, 1.f));
+}
+
+// Keeps 2D entities in a quadtree by their world bounds. Callers update an
+// entity when its transform changes; each frame a query returns the entities
+// overlapping the view, so the cost follows what is on screen rather than
+// how large the world is.
+template <typename Key>
+class SpriteVisibility
+{
+public:
+    // entities beyond radius from the origin still work but are tested every query
+    explicit SpriteVisibility(double radius) : 
+        tree(radius)
+    {}
+
+    void InsertOrUpdate(Key key, const QT::Rect& bounds)
+    {
+        auto& object = objects[key];
+        if (object == nullptr)
+        {
+            object = std::make_unique<Object>();
+            object->data = key;
+        }
+        object->boundingBox = bounds;
+        tree.InsertOrUpdate(object.get());
+    }
+
+    void Remove(Key key)
+    {
+        auto object = objects.find(key);
+        if (object == objects.end())
+        {
+            return;
+        }
+        tree.Remove(object->second.get());
+        objects.erase(object);
+    }
+
+    // visible keys in ascending order, so draw order does not depend on
+    // where entities sit in the tree
+    const std::vector<Key>& Query(const QT::Rect& region)
+    {
+        found.clear();
+        tree.Query(region, found);
+        visible.clear();
+        for (auto object : found)
+        {
+            visible.push_back(object->data);
+        }
+        std::sort(visible.begin(), visible.end());
+        return visible;
+    }
+
+    size_t size() const { return objects.size(); }
+
+private:
+    using Object = QT::Object<Key>;
+    QT::Tree<Object> tree;
+    // objects are linked into the tree by address, so each lives on the heap
+    std::unordered_map<Key, std::unique_ptr<Object>> objects;
+    std::vector<Object*> found;
+    std::vector<Key> visible;
+};
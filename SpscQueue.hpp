@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <optional>
+#include <cstddef>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. One slot is kept empty to tell a full queue from an empty one, so
+// it holds at most S - 1 elements.
+template <typename T, size_t S>
+class SpscQueue
+{
+    static_assert(S > 1, "SpscQueue needs at least two slots");
+
+    std::array<T, S> storage;
+    // written only by the consumer
+    alignas(64) std::atomic<size_t> head = 0;
+    // written only by the producer
+    alignas(64) std::atomic<size_t> tail = 0;
+
+public:
+    // returns false without blocking when the queue is full
+    bool tryPush(const T &value)
+    {
+        auto currentTail = tail.load(std::memory_order_relaxed);
+        auto nextTail = (currentTail + 1) % S;
+        if (nextTail == head.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        storage[currentTail] = value;
+        tail.store(nextTail, std::memory_order_release);
+        return true;
+    }
+
+    std::optional<T> tryPop()
+    {
+        auto currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead == tail.load(std::memory_order_acquire))
+        {
+            return std::nullopt;
+        }
+        std::optional<T> result = storage[currentHead];
+        head.store((currentHead + 1) % S, std::memory_order_release);
+        return result;
+    }
+
+    bool empty() const
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
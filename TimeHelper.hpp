@@ -3,7 +3,9 @@
 
 using Clock = std::chrono::steady_clock;
 using milliseconds = std::chrono::milliseconds;
+using nanoseconds = std::chrono::nanoseconds;
 using TimePoint_ms = std::chrono::time_point<Clock, milliseconds>;
+using TimePoint_ns = std::chrono::time_point<Clock, nanoseconds>;
 constexpr auto MillisecondsPerSecond = 
     std::chrono::duration_cast<milliseconds>(std::chrono::seconds(1));
 constexpr auto UpdateDuration = MillisecondsPerSecond / 50;
@@ -13,4 +15,9 @@ static TimePoint_ms NowMilliseconds()
     auto now = Clock::now();
     auto now_ms = std::chrono::time_point_cast<milliseconds>(now);
     return now_ms;
-}
\ No newline at end of file
+}
+
+static TimePoint_ns NowNanoseconds()
+{
+    return std::chrono::time_point_cast<nanoseconds>(Clock::now());
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Single producer, single consumer hand-off of whole values without locks.
+// The writer fills GetWriteBuffer and calls Publish; the reader calls Acquire
+// to switch to the newest published value, if any, and reads GetReadBuffer.
+// Neither side ever waits on the other, and buffers are reused, so their
+// allocations survive from one hand-off to the next.
+template <typename T>
+class TripleBuffer
+{
+    static constexpr uint8_t IndexMask = 0x3;
+    static constexpr uint8_t FreshBit = 0x4;
+
+    std::array<T, 3> buffers;
+    // index of the buffer between writer and reader, FreshBit marks it unread
+    std::atomic<uint8_t> middle = 1;
+    uint8_t writeIndex = 0;
+    uint8_t readIndex = 2;
+
+public:
+    T &GetWriteBuffer()
+    {
+        return buffers[writeIndex];
+    }
+
+    void Publish()
+    {
+        auto previous = middle.exchange(writeIndex | FreshBit, std::memory_order_acq_rel);
+        writeIndex = previous & IndexMask;
+    }
+
+    // returns true if a newer value was published since the last Acquire
+    bool Acquire()
+    {
+        if ((middle.load(std::memory_order_relaxed) & FreshBit) == 0)
+        {
+            return false;
+        }
+        auto previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & IndexMask;
+        return true;
+    }
+
+    const T &GetReadBuffer() const
+    {
+        return buffers[readIndex];
+    }
+};
@@ -1,6 +1,9 @@
 #pragma once
 #include <fstream>
 #include <vector>
+#include <string>
+#include <stdexcept>
+#include <filesystem>
 
 namespace fileIO
 {
@@ -22,4 +25,37 @@ namespace fileIO
 
 		return buffer;
 	}
+
+	// writes to a temporary file first so a crash mid write never leaves a
+	// truncated file behind, then replaces the target in one rename
+	static bool writeFileAtomic(const std::string& filename, const std::vector<char>& data)
+	{
+		auto path = std::filesystem::path(filename);
+		auto tempPath = path;
+		tempPath += ".tmp";
+		std::error_code error;
+		if (path.has_parent_path())
+		{
+			std::filesystem::create_directories(path.parent_path(), error);
+		}
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				return false;
+			}
+			file.write(data.data(), data.size());
+			if (!file)
+			{
+				return false;
+			}
+		}
+		std::filesystem::rename(tempPath, path, error);
+		if (error)
+		{
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+		return true;
+	}
 }
\ No newline at end of file
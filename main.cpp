@@ -12,6 +12,7 @@
 #include "vka/VulkanApp.hpp"
 #include "TimeHelper.hpp"
 #include "ECSComponents.hpp"
+#include "SpriteVisibility.hpp"
 #include "Models.hpp"
 #include "entt/entt.hpp"
 #include "btBulletDynamicsCommon.h"
@@ -33,10 +34,27 @@ namespace Fonts
 	constexpr auto AeroviasBrasil = entt::HashedString(CONTENTROOT "Content/Fonts/AeroviasBrasilNF.ttf");
 }
 
+namespace Sprites
+{
+	constexpr auto StarImage = entt::HashedString(CONTENTROOT "Content/Images/star.png");
+	constexpr auto Star = entt::HashedString("star");
+}
+
+// half the width of the 2D world the sprite quadtree covers
+constexpr double SpriteWorldRadius = 65536.0;
+
 class ClientApp : public vka::VulkanApp
 {
 public:
 	entt::DefaultRegistry enttRegistry;
+	SpriteVisibility<entt::DefaultRegistry::entity_type> spriteVisibility = 
+		SpriteVisibility<entt::DefaultRegistry::entity_type>(SpriteWorldRadius);
+
+	ClientApp()
+	{
+		// destroyed sprites leave the quadtree along with their components
+		enttRegistry.destruction<cmp::Sprite>().connect<ClientApp, &ClientApp::SpriteDestroyed>(this);
+	}
 	vka::Model cubeModel;
 	vka::Model cylinderModel;
 	vka::Model icosphereSub2Model;
@@ -47,7 +65,7 @@ public:
 	{
 		LoadModelFromFile(Models::Path, Models::Cube::file);
 		LoadModelFromFile(Models::Path, Models::Cylinder::file);
-		LoadModelFromFile(Models::Path, Models::IcosphereSub2::file);
+		LoadModelFromFile(Models::Path, Models::IcosphereSub2::file, vka::VertexFormat::Quantized);
 		LoadModelFromFile(Models::Path, Models::Pentagon::file);
 		LoadModelFromFile(Models::Path, Models::Triangle::file);
 	}
@@ -59,6 +77,19 @@ public:
 		//CreateSprite(Sprites::SpriteSheet1::ImagePath,
 		//             Sprites::SpriteSheet1::starpng::Name,
 		//             Sprites::SpriteSheet1::starpng::SpriteQuad);
+
+		auto star = vka::loadImageFromFile(std::string(Sprites::StarImage));
+		CreateImage2D(Sprites::StarImage, star);
+		auto halfWidth = star.m_Width * 0.5f;
+		auto halfHeight = star.m_Height * 0.5f;
+		CreateSprite(Sprites::StarImage, Sprites::Star,
+			vka::MakeQuad(-halfWidth, -halfHeight, halfWidth, halfHeight, 0.f, 0.f, 1.f, 1.f));
+
+		// 2D entities, placed once the sprite they show exists
+		for (auto i = 0.f; i < 3.f; ++i)
+		{
+			CreateSpriteEntity(Sprites::Star, glm::translate(glm::mat4(1.f), glm::vec3(i * 100.f, 0.f, 0.f)), glm::vec4(1.f));
+		}
 	}
 
 	void Update(TimePoint_ms updateTime)
@@ -87,28 +118,75 @@ public:
 		//auto physicsView = enttRegistry.persistent<cmp::Engine, cmp::Velocity, cmp::Position, cmp::Transform>();
 	}
 
-	void Draw()
+	entt::DefaultRegistry::entity_type CreateSpriteEntity(uint64_t spriteIndex, const glm::mat4 &transform, const glm::vec4 &color)
 	{
-		// 2D rendering
-		//auto view = enttRegistry.view<cmp::Sprite, cmp::Transform, cmp::Color>(entt::persistent_t{});
-  //      for (auto entity : view)
-  //      {
-  //          auto &sprite = view.get<cmp::Sprite>(entity);
-  //          auto &transform = view.get<cmp::Transform>(entity);
-  //          auto &color = view.get<cmp::Color>(entity);
-  //          if (transform.matrix.has_value())
-  //          {
-  //              RenderSpriteInstance(sprite.index, transform.matrix.value(), color.rgba);
-  //          }
-  //      }
+		auto entity = enttRegistry.create();
+		enttRegistry.assign<cmp::Sprite>(entity, spriteIndex);
+		enttRegistry.assign<cmp::Transform>(entity, transform);
+		enttRegistry.assign<cmp::Color>(entity, color);
+		PlaceSprite(entity, transform);
+		return entity;
+	}
+
+	void SpriteDestroyed(entt::DefaultRegistry &, const entt::DefaultRegistry::entity_type entity)
+	{
+		spriteVisibility.Remove(entity);
+	}
+
+	// sprites must be placed through here so the quadtree follows them
+	void PlaceSprite(entt::DefaultRegistry::entity_type entity, const glm::mat4 &transform)
+	{
+		enttRegistry.get<cmp::Transform>(entity) = transform;
+		const auto &sprite = data2D.sprites.at(enttRegistry.get<cmp::Sprite>(entity).index);
+		spriteVisibility.InsertOrUpdate(entity, TransformedBounds(transform, vka::QuadRect(sprite.quad)));
+	}
+
+	void ExtractRenderState(vka::RenderSnapshot &snapshot)
+	{
+		// 2D rendering, only what the 2D camera can see
+		const auto &visible = spriteVisibility.Query(ViewRegion(snapshot.camera.viewProjection2D));
+		for (auto entity : visible)
+		{
+			const auto &sprite = enttRegistry.get<cmp::Sprite>(entity);
+			const glm::mat4 &transform = enttRegistry.get<cmp::Transform>(entity);
+			const glm::vec4 &color = enttRegistry.get<cmp::Color>(entity);
+			snapshot.sprites.push_back({sprite.index, transform, color});
+		}
+
+		// lights
+		auto lightView = enttRegistry.view<
+			cmp::Light,
+			cmp::Transform,
+			cmp::Color>(entt::persistent_t{});
+		for (auto entity : lightView)
+		{
+			const auto &[l, t, c] = lightView.get<cmp::Light, cmp::Transform, cmp::Color>(entity);
+			const glm::mat4 &transform = t;
+			const glm::vec4 &color = c;
+			snapshot.lights.push_back({glm::vec3(transform[3]), l.radius, color});
+		}
 
 		// 3D rendering
 		auto cubeView = enttRegistry.view<
 			cmp::Transform,
 			cmp::Color,
 			Models::Cube>(entt::persistent_t{});
-		BeginRender(5);
-		RenderModelInstances<cmp::Transform, cmp::Color, Models::Cube>(cubeView);
+		for (auto entity : cubeView)
+		{
+			const auto &[t, c, m] = cubeView.get<cmp::Transform, cmp::Color, Models::Cube>(entity);
+			const glm::mat4 &transform = t;
+			const glm::vec4 &color = c;
+			const uint64_t &modelIndex = m;
+			auto occluder = enttRegistry.has<cmp::Occluder>(entity);
+			snapshot.models.push_back({modelIndex, transform, color, occluder});
+		}
+	}
+
+	void Draw(const vka::RenderSnapshot &snapshot, float interpolation)
+	{
+		BeginRenderPass(gsl::narrow<uint32_t>(snapshot.models.size()));
+		RenderSnapshotModels(snapshot);
+		RenderSnapshotSprites(snapshot);
 	}
 };
 
@@ -174,6 +252,9 @@ int main()
 	// physics view
 	//app.enttRegistry.prepare<cmp::Engine, cmp::Velocity, cmp::Position, cmp::Transform>();
 
+	// light view
+	app.enttRegistry.prepare<cmp::Light, cmp::Transform, cmp::Color>();
+
 	// 3D render views
 	app.enttRegistry.prepare<cmp::Transform, cmp::Color, Models::Cube>();
 	app.enttRegistry.prepare<cmp::Transform, cmp::Color, Models::Cylinder>();
@@ -181,15 +262,7 @@ int main()
 	app.enttRegistry.prepare<cmp::Transform, cmp::Color, Models::Pentagon>();
 	app.enttRegistry.prepare<cmp::Transform, cmp::Color, Models::Triangle>();
 
-	auto starPrototype = entt::DefaultPrototype(app.enttRegistry);
-	starPrototype.set<cmp::Sprite>();
-	starPrototype.set<cmp::Transform>(glm::mat4(1.f));
-	starPrototype.set<cmp::Color>(glm::vec4(1.f));
-	// 2D entities
-	for (auto i = 0.f; i < 3.f; ++i)
-	{
-		auto entity = starPrototype();
-	}
+	// 2D entities are created in LoadImages, they need their sprite to be placed
 
 	// 3D entities
 	auto lightPrototype = entt::DefaultPrototype(app.enttRegistry);
@@ -211,6 +284,17 @@ int main()
 		app.enttRegistry.get<cmp::Transform>(entity) = glm::translate(glm::mat4(1.f), glm::vec3(i * 100.f));
 	}
 
+	auto wallPrototype = entt::DefaultPrototype(app.enttRegistry);
+	wallPrototype.set<cmp::Transform>();
+	wallPrototype.set<Models::Cube>();
+	wallPrototype.set<cmp::Color>(glm::vec4(0.5f, 0.5f, 0.5f, 1.f));
+	wallPrototype.set<cmp::Occluder>();
+
+	auto wall = wallPrototype();
+	app.enttRegistry.get<cmp::Transform>(wall) = glm::scale(
+		glm::translate(glm::mat4(1.f), glm::vec3(100.f, 100.f, -50.f)),
+		glm::vec3(400.f, 400.f, 2.f));
+
 	try
 	{
 		app.Run(std::string(ConfigPath));
@@ -0,0 +1,20 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
+
+// textures keep their slot while loaded; slots without a texture are never sampled
+layout(set = 0, binding = 1) uniform sampler samp;
+layout(set = 0, binding = 2) uniform texture2D tex[];
+
+// one draw mixes textures, so the index may differ between neighbouring pixels
+layout(location = 0) in vec2 inTexCoord;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) flat in uint inTextureIndex;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    vec4 sampledColor = texture(sampler2D(tex[nonuniformEXT(inTextureIndex)], samp), inTexCoord);
+    outColor = inColor * sampledColor;
+}
@@ -3,21 +3,18 @@
 
 layout(constant_id = 0) const uint TextureCount = 1;
 
-layout(set = 0, binding = 0) uniform sampler samp;
-layout(set = 0, binding = 1) uniform texture2D tex[TextureCount];
-
-layout(push_constant) uniform FragmentPushConstants
-{
-    layout(offset = 0) uint imageOffset;
-    layout(offset = 16) vec4 color;
-} fragmentPushConstants;
+layout(set = 0, binding = 1) uniform sampler samp;
+layout(set = 0, binding = 2) uniform texture2D tex[TextureCount];
 
+// sprites are batched per texture here, so the index is uniform across a draw
 layout(location = 0) in vec2 inTexCoord;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) flat in uint inTextureIndex;
 
 layout(location = 0) out vec4 outColor;
 
 void main()
 {
-    vec4 sampledColor = texture(sampler2D(tex[fragmentPushConstants.imageOffset], samp), inTexCoord);
-    outColor = fragmentPushConstants.color * sampledColor;
-}
\ No newline at end of file
+    vec4 sampledColor = texture(sampler2D(tex[inTextureIndex], samp), inTexCoord);
+    outColor = inColor * sampledColor;
+}
@@ -1,33 +1,50 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-// vertex attributes
-layout(location = 0) in vec2 inPosition;
-layout(location = 1) in vec2 inTexCoord;
+// matches vka::SpriteData, one per instance
+struct Sprite
+{
+    mat4 transform;
+    vec4 uvRect;
+    vec4 color;
+    uint textureIndex;
+};
 
-// uniform buffers
-layout(binding = 0) uniform Matrices
+layout(set = 1, binding = 0) readonly buffer Sprites
 {
-    mat4 view;
-    mat4 projection;
-} matrices;
+    Sprite sprites[];
+};
 
-layout(binding = 1) uniform DynamicMatrices
+layout(push_constant) uniform VertexPushConstants
 {
-    mat4 M;
-    mat4 MVP;
-} dynamicMatrices;
+    mat4 viewProjection;
+} vertexPushConstants;
 
 // shader interface
 layout(location = 0) out vec2 outTexCoord;
+layout(location = 1) out vec4 outColor;
+layout(location = 2) flat out uint outTextureIndex;
 out gl_PerVertex
 {
     vec4 gl_Position;
 };
 
+// two triangles over the unit quad, wound like vka::MakeQuad
+const vec2 corners[6] = vec2[](
+    vec2(0.0, 0.0),
+    vec2(0.0, 1.0),
+    vec2(1.0, 1.0),
+    vec2(1.0, 1.0),
+    vec2(1.0, 0.0),
+    vec2(0.0, 0.0));
+
 void main()
 {
-    outTexCoord = inTexCoord;
+    Sprite sprite = sprites[gl_InstanceIndex];
+    vec2 corner = corners[gl_VertexIndex];
+    outTexCoord = mix(sprite.uvRect.xy, sprite.uvRect.zw, corner);
+    outColor = sprite.color;
+    outTextureIndex = sprite.textureIndex;
 
-    gl_Position = dynamicMatrices.MVP * vec4(inPosition, 0.0, 1.0);
-}
\ No newline at end of file
+    gl_Position = vertexPushConstants.viewProjection * sprite.transform * vec4(corner, 0.0, 1.0);
+}
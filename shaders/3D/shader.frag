@@ -1,28 +1,67 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(constant_id = 0) const uint MaxLights = 3;
+layout(set = 0, binding = 0) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    // clusters per pixel in xy, the depth slice is log(depth) * z + w
+    vec4 clusterScale;
+    // cluster counts in xyz, the light count in w
+    uvec4 clusterCounts;
+} frame;
 
-layout(push_constant) uniform FragmentPushConstants
+struct Light
 {
+    // view space position and radius
+    vec4 positionRadius;
+    // alpha scales the intensity
     vec4 color;
-} fragmentPushConstants;
+};
+
+layout(set = 0, binding = 1) readonly buffer Lights
+{
+    Light lights[];
+};
+
+// offset and count into lightIndices per cluster
+layout(set = 0, binding = 2) readonly buffer Clusters
+{
+    uvec2 clusterRanges[];
+};
+
+layout(set = 0, binding = 3) readonly buffer LightIndices
+{
+    uint lightIndices[];
+};
 
-layout(location = 0) in vec3 normal_CameraSpace;
-layout(location = 1) in vec3 lightDirection_CameraSpace[MaxLights];
-layout(location = 4) flat in vec4 lightColors[MaxLights];
+layout(location = 0) flat in vec4 instanceColor;
+layout(location = 1) in vec3 normal_CameraSpace;
+layout(location = 2) in vec3 position_CameraSpace;
 
 layout(location = 0) out vec4 outColor;
 
 void main()
 {
-    vec4 diffuseColor = fragmentPushConstants.color;
-    for (uint i = 0; i < MaxLights; i++)
+    // only the lights binned into this fragment's cluster can reach it
+    uvec3 cluster;
+    cluster.xy = uvec2(gl_FragCoord.xy * frame.clusterScale.xy);
+    cluster.z = uint(max(log(-position_CameraSpace.z) * frame.clusterScale.z + frame.clusterScale.w, 0.0));
+    cluster = min(cluster, frame.clusterCounts.xyz - 1u);
+    uint clusterIndex = (cluster.z * frame.clusterCounts.y + cluster.y) * frame.clusterCounts.x + cluster.x;
+    uvec2 range = clusterRanges[clusterIndex];
+
+    vec3 n = normalize(normal_CameraSpace);
+    vec3 lighting = vec3(0);
+    for (uint i = range.x; i < range.x + range.y; i++)
     {
-        vec3 l = normalize(lightDirection_CameraSpace[i]);
-        vec3 n = normalize(normal_CameraSpace);
-        float cosTheta = clamp(dot(n, l), 0, 1);
-        diffuseColor *= vec4(lightColors[i].rgb * (cosTheta * lightColors[i].a), 1);
+        Light light = lights[lightIndices[i]];
+        vec3 toLight = light.positionRadius.xyz - position_CameraSpace;
+        float lightDistance = length(toLight);
+        // falls to zero at the radius, so lights outside a cluster add nothing
+        float falloff = clamp(1.0 - lightDistance / light.positionRadius.w, 0, 1);
+        float cosTheta = clamp(dot(n, toLight / max(lightDistance, 0.0001)), 0, 1);
+        lighting += light.color.rgb * (light.color.a * cosTheta * falloff * falloff);
     }
-    outColor = diffuseColor;
-}
\ No newline at end of file
+    outColor = vec4(instanceColor.rgb * lighting, instanceColor.a);
+}
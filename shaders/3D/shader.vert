@@ -4,51 +4,61 @@
 layout(location = 0) in vec3 vertexPosition_ModelSpace;
 layout(location = 1) in vec3 vertexNormal_ModelSpace;
 
-layout(binding = 0) uniform DynamicMatrices
-{
-    mat4 M;
-    mat4 MVP;
-} dynamicMatrices;
-
-layout(binding = 1) uniform Matrices
+layout(set = 0, binding = 0) uniform Frame
 {
     mat4 view;
     mat4 projection;
-} matrices;
+    vec4 clusterScale;
+    uvec4 clusterCounts;
+} frame;
+
+// normals arrive as two octahedral components instead of a vec3
+layout(constant_id = 1) const bool OctahedralNormals = false;
+
+struct InstanceData
+{
+    mat4 M;
+    vec4 color;
+};
 
-layout(constant_id = 0) const uint MaxLights = 3;
-layout(binding = 2) uniform Lights
+layout(set = 1, binding = 0) readonly buffer Instances
 {
-    vec4 position_WorldSpace[MaxLights];
-    vec4 color[MaxLights];
-} lights;
+    InstanceData instances[];
+};
 
-layout(location = 0) out vec3 vertexNormal_CameraSpace;
-layout(location = 1) out vec3 lightDirection_CameraSpace[MaxLights];
-layout(location = 4) flat out vec4 lightColors[MaxLights];
+layout(location = 0) flat out vec4 instanceColor;
+layout(location = 1) out vec3 vertexNormal_CameraSpace;
+layout(location = 2) out vec3 vertexPosition_CameraSpace;
 out gl_PerVertex
 {
     vec4 gl_Position;
 };
 
+vec3 OctahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 void main()
 {
-    mat4 MVP = dynamicMatrices.MVP;
-    mat4 M = dynamicMatrices.M;
-    mat4 V = matrices.view;
-    mat4 P = matrices.projection;
+    InstanceData instance = instances[gl_InstanceIndex];
+    mat4 M = instance.M;
+    mat4 V = frame.view;
+    mat4 P = frame.projection;
 
-    gl_Position = MVP * vec4(vertexPosition_ModelSpace, 1.0);
-    
-    vec3 vertexPosition_CameraSpace = (V * M * vec4(vertexPosition_ModelSpace, 1)).xyz;
-    vec3 eyeDirection_CameraSpace = vec3(0, 0, 0) - vertexPosition_CameraSpace;
+    vec4 position_CameraSpace = V * M * vec4(vertexPosition_ModelSpace, 1.0);
+    gl_Position = P * position_CameraSpace;
+    instanceColor = instance.color;
+    vertexPosition_CameraSpace = position_CameraSpace.xyz;
 
-    for (uint i = 0; i < MaxLights; i++)
+    vec3 normal_ModelSpace = vertexNormal_ModelSpace;
+    if (OctahedralNormals)
     {
-        vec3 lightPosition_CameraSpace = (V * vec4(lights.position_WorldSpace[i])).xyz;
-        lightDirection_CameraSpace[i] = lightPosition_CameraSpace + eyeDirection_CameraSpace;
-        lightColors[i] = lights.color[i];
+        normal_ModelSpace = OctahedralDecode(vertexNormal_ModelSpace.xy);
     }
-
-    vertexNormal_CameraSpace = (V * M * vec4(vertexNormal_ModelSpace, 0)).xyz;
-}
\ No newline at end of file
+    vertexNormal_CameraSpace = (V * M * vec4(normal_ModelSpace, 0)).xyz;
+}
@@ -0,0 +1,148 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "gtest/gtest.h"
+#include "ClusteredLighting.hpp"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <vector>
+#include <random>
+#include <algorithm>
+
+class ClusteredLightingFixture : public ::testing::Test
+{
+public:
+    static constexpr float Width = 1600.f;
+    static constexpr float Height = 900.f;
+    glm::mat4 projection;
+    vka::LightClusters clusters;
+
+    virtual void SetUp()
+    {
+        projection = glm::perspective(glm::radians(60.f), Width / Height, 0.1f, 1000.f);
+        clusters.Build(projection, 0.1f, 1000.f);
+    }
+
+    // the cluster a view space point shades in, found the way the fragment shader does
+    uint32_t ShadedCluster(const glm::vec3 &point)
+    {
+        auto clip = projection * glm::vec4(point, 1.f);
+        auto ndc = glm::vec2(clip) / clip.w;
+        auto fragCoord = (ndc * 0.5f + 0.5f) * glm::vec2(Width, Height);
+        auto parameters = clusters.GetParameters(Width, Height, 0);
+        auto x = std::min(static_cast<uint32_t>(fragCoord.x * parameters.scale.x), vka::ClusterCountX - 1);
+        auto y = std::min(static_cast<uint32_t>(fragCoord.y * parameters.scale.y), vka::ClusterCountY - 1);
+        return vka::LightClusters::ClusterIndex(x, y, clusters.SliceOf(-point.z));
+    }
+
+    bool ClusterHasLight(uint32_t cluster, uint32_t light)
+    {
+        const auto &range = clusters.GetRanges()[cluster];
+        auto begin = clusters.GetIndices().begin() + range.offset;
+        return std::find(begin, begin + range.count, light) != begin + range.count;
+    }
+};
+
+TEST_F(ClusteredLightingFixture, SlicesCoverDepthRange)
+{
+    EXPECT_EQ(0U, clusters.SliceOf(0.1f));
+    EXPECT_EQ(vka::ClusterCountZ - 1, clusters.SliceOf(999.f));
+    for (uint32_t slice = 0; slice < vka::ClusterCountZ; ++slice)
+    {
+        auto middle = (clusters.SliceDepth(slice) + clusters.SliceDepth(slice + 1)) * 0.5f;
+        EXPECT_EQ(slice, clusters.SliceOf(middle));
+    }
+    EXPECT_NEAR(1000.f, clusters.SliceDepth(vka::ClusterCountZ), 0.01f);
+}
+
+TEST_F(ClusteredLightingFixture, EveryLitPointFindsItsLight)
+{
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    std::uniform_real_distribution<float> depth(0.5f, 200.f);
+    std::uniform_real_distribution<float> radius(0.1f, 20.f);
+    std::vector<glm::vec4> lights;
+    for (auto i = 0; i < 300; ++i)
+    {
+        auto z = depth(random);
+        lights.emplace_back(unit(random) * z, unit(random) * z * 0.6f, -z, radius(random));
+    }
+    clusters.Assign(lights);
+
+    auto tested = 0;
+    for (uint32_t light = 0; light < lights.size(); ++light)
+    {
+        for (auto sample = 0; sample < 200; ++sample)
+        {
+            auto offset = glm::vec3(unit(random), unit(random), unit(random));
+            if (glm::length(offset) > 1.f)
+            {
+                continue;
+            }
+            auto point = glm::vec3(lights[light]) + offset * lights[light].w;
+            auto clip = projection * glm::vec4(point, 1.f);
+            if (clip.w < 0.1f || glm::abs(clip.x) > clip.w || glm::abs(clip.y) > clip.w)
+            {
+                continue;
+            }
+            ++tested;
+            ASSERT_TRUE(ClusterHasLight(ShadedCluster(point), light));
+        }
+    }
+    EXPECT_GT(tested, 1000);
+}
+
+TEST_F(ClusteredLightingFixture, DistantLightsStayLocal)
+{
+    // a small light far to the left only reaches the left column of tiles
+    std::vector<glm::vec4> lights = { glm::vec4(-45.f, 0.f, -50.f, 1.f) };
+    clusters.Assign(lights);
+    auto lit = 0U;
+    for (uint32_t cluster = 0; cluster < vka::ClusterCount; ++cluster)
+    {
+        if (clusters.GetRanges()[cluster].count > 0)
+        {
+            ++lit;
+            EXPECT_LT(cluster % vka::ClusterCountX, 3U);
+        }
+    }
+    EXPECT_GT(lit, 0U);
+    EXPECT_LT(lit, 20U);
+    EXPECT_EQ(lit, clusters.GetIndices().size());
+}
+
+TEST_F(ClusteredLightingFixture, LightsOutsideDepthRangeAreSkipped)
+{
+    std::vector<glm::vec4> lights = {
+        glm::vec4(0.f, 0.f, 10.f, 5.f),
+        glm::vec4(0.f, 0.f, -2000.f, 5.f),
+        glm::vec4(0.f, 0.f, -10.f, 0.f) };
+    clusters.Assign(lights);
+    EXPECT_TRUE(clusters.GetIndices().empty());
+    for (const auto &range : clusters.GetRanges())
+    {
+        EXPECT_EQ(0U, range.count);
+    }
+}
+
+TEST_F(ClusteredLightingFixture, IndicesKeepLightOrder)
+{
+    std::vector<glm::vec4> lights;
+    for (auto i = 0; i < 8; ++i)
+    {
+        lights.emplace_back(0.f, 0.f, -20.f, 4.f + i);
+    }
+    clusters.Assign(lights);
+    const auto &range = clusters.GetRanges()[ShadedCluster(glm::vec3(0.f, 0.f, -20.f))];
+    ASSERT_EQ(8U, range.count);
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        EXPECT_EQ(i, clusters.GetIndices()[range.offset + i]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
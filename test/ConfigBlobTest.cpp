@@ -0,0 +1,98 @@
+#include "gtest/gtest.h"
+#include "ConfigBlob.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <chrono>
+
+class ConfigBlobFixture : public ::testing::Test
+{
+public:
+    std::filesystem::path directory;
+
+    virtual void SetUp()
+    {
+        directory = std::filesystem::temp_directory_path() / "ConfigBlobTest";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+    }
+
+    virtual void TearDown()
+    {
+        std::filesystem::remove_all(directory);
+    }
+
+    std::string Write(const std::string &name, const vka::json &config)
+    {
+        auto path = (directory / name).string();
+        std::ofstream(path) << config.dump();
+        return path;
+    }
+
+    static vka::json ShaderStage()
+    {
+        return {
+            {"$schema", "https://example.com/schema/shaderStageConfig.schema.json"},
+            {"stage", 1},
+            {"name", "main"},
+            {"module", {{"path", "shaders/2D/vert.spv"}}},
+            {"specializationMapEntries", vka::json::array()}};
+    }
+};
+
+TEST_F(ConfigBlobFixture, validation_reports_missing_keys)
+{
+    EXPECT_TRUE(vka::ValidateConfig(ShaderStage()).empty());
+    EXPECT_TRUE(vka::ValidateConfig({{"FramesInFlight", 2}}).empty());
+
+    auto config = ShaderStage();
+    config.erase("module");
+    auto problems = vka::ValidateConfig(config);
+    ASSERT_EQ(1U, problems.size());
+    EXPECT_NE(std::string::npos, problems[0].find("module"));
+
+    config["$schema"] = "unknown.schema.json";
+    EXPECT_FALSE(vka::ValidateConfig(config).empty());
+    EXPECT_FALSE(vka::ValidateConfig(vka::json::array()).empty());
+}
+
+TEST_F(ConfigBlobFixture, compiled_blob_round_trips)
+{
+    auto path = Write("vertexShader.json", ShaderStage());
+    EXPECT_TRUE(vka::CompileConfig(path).empty());
+    ASSERT_TRUE(std::filesystem::exists(vka::ConfigBlobPath(path)));
+
+    // the blob alone is enough once the JSON is gone
+    std::filesystem::remove(path);
+    EXPECT_EQ(ShaderStage(), vka::LoadConfig(path));
+}
+
+TEST_F(ConfigBlobFixture, invalid_configs_are_not_compiled)
+{
+    auto config = ShaderStage();
+    config.erase("stage");
+    auto path = Write("broken.json", config);
+    EXPECT_FALSE(vka::CompileConfig(path).empty());
+    EXPECT_FALSE(std::filesystem::exists(vka::ConfigBlobPath(path)));
+    EXPECT_EQ(config, vka::LoadConfig(path));
+}
+
+TEST_F(ConfigBlobFixture, edited_json_wins_over_stale_blob)
+{
+    auto path = Write("vertexShader.json", ShaderStage());
+    EXPECT_TRUE(vka::CompileConfig(path).empty());
+
+    auto edited = ShaderStage();
+    edited["name"] = "mainEdited";
+    Write("vertexShader.json", edited);
+    std::filesystem::last_write_time(path,
+        std::filesystem::last_write_time(vka::ConfigBlobPath(path)) + std::chrono::seconds(1));
+    EXPECT_EQ(edited, vka::LoadConfig(path));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,155 @@
+#include "gtest/gtest.h"
+#include "DescriptorAllocator.hpp"
+
+#include <vector>
+
+namespace
+{
+    nlohmann::json Layout(std::vector<std::pair<int, int>> bindings)
+    {
+        auto layout = nlohmann::json::object();
+        layout["bindings"] = nlohmann::json::array();
+        for (const auto& [type, count] : bindings)
+        {
+            layout["bindings"].push_back({ { "descriptorType", type }, { "descriptorCount", count } });
+        }
+        return layout;
+    }
+
+    uint32_t CountOf(const std::vector<VkDescriptorPoolSize>& sizes, VkDescriptorType type)
+    {
+        for (const auto& size : sizes)
+        {
+            if (size.type == type)
+            {
+                return size.descriptorCount;
+            }
+        }
+        return 0;
+    }
+}
+
+TEST(DescriptorAllocator, pool_sizes_sum_types_across_layouts)
+{
+    auto a = Layout({ { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 }, { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4 } });
+    auto b = Layout({ { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 } });
+    auto sizes = vka::DescriptorPoolSizes({ a, b }, 8);
+    EXPECT_EQ(sizes.size(), 2U);
+    EXPECT_EQ(CountOf(sizes, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER), 24U);
+    EXPECT_EQ(CountOf(sizes, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE), 32U);
+}
+
+struct TemplateData
+{
+    VkDescriptorBufferInfo buffers[2];
+    VkDescriptorImageInfo image;
+};
+
+TEST(DescriptorAllocator, template_writes_read_infos_at_offsets)
+{
+    std::vector<VkDescriptorUpdateTemplateEntry> entries(2);
+    entries[0].dstBinding = 0;
+    entries[0].dstArrayElement = 0;
+    entries[0].descriptorCount = 2;
+    entries[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    entries[0].offset = offsetof(TemplateData, buffers);
+    entries[0].stride = sizeof(VkDescriptorBufferInfo);
+    entries[1].dstBinding = 3;
+    entries[1].dstArrayElement = 5;
+    entries[1].descriptorCount = 1;
+    entries[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    entries[1].offset = offsetof(TemplateData, image);
+    entries[1].stride = sizeof(VkDescriptorImageInfo);
+
+    TemplateData data = {};
+    data.buffers[0].offset = 16;
+    data.buffers[1].offset = 32;
+    data.image.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    auto set = reinterpret_cast<VkDescriptorSet>(uintptr_t(0x1000));
+
+    std::vector<VkWriteDescriptorSet> writes;
+    std::vector<VkDescriptorImageInfo> imageInfos;
+    std::vector<VkDescriptorBufferInfo> bufferInfos;
+    std::vector<VkBufferView> texelBufferViews;
+    vka::TemplateWrites(entries, set, &data, writes, imageInfos, bufferInfos, texelBufferViews);
+
+    ASSERT_EQ(writes.size(), 2U);
+    EXPECT_EQ(writes[0].dstSet, set);
+    EXPECT_EQ(writes[0].descriptorCount, 2U);
+    ASSERT_NE(writes[0].pBufferInfo, nullptr);
+    EXPECT_EQ(writes[0].pBufferInfo[0].offset, 16U);
+    EXPECT_EQ(writes[0].pBufferInfo[1].offset, 32U);
+    EXPECT_EQ(writes[0].pImageInfo, nullptr);
+
+    EXPECT_EQ(writes[1].dstBinding, 3U);
+    EXPECT_EQ(writes[1].dstArrayElement, 5U);
+    ASSERT_NE(writes[1].pImageInfo, nullptr);
+    EXPECT_EQ(writes[1].pImageInfo->imageLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+TEST(DescriptorAllocator, template_writes_reuse_scratch)
+{
+    std::vector<VkDescriptorUpdateTemplateEntry> entries(1);
+    entries[0].descriptorCount = 1;
+    entries[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    entries[0].stride = sizeof(VkDescriptorBufferInfo);
+    VkDescriptorBufferInfo info = {};
+
+    std::vector<VkWriteDescriptorSet> writes;
+    std::vector<VkDescriptorImageInfo> imageInfos;
+    std::vector<VkDescriptorBufferInfo> bufferInfos;
+    std::vector<VkBufferView> texelBufferViews;
+    for (auto i = 0; i < 3; ++i)
+    {
+        info.range = 64 * (i + 1);
+        vka::TemplateWrites(entries, VK_NULL_HANDLE, &info, writes, imageInfos, bufferInfos, texelBufferViews);
+    }
+    ASSERT_EQ(writes.size(), 1U);
+    EXPECT_EQ(bufferInfos.size(), 1U);
+    EXPECT_EQ(writes[0].pBufferInfo->range, 192U);
+}
+
+TEST(DescriptorAllocator, template_writes_skip_empty_entries)
+{
+    struct TemplateData
+    {
+        VkDescriptorBufferInfo first;
+        VkDescriptorBufferInfo second;
+    };
+    std::vector<VkDescriptorUpdateTemplateEntry> entries(3);
+    entries[0].dstBinding = 0;
+    entries[0].descriptorCount = 1;
+    entries[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    entries[0].offset = offsetof(TemplateData, first);
+    entries[0].stride = sizeof(VkDescriptorBufferInfo);
+    entries[1].dstBinding = 1;
+    entries[1].descriptorCount = 0;
+    entries[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    entries[2].dstBinding = 2;
+    entries[2].descriptorCount = 1;
+    entries[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    entries[2].offset = offsetof(TemplateData, second);
+    entries[2].stride = sizeof(VkDescriptorBufferInfo);
+
+    TemplateData data = {};
+    data.first.range = 64;
+    data.second.range = 128;
+
+    std::vector<VkWriteDescriptorSet> writes;
+    std::vector<VkDescriptorImageInfo> imageInfos;
+    std::vector<VkDescriptorBufferInfo> bufferInfos;
+    std::vector<VkBufferView> texelBufferViews;
+    vka::TemplateWrites(entries, VK_NULL_HANDLE, &data, writes, imageInfos, bufferInfos, texelBufferViews);
+
+    ASSERT_EQ(writes.size(), 2U);
+    EXPECT_EQ(writes[0].dstBinding, 0U);
+    EXPECT_EQ(writes[0].pBufferInfo->range, 64U);
+    EXPECT_EQ(writes[1].dstBinding, 2U);
+    EXPECT_EQ(writes[1].pBufferInfo->range, 128U);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,92 @@
+#include "gtest/gtest.h"
+#include "DrawQueue.hpp"
+
+#include <vector>
+#include <random>
+#include <algorithm>
+
+TEST(DrawQueue, key_fields_round_trip)
+{
+    vka::DrawKeyFields fields = { 3, 200, 4000, 65535, 12345 };
+    auto decoded = vka::DecodeDrawKey(vka::EncodeDrawKey(fields));
+    EXPECT_EQ(decoded.layer, 3U);
+    EXPECT_EQ(decoded.pipeline, 200U);
+    EXPECT_EQ(decoded.material, 4000U);
+    EXPECT_EQ(decoded.mesh, 65535U);
+    EXPECT_EQ(decoded.depth, 12345U);
+}
+
+TEST(DrawQueue, state_outranks_depth)
+{
+    auto nearOther = vka::EncodeDrawKey({ 0, 1, 0, 0, 0 });
+    auto farFirst = vka::EncodeDrawKey({ 0, 0, 0, 0, vka::DrawKeyMaxDepth });
+    EXPECT_LT(farFirst, nearOther);
+}
+
+TEST(DrawQueue, depth_key_orders_by_distance)
+{
+    EXPECT_LT(vka::DepthKey(0.5f, false), vka::DepthKey(2.f, false));
+    EXPECT_LT(vka::DepthKey(2.f, false), vka::DepthKey(1000.f, false));
+    EXPECT_GT(vka::DepthKey(0.5f, true), vka::DepthKey(2.f, true));
+    EXPECT_EQ(vka::DepthKey(-1.f, false), vka::DepthKey(0.f, false));
+}
+
+TEST(DrawQueue, radix_sort_matches_stable_sort)
+{
+    vka::ThreadPool pool(4);
+    std::mt19937_64 random(7);
+    std::vector<vka::DrawPacket> packets;
+    for (uint32_t i = 0; i < 20000; ++i)
+    {
+        // few distinct keys, so stability is visible
+        packets.push_back({ vka::EncodeDrawKey({ 0, uint32_t(random() % 3), uint32_t(random() % 5), 0, uint32_t(random() % 7) }), i });
+    }
+    auto expected = packets;
+    std::stable_sort(expected.begin(), expected.end(),
+        [](const vka::DrawPacket& a, const vka::DrawPacket& b) { return a.key < b.key; });
+
+    std::vector<vka::DrawPacket> scratch;
+    vka::RadixSortDrawPackets(pool, packets, scratch);
+    ASSERT_EQ(packets.size(), expected.size());
+    for (size_t i = 0; i < packets.size(); ++i)
+    {
+        EXPECT_EQ(packets[i].key, expected[i].key);
+        EXPECT_EQ(packets[i].index, expected[i].index);
+    }
+}
+
+TEST(DrawQueue, radix_sort_handles_full_width_keys)
+{
+    vka::ThreadPool pool(2);
+    std::mt19937_64 random(11);
+    std::vector<vka::DrawPacket> packets;
+    for (uint32_t i = 0; i < 5000; ++i)
+    {
+        packets.push_back({ random(), i });
+    }
+    std::vector<vka::DrawPacket> scratch;
+    vka::RadixSortDrawPackets(pool, packets, scratch);
+    EXPECT_TRUE(std::is_sorted(packets.begin(), packets.end(),
+        [](const vka::DrawPacket& a, const vka::DrawPacket& b) { return a.key < b.key; }));
+}
+
+TEST(DrawQueue, radix_sort_small_inputs)
+{
+    vka::ThreadPool pool(2);
+    std::vector<vka::DrawPacket> scratch;
+    std::vector<vka::DrawPacket> empty;
+    vka::RadixSortDrawPackets(pool, empty, scratch);
+    EXPECT_TRUE(empty.empty());
+
+    std::vector<vka::DrawPacket> packets = { { 5, 0 }, { 1, 1 }, { 5, 2 } };
+    vka::RadixSortDrawPackets(pool, packets, scratch);
+    EXPECT_EQ(packets[0].index, 1U);
+    EXPECT_EQ(packets[1].index, 0U);
+    EXPECT_EQ(packets[2].index, 2U);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,64 @@
+#include "gtest/gtest.h"
+#include "FramePacer.hpp"
+
+#include <chrono>
+
+using namespace std::chrono_literals;
+
+TEST(FramePacer, runs_one_update_per_elapsed_step)
+{
+    FramePacer pacer(20ms);
+    auto start = TimePoint_ns(1s);
+    pacer.Start(start);
+
+    pacer.BeginFrame(start + 50ms);
+    auto updates = 0;
+    while (pacer.StepUpdate())
+    {
+        ++updates;
+    }
+    EXPECT_EQ(2, updates);
+    EXPECT_EQ(start + 40ms, pacer.GetSimulationTime());
+    EXPECT_FLOAT_EQ(0.5f, pacer.GetInterpolation());
+    EXPECT_EQ(start + 60ms, pacer.GetNextUpdateTime());
+
+    // the leftover carries into the next frame
+    pacer.BeginFrame(start + 60ms);
+    EXPECT_TRUE(pacer.StepUpdate());
+    EXPECT_FALSE(pacer.StepUpdate());
+    EXPECT_FLOAT_EQ(0.f, pacer.GetInterpolation());
+}
+
+TEST(FramePacer, long_stalls_are_clamped)
+{
+    FramePacer pacer(10ms, 0ns, 3);
+    auto start = TimePoint_ns(1s);
+    pacer.Start(start);
+
+    pacer.BeginFrame(start + 1s);
+    auto updates = 0;
+    while (pacer.StepUpdate())
+    {
+        ++updates;
+    }
+    EXPECT_EQ(3, updates);
+    // simulation time skips the dropped stretch instead of falling behind
+    EXPECT_EQ(start + 1s, pacer.GetSimulationTime());
+}
+
+TEST(FramePacer, end_frame_waits_for_target)
+{
+    FramePacer pacer(10ms, 5ms);
+    auto start = NowNanoseconds();
+    pacer.Start(start);
+    pacer.BeginFrame(start);
+    pacer.EndFrame();
+    EXPECT_GE(NowNanoseconds(), pacer.GetFrameDeadline());
+    EXPECT_EQ(start + 5ms, pacer.GetFrameDeadline());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
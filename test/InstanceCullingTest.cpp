@@ -0,0 +1,98 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "gtest/gtest.h"
+#include "InstanceCulling.hpp"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <vector>
+#include <random>
+
+class InstanceCullingFixture : public ::testing::Test
+{
+public:
+    vka::Frustum frustum;
+
+    virtual void SetUp()
+    {
+        auto projection = glm::perspective(glm::radians(60.f), 1.f, 0.1f, 100.f);
+        auto view = glm::lookAt(glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+        frustum = vka::FrustumFromMatrix(projection * view);
+    }
+};
+
+TEST_F(InstanceCullingFixture, MatchesScalarTest)
+{
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> position(-60.f, 60.f);
+    std::uniform_real_distribution<float> size(0.f, 5.f);
+    vka::InstanceBounds bounds;
+    std::vector<glm::vec4> spheres;
+    // not a multiple of eight, so the padded tail is exercised
+    for (auto i = 0; i < 1003; ++i)
+    {
+        glm::vec4 sphere(position(random), position(random), position(random), size(random));
+        spheres.push_back(sphere);
+        bounds.Push(glm::vec3(sphere), sphere.w);
+    }
+
+    std::vector<uint8_t> visible;
+    auto visibleCount = vka::CullSpheres(frustum, bounds, visible);
+    ASSERT_EQ(spheres.size(), visible.size());
+    size_t expectedCount = 0;
+    for (size_t i = 0; i < spheres.size(); ++i)
+    {
+        auto expected = vka::SphereInFrustum(frustum, glm::vec3(spheres[i]), spheres[i].w);
+        EXPECT_EQ(expected, visible[i] != 0) << "sphere " << i;
+        expectedCount += expected;
+    }
+    EXPECT_EQ(expectedCount, visibleCount);
+    EXPECT_GT(visibleCount, 0U);
+    EXPECT_LT(visibleCount, spheres.size());
+}
+
+TEST_F(InstanceCullingFixture, PaddingIsNeverVisible)
+{
+    vka::InstanceBounds bounds;
+    bounds.Push(glm::vec3(0.f, 0.f, -10.f), 1.f);
+    std::vector<uint8_t> visible;
+    EXPECT_EQ(1U, vka::CullSpheres(frustum, bounds, visible));
+    EXPECT_EQ(8U, bounds.radius.size());
+    EXPECT_EQ(1U, bounds.size());
+
+    // even a frustum that accepts every point rejects the padding
+    auto everything = vka::Frustum{};
+    everything.planes.fill(glm::vec4(0.f, 0.f, 0.f, 1.f));
+    EXPECT_EQ(0x1U, vka::SpheresInFrustum8(everything,
+        bounds.centerX.data(), bounds.centerY.data(), bounds.centerZ.data(), bounds.radius.data()));
+}
+
+TEST_F(InstanceCullingFixture, ClearResetsCount)
+{
+    vka::InstanceBounds bounds;
+    bounds.Push(glm::vec3(0.f), 1.f);
+    bounds.Pad();
+    bounds.Clear();
+    std::vector<uint8_t> visible;
+    EXPECT_EQ(0U, vka::CullSpheres(frustum, bounds, visible));
+    EXPECT_TRUE(visible.empty());
+}
+
+TEST(TransformSphere, ScalesByLargestAxis)
+{
+    auto model = glm::translate(glm::mat4(1.f), glm::vec3(5.f, 0.f, 0.f));
+    model = glm::scale(model, glm::vec3(1.f, 3.f, 2.f));
+    glm::vec3 center;
+    float radius;
+    vka::TransformSphere(model, glm::vec3(1.f, 1.f, 0.f), 2.f, center, radius);
+    EXPECT_FLOAT_EQ(6.f, center.x);
+    EXPECT_FLOAT_EQ(3.f, center.y);
+    EXPECT_FLOAT_EQ(0.f, center.z);
+    EXPECT_FLOAT_EQ(6.f, radius);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,136 @@
+#include "gtest/gtest.h"
+#include "InternCache.hpp"
+
+#include <vector>
+
+namespace
+{
+    VkDescriptorSetLayoutBinding Binding(uint32_t binding, VkDescriptorType type)
+    {
+        VkDescriptorSetLayoutBinding layoutBinding = {};
+        layoutBinding.binding = binding;
+        layoutBinding.descriptorType = type;
+        layoutBinding.descriptorCount = 1;
+        layoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        return layoutBinding;
+    }
+
+    vka::DescriptorSetLayoutKey SetLayoutKey(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+    {
+        VkDescriptorSetLayoutCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        createInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        createInfo.pBindings = bindings.data();
+        return vka::DescriptorSetLayoutKey(createInfo);
+    }
+
+    vka::PipelineLayoutKey PipelineLayoutKey(const std::vector<VkPushConstantRange>& ranges)
+    {
+        VkPipelineLayoutCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        createInfo.pushConstantRangeCount = static_cast<uint32_t>(ranges.size());
+        createInfo.pPushConstantRanges = ranges.data();
+        return vka::PipelineLayoutKey(createInfo);
+    }
+}
+
+TEST(InternCache, binding_order_does_not_change_set_layout_key)
+{
+    auto a = SetLayoutKey({ Binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER), Binding(1, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE) });
+    auto b = SetLayoutKey({ Binding(1, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE), Binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) });
+    EXPECT_TRUE(a == b);
+    EXPECT_EQ(a.Hash(), b.Hash());
+
+    auto c = SetLayoutKey({ Binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER), Binding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE) });
+    EXPECT_FALSE(a == c);
+}
+
+TEST(InternCache, immutable_samplers_ignored_for_non_sampler_bindings)
+{
+    auto sampler = reinterpret_cast<VkSampler>(uintptr_t(0x1000));
+    auto withSampler = Binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    withSampler.pImmutableSamplers = &sampler;
+    auto a = SetLayoutKey({ withSampler });
+    auto b = SetLayoutKey({ Binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) });
+    EXPECT_TRUE(a == b);
+
+    auto combined = Binding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+    auto plain = SetLayoutKey({ combined });
+    combined.pImmutableSamplers = &sampler;
+    EXPECT_FALSE(SetLayoutKey({ combined }) == plain);
+}
+
+TEST(InternCache, binding_flags_change_set_layout_key)
+{
+    std::vector<VkDescriptorSetLayoutBinding> bindings = { Binding(0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE) };
+    VkDescriptorBindingFlagsEXT flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT;
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT flagsInfo = {};
+    flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+    flagsInfo.bindingCount = 1;
+    flagsInfo.pBindingFlags = &flags;
+    VkDescriptorSetLayoutCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    createInfo.pNext = &flagsInfo;
+    createInfo.bindingCount = 1;
+    createInfo.pBindings = bindings.data();
+
+    auto flagged = vka::DescriptorSetLayoutKey(createInfo);
+    EXPECT_FALSE(flagged == SetLayoutKey(bindings));
+    EXPECT_TRUE(flagged == vka::DescriptorSetLayoutKey(createInfo));
+}
+
+TEST(InternCache, push_constant_order_does_not_change_pipeline_layout_key)
+{
+    VkPushConstantRange vertex = { VK_SHADER_STAGE_VERTEX_BIT, 0, 64 };
+    VkPushConstantRange fragment = { VK_SHADER_STAGE_FRAGMENT_BIT, 64, 16 };
+    auto a = PipelineLayoutKey({ vertex, fragment });
+    auto b = PipelineLayoutKey({ fragment, vertex });
+    EXPECT_TRUE(a == b);
+    EXPECT_EQ(a.Hash(), b.Hash());
+
+    fragment.size = 32;
+    EXPECT_FALSE(a == PipelineLayoutKey({ vertex, fragment }));
+}
+
+TEST(InternCache, sampler_key_ignores_pnext)
+{
+    VkSamplerCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    createInfo.magFilter = VK_FILTER_LINEAR;
+    createInfo.maxLod = 8.0f;
+    auto a = vka::SamplerKey(createInfo);
+    int extension = 0;
+    createInfo.pNext = &extension;
+    EXPECT_TRUE(a == vka::SamplerKey(createInfo));
+    createInfo.maxAnisotropy = 16.0f;
+    EXPECT_FALSE(a == vka::SamplerKey(createInfo));
+}
+
+TEST(InternCache, handles_are_reference_counted)
+{
+    vka::InternCache<vka::PipelineLayoutKey, VkPipelineLayout> cache;
+    auto key = PipelineLayoutKey({ { VK_SHADER_STAGE_VERTEX_BIT, 0, 64 } });
+    auto handle = reinterpret_cast<VkPipelineLayout>(uintptr_t(0x2000));
+
+    EXPECT_EQ(cache.Acquire(key), VkPipelineLayout(VK_NULL_HANDLE));
+    cache.Insert(key, handle);
+    EXPECT_EQ(cache.Acquire(key), handle);
+    EXPECT_EQ(cache.GetReferenceCount(handle), 2U);
+
+    EXPECT_FALSE(cache.Release(handle));
+    EXPECT_TRUE(cache.Release(handle));
+    EXPECT_EQ(cache.size(), 0U);
+    EXPECT_EQ(cache.Acquire(key), VkPipelineLayout(VK_NULL_HANDLE));
+}
+
+TEST(InternCache, unknown_handles_are_released)
+{
+    vka::InternCache<vka::SamplerKey, VkSampler> cache;
+    EXPECT_TRUE(cache.Release(reinterpret_cast<VkSampler>(uintptr_t(0x3000))));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
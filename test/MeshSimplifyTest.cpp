@@ -0,0 +1,129 @@
+#include "gtest/gtest.h"
+#include "MeshSimplify.hpp"
+#include "glm/glm.hpp"
+#include "glm/gtc/constants.hpp"
+
+#include <vector>
+#include <cmath>
+
+class MeshSimplifyFixture : public ::testing::Test
+{
+public:
+    std::vector<glm::vec3> spherePositions;
+    std::vector<glm::vec3> sphereNormals;
+    std::vector<uint16_t> sphereIndices;
+
+    std::vector<glm::vec3> gridPositions;
+    std::vector<glm::vec3> gridNormals;
+    std::vector<uint16_t> gridIndices;
+
+    virtual void SetUp()
+    {
+        // latitude/longitude sphere with shared vertices, the poles are left open
+        // so no zero area triangles are generated
+        const auto rings = 15U;
+        const auto segments = 32U;
+        for (auto r = 0U; r <= rings; ++r)
+        {
+            auto theta = glm::pi<float>() * (r + 1) / (rings + 2);
+            for (auto s = 0U; s < segments; ++s)
+            {
+                auto phi = glm::two_pi<float>() * s / segments;
+                auto n = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+                spherePositions.push_back(n);
+                sphereNormals.push_back(n);
+            }
+        }
+        for (auto r = 0U; r < rings; ++r)
+        {
+            for (auto s = 0U; s < segments; ++s)
+            {
+                uint16_t a = r * segments + s;
+                uint16_t b = r * segments + (s + 1) % segments;
+                uint16_t c = (r + 1) * segments + s;
+                uint16_t d = (r + 1) * segments + (s + 1) % segments;
+                sphereIndices.insert(sphereIndices.end(), {a, c, b, b, c, d});
+            }
+        }
+
+        // flat 8x8 quad grid in the xy plane
+        const auto side = 9U;
+        for (auto y = 0U; y < side; ++y)
+        {
+            for (auto x = 0U; x < side; ++x)
+            {
+                gridPositions.push_back(glm::vec3(x, y, 0.f));
+                gridNormals.push_back(glm::vec3(0.f, 0.f, 1.f));
+            }
+        }
+        for (auto y = 0U; y + 1 < side; ++y)
+        {
+            for (auto x = 0U; x + 1 < side; ++x)
+            {
+                uint16_t a = y * side + x;
+                uint16_t b = a + 1;
+                uint16_t c = a + side;
+                uint16_t d = c + 1;
+                gridIndices.insert(gridIndices.end(), {a, b, c, b, d, c});
+            }
+        }
+    }
+};
+
+TEST_F(MeshSimplifyFixture, reaches_target)
+{
+    auto target = sphereIndices.size() / 4;
+    float error = 0.f;
+    auto simplified = vka::SimplifyMesh(spherePositions, sphereNormals, sphereIndices, target, 0.5f, &error);
+    EXPECT_LE(simplified.size(), sphereIndices.size() / 2);
+    EXPECT_EQ(0U, simplified.size() % 3);
+    EXPECT_GT(error, 0.f);
+    EXPECT_LT(error, 0.5f);
+    for (auto index : simplified)
+    {
+        EXPECT_LT(index, spherePositions.size());
+    }
+}
+
+TEST_F(MeshSimplifyFixture, respects_error_limit)
+{
+    auto simplified = vka::SimplifyMesh(spherePositions, sphereNormals, sphereIndices, 0, 0.f);
+    EXPECT_EQ(sphereIndices.size(), simplified.size());
+}
+
+TEST_F(MeshSimplifyFixture, flat_interior_collapses_without_flips)
+{
+    float error = 1.f;
+    auto simplified = vka::SimplifyMesh(gridPositions, gridNormals, gridIndices, 0, 0.01f, &error);
+    EXPECT_LT(simplified.size(), gridIndices.size());
+    EXPECT_FLOAT_EQ(0.f, error);
+    for (auto i = 0U; i < simplified.size(); i += 3)
+    {
+        auto n = glm::cross(
+            gridPositions[simplified[i + 1]] - gridPositions[simplified[i]],
+            gridPositions[simplified[i + 2]] - gridPositions[simplified[i]]);
+        EXPECT_GT(n.z, 0.f);
+    }
+}
+
+TEST_F(MeshSimplifyFixture, split_normals_stay_on_matching_wedge)
+{
+    // duplicate every grid vertex so each triangle references its own copy
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<uint16_t> indices;
+    for (auto index : gridIndices)
+    {
+        indices.push_back(static_cast<uint16_t>(positions.size()));
+        positions.push_back(gridPositions[index]);
+        normals.push_back(gridNormals[index]);
+    }
+    auto simplified = vka::SimplifyMesh(positions, normals, indices, 0, 0.01f);
+    EXPECT_LT(simplified.size(), indices.size());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
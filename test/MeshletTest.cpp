@@ -0,0 +1,162 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "gtest/gtest.h"
+#include "Meshlet.hpp"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <vector>
+#include <array>
+#include <set>
+#include <algorithm>
+
+class MeshletFixture : public ::testing::Test
+{
+public:
+    vka::Mesh grid;
+
+    virtual void SetUp()
+    {
+        // flat 8x8 quad grid facing +z, 128 triangles is more than one cluster
+        const auto side = 9U;
+        for (auto y = 0U; y < side; ++y)
+        {
+            for (auto x = 0U; x < side; ++x)
+            {
+                grid.positions.push_back(glm::vec3(x, y, 0.f));
+                grid.normals.push_back(glm::vec3(0.f, 0.f, 1.f));
+            }
+        }
+        for (auto y = 0U; y + 1 < side; ++y)
+        {
+            for (auto x = 0U; x + 1 < side; ++x)
+            {
+                uint8_t a = y * side + x;
+                uint8_t b = a + 1;
+                uint8_t c = a + side;
+                uint8_t d = c + 1;
+                grid.indices.insert(grid.indices.end(), {a, b, c, b, d, c});
+            }
+        }
+        grid.firstIndex = 100;
+        grid.firstVertex = 0;
+    }
+
+    static std::multiset<std::array<uint8_t, 3>> Triangles(const std::vector<uint8_t> &indices)
+    {
+        std::multiset<std::array<uint8_t, 3>> triangles;
+        for (auto i = 0U; i + 2 < indices.size(); i += 3)
+        {
+            triangles.insert({indices[i], indices[i + 1], indices[i + 2]});
+        }
+        return triangles;
+    }
+
+    static size_t VisibleIndexCount(const std::vector<vka::IndexRange> &ranges)
+    {
+        size_t count = 0;
+        for (const auto &range : ranges)
+        {
+            count += range.second;
+        }
+        return count;
+    }
+
+    glm::mat4 ViewProjection(glm::vec3 eye, glm::vec3 target)
+    {
+        auto projection = glm::perspective(glm::radians(60.f), 1.f, 0.1f, 100.f);
+        return projection * glm::lookAt(eye, target, glm::vec3(0.f, -1.f, 0.f));
+    }
+};
+
+TEST_F(MeshletFixture, clusters_respect_limits_and_keep_triangles)
+{
+    auto original = Triangles(grid.indices);
+    auto indices = grid.indices;
+    auto meshlets = vka::BuildMeshlets(grid.positions, indices, 16, 20);
+    EXPECT_EQ(original, Triangles(indices));
+
+    size_t expectedFirst = 0;
+    for (const auto &meshlet : meshlets)
+    {
+        EXPECT_EQ(expectedFirst, meshlet.firstIndex);
+        expectedFirst += meshlet.indexCount;
+        EXPECT_LE(meshlet.indexCount / 3, 20U);
+        std::set<uint8_t> vertices(
+            indices.begin() + meshlet.firstIndex,
+            indices.begin() + meshlet.firstIndex + meshlet.indexCount);
+        EXPECT_LE(vertices.size(), 16U);
+        for (auto v : vertices)
+        {
+            EXPECT_LE(glm::length(grid.positions[v] - meshlet.center), meshlet.radius + 1e-4f);
+        }
+    }
+    EXPECT_EQ(indices.size(), expectedFirst);
+}
+
+TEST_F(MeshletFixture, small_meshes_are_not_clustered)
+{
+    grid.indices.resize(vka::MeshletMaxTriangles * 3);
+    vka::GenerateMeshlets(grid);
+    EXPECT_TRUE(grid.meshlets.empty());
+}
+
+TEST_F(MeshletFixture, backfacing_clusters_are_culled)
+{
+    vka::GenerateMeshlets(grid);
+    ASSERT_GT(grid.meshlets.size(), 1U);
+
+    auto target = glm::vec3(4.f, 4.f, 0.f);
+    std::vector<vka::IndexRange> ranges;
+    auto front = glm::vec3(4.f, 4.f, 10.f);
+    vka::CullMeshlets(grid, glm::mat4(1.f), ViewProjection(front, target), front, ranges);
+    EXPECT_EQ(grid.indices.size(), VisibleIndexCount(ranges));
+    // surviving clusters are contiguous, so they merge into one range
+    ASSERT_EQ(1U, ranges.size());
+    EXPECT_EQ(grid.firstIndex, ranges[0].first);
+
+    ranges.clear();
+    auto behind = glm::vec3(4.f, 4.f, -10.f);
+    vka::CullMeshlets(grid, glm::mat4(1.f), ViewProjection(behind, target), behind, ranges);
+    EXPECT_EQ(0U, VisibleIndexCount(ranges));
+}
+
+TEST_F(MeshletFixture, clusters_outside_frustum_are_culled)
+{
+    vka::GenerateMeshlets(grid);
+    std::vector<vka::IndexRange> ranges;
+    auto eye = glm::vec3(4.f, 4.f, 10.f);
+    vka::CullMeshlets(grid, glm::mat4(1.f), ViewProjection(eye, glm::vec3(4.f, 4.f, 20.f)), eye, ranges);
+    EXPECT_EQ(0U, VisibleIndexCount(ranges));
+
+    // moving the grid up to the edge of the view leaves only part of it visible
+    ranges.clear();
+    auto model = glm::translate(glm::mat4(1.f), glm::vec3(0.f, 9.f, 0.f));
+    vka::CullMeshlets(grid, model, ViewProjection(eye, glm::vec3(4.f, 4.f, 0.f)), eye, ranges);
+    EXPECT_GT(VisibleIndexCount(ranges), 0U);
+    EXPECT_LT(VisibleIndexCount(ranges), grid.indices.size());
+}
+
+TEST(Frustum, simd_matches_scalar)
+{
+    auto frustum = vka::FrustumFromMatrix(
+        glm::perspective(glm::radians(60.f), 1.f, 0.1f, 100.f) *
+        glm::lookAt(glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f), glm::vec3(0.f, -1.f, 0.f)));
+    std::array<float, 4> x = {0.f, 50.f, 0.f, 3.f};
+    std::array<float, 4> y = {0.f, 0.f, 0.f, 0.f};
+    std::array<float, 4> z = {10.f, 10.f, -5.f, 10.f};
+    std::array<float, 4> r = {1.f, 1.f, 1.f, 0.5f};
+    auto mask = vka::SpheresInFrustum4(frustum, x.data(), y.data(), z.data(), r.data());
+    for (auto i = 0U; i < 4; ++i)
+    {
+        auto scalar = vka::SphereInFrustum(frustum, glm::vec3(x[i], y[i], z[i]), r[i]);
+        EXPECT_EQ(scalar, (mask & (1U << i)) != 0) << i;
+    }
+    EXPECT_EQ(0x9U, mask);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
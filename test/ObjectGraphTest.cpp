@@ -0,0 +1,101 @@
+#include "gtest/gtest.h"
+#include "ObjectGraph.hpp"
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+
+static nlohmann::json GraphJson(size_t vertexCount, std::vector<std::pair<size_t, size_t>> edges)
+{
+    nlohmann::json graphJson;
+    graphJson["vertices"] = nlohmann::json::array();
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        graphJson["vertices"].push_back({{"index", i}, {"vulkanType", i == 0 ? "Device" : "ShaderModule"}, {"path", ""}});
+    }
+    graphJson["edges"] = nlohmann::json::array();
+    for (auto [start, end] : edges)
+    {
+        graphJson["edges"].push_back({{"start", start}, {"end", end}});
+    }
+    return graphJson;
+}
+
+TEST(ObjectGraph, loads_vertices_and_edges)
+{
+    auto graph = vka::LoadObjectGraph(GraphJson(3, {{0, 1}, {1, 2}}));
+    EXPECT_EQ(3U, boost::num_vertices(graph));
+    EXPECT_EQ(2U, boost::num_edges(graph));
+    EXPECT_EQ(vka::VulkanType::Device, graph[0].vulkanType);
+    EXPECT_EQ(vka::VulkanType::ShaderModule, graph[2].vulkanType);
+    EXPECT_THROW(vka::LoadObjectGraph(GraphJson(2, {{0, 5}})), std::runtime_error);
+}
+
+TEST(ObjectGraph, dependencies_finish_before_dependents_start)
+{
+    // diamond below a vertex that is treated as already built
+    std::vector<std::pair<size_t, size_t>> edges = {{0, 1}, {1, 2}, {1, 3}, {2, 4}, {3, 4}, {0, 4}};
+    auto graph = vka::LoadObjectGraph(GraphJson(5, edges));
+    vka::ThreadPool pool(4);
+    std::atomic<int> clock = 0;
+    std::vector<int> started(5, -1);
+    std::vector<int> finished(5, -1);
+    vka::BuildObjectGraph(pool, graph, [](size_t vertex) { return vertex != 0; }, [&](size_t vertex, size_t) {
+        started[vertex] = clock++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        finished[vertex] = clock++;
+    });
+    EXPECT_EQ(-1, started[0]);
+    for (auto [start, end] : edges)
+    {
+        if (start != 0)
+        {
+            EXPECT_LT(finished[start], started[end]) << start << " -> " << end;
+        }
+    }
+}
+
+TEST(ObjectGraph, independent_vertices_overlap)
+{
+    auto graph = vka::LoadObjectGraph(GraphJson(4, {}));
+    vka::ThreadPool pool(4);
+    std::atomic<int> running = 0;
+    std::atomic<int> maxRunning = 0;
+    vka::BuildObjectGraph(pool, graph, [](size_t) { return true; }, [&](size_t, size_t) {
+        auto now = ++running;
+        auto seen = maxRunning.load();
+        while (now > seen && !maxRunning.compare_exchange_weak(seen, now))
+        {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        --running;
+    });
+    EXPECT_GT(maxRunning.load(), 1);
+}
+
+TEST(ObjectGraph, errors_and_cycles_are_reported)
+{
+    auto chain = vka::LoadObjectGraph(GraphJson(3, {{0, 1}, {1, 2}}));
+    vka::ThreadPool pool(2);
+    std::vector<bool> built(3, false);
+    EXPECT_THROW(vka::BuildObjectGraph(pool, chain, [](size_t) { return true; }, [&](size_t vertex, size_t) {
+        if (vertex == 1)
+        {
+            throw std::runtime_error("creation failed");
+        }
+        built[vertex] = true;
+    }), std::runtime_error);
+    EXPECT_TRUE(built[0]);
+    EXPECT_FALSE(built[2]);
+
+    auto cycle = vka::LoadObjectGraph(GraphJson(2, {{0, 1}, {1, 0}}));
+    EXPECT_THROW(vka::BuildObjectGraph(pool, cycle, [](size_t) { return true; }, [](size_t, size_t) {}), std::runtime_error);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,126 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "gtest/gtest.h"
+#include "OcclusionBuffer.hpp"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <vector>
+
+class OcclusionBufferFixture : public ::testing::Test
+{
+public:
+    glm::mat4 viewProjection;
+    // a 4x4 wall facing the camera, two triangles
+    std::vector<glm::vec3> wallPositions = {
+        {-2.f, -2.f, 0.f}, {2.f, -2.f, 0.f}, {2.f, 2.f, 0.f}, {-2.f, 2.f, 0.f}};
+    std::vector<uint8_t> wallIndices = {0, 1, 2, 0, 2, 3};
+
+    virtual void SetUp()
+    {
+        auto projection = glm::perspective(glm::radians(60.f), 1.f, 0.1f, 100.f);
+        auto view = glm::lookAt(glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+        viewProjection = projection * view;
+    }
+
+    glm::mat4 WallAt(float z)
+    {
+        return viewProjection * glm::translate(glm::mat4(1.f), glm::vec3(0.f, 0.f, z));
+    }
+};
+
+TEST_F(OcclusionBufferFixture, RejectsUnalignedWidth)
+{
+    EXPECT_THROW(vka::OcclusionBuffer(30, 16), std::runtime_error);
+    EXPECT_NO_THROW(vka::OcclusionBuffer(32, 16));
+}
+
+TEST_F(OcclusionBufferFixture, PyramidHalvesToOneTexel)
+{
+    vka::OcclusionBuffer buffer(64, 20);
+    EXPECT_EQ(7U, buffer.GetLevelCount());
+    EXPECT_FLOAT_EQ(1.f, buffer.GetDepth(0, 0, 6));
+}
+
+TEST_F(OcclusionBufferFixture, RasterizedDepthMatchesProjection)
+{
+    vka::OcclusionBuffer buffer(64, 64);
+    buffer.RasterizeMesh(WallAt(-5.f), wallPositions, wallIndices);
+    auto clip = viewProjection * glm::vec4(0.f, 0.f, -5.f, 1.f);
+    EXPECT_NEAR(clip.z / clip.w, buffer.GetDepth(32, 32), 1e-4f);
+    // the wall covers a bit under half the view at this distance
+    EXPECT_FLOAT_EQ(1.f, buffer.GetDepth(1, 32));
+    EXPECT_LT(buffer.GetDepth(20, 20), 1.f);
+}
+
+TEST_F(OcclusionBufferFixture, WindingDoesNotMatter)
+{
+    vka::OcclusionBuffer front(32, 32);
+    vka::OcclusionBuffer back(32, 32);
+    std::vector<uint8_t> reversed(wallIndices.rbegin(), wallIndices.rend());
+    front.RasterizeMesh(WallAt(-5.f), wallPositions, wallIndices);
+    back.RasterizeMesh(WallAt(-5.f), wallPositions, reversed);
+    for (size_t y = 0; y < 32; ++y)
+    {
+        for (size_t x = 0; x < 32; ++x)
+        {
+            EXPECT_FLOAT_EQ(front.GetDepth(x, y), back.GetDepth(x, y));
+        }
+    }
+}
+
+TEST_F(OcclusionBufferFixture, SpheresBehindWallAreOccluded)
+{
+    vka::OcclusionBuffer buffer(64, 64);
+    buffer.RasterizeMesh(WallAt(-5.f), wallPositions, wallIndices);
+    buffer.BuildHiZ();
+    EXPECT_TRUE(buffer.IsSphereOccluded(viewProjection, glm::vec3(0.f, 0.f, -20.f), 1.f));
+    // in front of the wall
+    EXPECT_FALSE(buffer.IsSphereOccluded(viewProjection, glm::vec3(0.f, 0.f, -3.f), 0.5f));
+    // intersecting the wall
+    EXPECT_FALSE(buffer.IsSphereOccluded(viewProjection, glm::vec3(0.f, 0.f, -5.f), 0.5f));
+    // behind, but large enough to show around the edges
+    EXPECT_FALSE(buffer.IsSphereOccluded(viewProjection, glm::vec3(0.f, 0.f, -20.f), 10.f));
+    // behind, off to the side of the wall
+    EXPECT_FALSE(buffer.IsSphereOccluded(viewProjection, glm::vec3(8.f, 0.f, -20.f), 1.f));
+    // reaching the near plane
+    EXPECT_FALSE(buffer.IsSphereOccluded(viewProjection, glm::vec3(0.f, 0.f, 0.f), 1.f));
+}
+
+TEST_F(OcclusionBufferFixture, NearPlaneCrossingOccluderIsClipped)
+{
+    // a floor running from behind the camera into the distance
+    std::vector<glm::vec3> floorPositions = {
+        {-50.f, -1.f, 10.f}, {50.f, -1.f, 10.f}, {50.f, -1.f, -90.f}, {-50.f, -1.f, -90.f}};
+    vka::OcclusionBuffer buffer(64, 64);
+    buffer.RasterizeMesh(viewProjection, floorPositions, wallIndices);
+    buffer.BuildHiZ();
+    // the floor fills the half of the view below the horizon
+    auto covered = 0U;
+    for (size_t y = 0; y < 64; ++y)
+    {
+        for (size_t x = 0; x < 64; ++x)
+        {
+            covered += buffer.GetDepth(x, y) < 1.f;
+        }
+    }
+    EXPECT_NEAR(64.f * 32.f, static_cast<float>(covered), 64.f * 2.f);
+    EXPECT_TRUE(buffer.IsSphereOccluded(viewProjection, glm::vec3(0.f, -5.f, -20.f), 1.f));
+    EXPECT_FALSE(buffer.IsSphereOccluded(viewProjection, glm::vec3(0.f, 5.f, -20.f), 1.f));
+}
+
+TEST_F(OcclusionBufferFixture, ClearRestoresFarPlane)
+{
+    vka::OcclusionBuffer buffer(32, 32);
+    buffer.RasterizeMesh(WallAt(-5.f), wallPositions, wallIndices);
+    buffer.Clear();
+    buffer.BuildHiZ();
+    EXPECT_FLOAT_EQ(1.f, buffer.GetDepth(16, 16));
+    EXPECT_FALSE(buffer.IsSphereOccluded(viewProjection, glm::vec3(0.f, 0.f, -20.f), 1.f));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,77 @@
+#include "gtest/gtest.h"
+#include "PipelineCache.hpp"
+
+#include <vector>
+#include <cstring>
+
+class PipelineCacheFixture : public ::testing::Test
+{
+public:
+    VkPhysicalDeviceProperties properties = {};
+
+    virtual void SetUp()
+    {
+        properties.vendorID = 0x10DE;
+        properties.deviceID = 0x1B80;
+        properties.driverVersion = 0x1A2B3C4D;
+        for (auto i = 0U; i < VK_UUID_SIZE; ++i)
+        {
+            properties.pipelineCacheUUID[i] = static_cast<uint8_t>(i * 17);
+        }
+    }
+
+    std::vector<char> Blob(size_t payload = 64)
+    {
+        vka::PipelineCacheHeader header = {};
+        header.headerSize = sizeof(header);
+        header.headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
+        header.vendorID = properties.vendorID;
+        header.deviceID = properties.deviceID;
+        std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+        std::vector<char> data(sizeof(header) + payload, 0);
+        std::memcpy(data.data(), &header, sizeof(header));
+        return data;
+    }
+};
+
+TEST_F(PipelineCacheFixture, matching_header_is_accepted)
+{
+    EXPECT_TRUE(vka::PipelineCacheDataMatches(Blob(), properties));
+    EXPECT_TRUE(vka::PipelineCacheDataMatches(Blob(0), properties));
+}
+
+TEST_F(PipelineCacheFixture, foreign_or_damaged_data_is_rejected)
+{
+    EXPECT_FALSE(vka::PipelineCacheDataMatches({}, properties));
+    auto truncated = Blob();
+    truncated.resize(sizeof(vka::PipelineCacheHeader) - 1);
+    EXPECT_FALSE(vka::PipelineCacheDataMatches(truncated, properties));
+
+    auto otherDevice = properties;
+    otherDevice.deviceID += 1;
+    EXPECT_FALSE(vka::PipelineCacheDataMatches(Blob(), otherDevice));
+
+    auto otherDriver = properties;
+    otherDriver.pipelineCacheUUID[VK_UUID_SIZE - 1] ^= 0xFF;
+    EXPECT_FALSE(vka::PipelineCacheDataMatches(Blob(), otherDriver));
+
+    auto badVersion = Blob();
+    badVersion[4] = 2;
+    EXPECT_FALSE(vka::PipelineCacheDataMatches(badVersion, properties));
+}
+
+TEST_F(PipelineCacheFixture, file_name_identifies_device_and_driver)
+{
+    auto name = vka::PipelineCacheFileName(properties);
+    EXPECT_EQ("pipeline_000010de_00001b80_1a2b3c4d_00112233445566778899aabbccddeeff.cache", name);
+
+    auto updatedDriver = properties;
+    updatedDriver.driverVersion += 1;
+    EXPECT_NE(name, vka::PipelineCacheFileName(updatedDriver));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <memory>
 #include <chrono>
+#include <random>
 
 struct Vec3Test
 {
@@ -105,6 +106,63 @@ TEST_F(QuadTreeFixture, touch_all_objects)
     }
 }
 
+TEST_F(QuadTreeFixture, query_matches_brute_force)
+{
+    std::mt19937 random(3);
+    std::uniform_real_distribution<double> position(-1100.0, 1100.0);
+    std::uniform_real_distribution<double> size(0.0, 60.0);
+    for (auto& obj : objVector)
+    {
+        obj.boundingBox = QT::Rect(position(random), position(random), size(random), size(random));
+        testTree.InsertOrUpdate(&obj);
+    }
+    // move half of them, some out of the tree's region
+    for (auto i = 0U; i < objVector.size(); i += 2)
+    {
+        objVector[i].boundingBox = QT::Rect(position(random), position(random), size(random));
+        testTree.InsertOrUpdate(&objVector[i]);
+    }
+    testTree.Remove(&objVector[1]);
+
+    for (auto query = 0; query < 20; ++query)
+    {
+        auto region = QT::Rect(position(random), position(random), size(random) * 4.0, size(random) * 2.0);
+        std::vector<Obj*> found;
+        testTree.Query(region, found);
+        std::sort(found.begin(), found.end());
+
+        std::vector<Obj*> expected;
+        for (auto i = 0U; i < objVector.size(); ++i)
+        {
+            if (i != 1 && objVector[i].boundingBox.Intersects(region))
+            {
+                expected.push_back(&objVector[i]);
+            }
+        }
+        EXPECT_EQ(expected, found);
+    }
+}
+
+TEST_F(QuadTreeFixture, remove_then_reinsert)
+{
+    objVector[0].boundingBox = QT::Rect(10.0, 10.0, 5.0);
+    objVector[1].boundingBox = QT::Rect(12.0, 12.0, 5.0);
+    testTree.InsertOrUpdate(&objVector[0]);
+    testTree.InsertOrUpdate(&objVector[1]);
+    testTree.Remove(&objVector[1]);
+    testTree.Remove(&objVector[1]);
+
+    std::vector<Obj*> found;
+    testTree.Query(QT::Rect(10.0, 10.0, 20.0), found);
+    ASSERT_EQ(1U, found.size());
+    EXPECT_EQ(&objVector[0], found[0]);
+
+    testTree.InsertOrUpdate(&objVector[1]);
+    found.clear();
+    testTree.Query(QT::Rect(10.0, 10.0, 20.0), found);
+    EXPECT_EQ(2U, found.size());
+}
+
 int main(int argc, char **argv) 
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,198 @@
+#include "gtest/gtest.h"
+#include "RenderGraph.hpp"
+
+#include <vector>
+
+namespace
+{
+    const vka::ResourceState ColorWrite = {
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    const vka::ResourceState FragmentRead = {
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    const vka::ResourceState ComputeWrite = {
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_GENERAL };
+    const vka::ResourceState ComputeRead = {
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_GENERAL };
+    const vka::ResourceState Undefined = {
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED };
+    const vka::ResourceState Present = {
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR };
+
+    VkMemoryRequirements Requirements(VkDeviceSize size, VkDeviceSize alignment = 256, uint32_t typeBits = 1)
+    {
+        return { size, alignment, typeBits };
+    }
+}
+
+TEST(RenderGraph, CullsPassesNobodyReads)
+{
+    vka::RenderGraph graph;
+    auto backbuffer = graph.ImportImage("backbuffer", VK_IMAGE_ASPECT_COLOR_BIT, Undefined, Present);
+    auto unused = graph.CreateTransientImage("unused", VK_IMAGE_ASPECT_COLOR_BIT, Requirements(1024));
+    auto shadow = graph.CreateTransientImage("shadow", VK_IMAGE_ASPECT_COLOR_BIT, Requirements(1024));
+    graph.AddPass("debug", { { unused, ColorWrite } });
+    graph.AddPass("shadow", { { shadow, ColorWrite } });
+    graph.AddPass("main", { { shadow, FragmentRead }, { backbuffer, ColorWrite } });
+    graph.AddPass("stats", {}, true);
+
+    const auto& compiled = graph.Compile();
+    EXPECT_EQ((std::vector<size_t>{ 1, 2, 3 }), compiled.passes);
+    EXPECT_FALSE(compiled.placements[unused].has_value());
+    EXPECT_TRUE(compiled.placements[shadow].has_value());
+}
+
+TEST(RenderGraph, BatchesOneBarrierPerPass)
+{
+    vka::RenderGraph graph;
+    auto backbuffer = graph.ImportImage("backbuffer", VK_IMAGE_ASPECT_COLOR_BIT, Undefined, Present);
+    auto a = graph.CreateTransientImage("a", VK_IMAGE_ASPECT_COLOR_BIT, Requirements(1024));
+    auto b = graph.CreateTransientImage("b", VK_IMAGE_ASPECT_COLOR_BIT, Requirements(1024));
+    graph.AddPass("a", { { a, ColorWrite } });
+    graph.AddPass("b", { { b, ColorWrite } });
+    graph.AddPass("compose", { { a, FragmentRead }, { b, FragmentRead }, { backbuffer, ColorWrite } });
+
+    const auto& compiled = graph.Compile();
+    ASSERT_EQ(3U, compiled.barriers.size());
+    const auto& compose = compiled.barriers[2];
+    ASSERT_EQ(3U, compose.imageBarriers.size());
+    EXPECT_EQ(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, compose.srcStageMask);
+    EXPECT_EQ(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, compose.dstStageMask);
+    EXPECT_EQ(VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, compose.imageBarriers[0].srcAccessMask);
+    EXPECT_EQ(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, compose.imageBarriers[0].oldLayout);
+    EXPECT_EQ(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, compose.imageBarriers[0].newLayout);
+
+    ASSERT_EQ(1U, compiled.finalBarriers.imageBarriers.size());
+    EXPECT_EQ(VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, compiled.finalBarriers.imageBarriers[0].newLayout);
+}
+
+TEST(RenderGraph, RepeatedReadsNeedNoBarrier)
+{
+    vka::RenderGraph graph;
+    auto buffer = graph.ImportBuffer("buffer", { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED });
+    auto output = graph.ImportBuffer("output", Undefined);
+    graph.AddPass("first", { { buffer, ComputeRead }, { output, ComputeWrite } });
+    graph.AddPass("second", { { buffer, ComputeRead }, { output, ComputeRead } }, true);
+    graph.AddPass("third", { { buffer, ComputeRead } }, true);
+
+    const auto& compiled = graph.Compile();
+    // the transfer write is made visible once, then only output needs one
+    EXPECT_EQ(VK_PIPELINE_STAGE_TRANSFER_BIT, compiled.barriers[0].srcStageMask);
+    EXPECT_EQ(VK_ACCESS_TRANSFER_WRITE_BIT, compiled.barriers[0].srcAccessMask);
+    EXPECT_EQ(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, compiled.barriers[1].srcStageMask);
+    EXPECT_EQ(VK_ACCESS_SHADER_WRITE_BIT, compiled.barriers[1].srcAccessMask);
+    EXPECT_TRUE(compiled.barriers[1].imageBarriers.empty());
+    EXPECT_TRUE(compiled.barriers[2].empty());
+}
+
+TEST(RenderGraph, WriteAfterReadOnlyWaits)
+{
+    vka::RenderGraph graph;
+    auto buffer = graph.ImportBuffer("buffer", Undefined);
+    graph.AddPass("read", { { buffer, ComputeRead } }, true);
+    graph.AddPass("write", { { buffer, ComputeWrite } });
+
+    const auto& compiled = graph.Compile();
+    EXPECT_TRUE(compiled.barriers[0].empty());
+    EXPECT_EQ(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, compiled.barriers[1].srcStageMask);
+    EXPECT_EQ(0U, compiled.barriers[1].srcAccessMask);
+}
+
+TEST(RenderGraph, MergesAccessesToOneResource)
+{
+    vka::RenderGraph graph;
+    auto image = graph.ImportImage("image", VK_IMAGE_ASPECT_COLOR_BIT, Undefined);
+    graph.AddPass("blend", {
+        { image, ColorWrite },
+        { image, { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL } } });
+    EXPECT_EQ(1U, graph.GetPass(0).accesses.size());
+    EXPECT_EQ(VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, graph.GetPass(0).accesses[0].state.accessMask);
+    EXPECT_THROW(graph.AddPass("conflict", { { image, ColorWrite }, { image, FragmentRead } }), std::runtime_error);
+    EXPECT_THROW(graph.AddPass("missing", { { 7, ColorWrite } }), std::runtime_error);
+}
+
+TEST(RenderGraph, AliasesDisjointTransients)
+{
+    vka::RenderGraph graph;
+    auto backbuffer = graph.ImportImage("backbuffer", VK_IMAGE_ASPECT_COLOR_BIT, Undefined);
+    auto a = graph.CreateTransientImage("a", VK_IMAGE_ASPECT_COLOR_BIT, Requirements(4096));
+    auto b = graph.CreateTransientImage("b", VK_IMAGE_ASPECT_COLOR_BIT, Requirements(1000));
+    auto c = graph.CreateTransientImage("c", VK_IMAGE_ASPECT_COLOR_BIT, Requirements(2048));
+    auto other = graph.CreateTransientImage("other", VK_IMAGE_ASPECT_COLOR_BIT, Requirements(512, 256, 2));
+    graph.AddPass("a", { { a, ColorWrite } });
+    graph.AddPass("b", { { a, FragmentRead }, { b, ColorWrite } });
+    // a is dead from here on, so c can take its memory
+    graph.AddPass("c", { { b, FragmentRead }, { c, ColorWrite } });
+    graph.AddPass("other", { { other, ColorWrite } });
+    graph.AddPass("main", { { c, FragmentRead }, { other, FragmentRead }, { backbuffer, ColorWrite } });
+
+    const auto& compiled = graph.Compile();
+    ASSERT_EQ(2U, compiled.heaps.size());
+    EXPECT_EQ(0U, compiled.placements[a]->offset);
+    EXPECT_EQ(4096U, compiled.placements[b]->offset);
+    EXPECT_EQ(0U, compiled.placements[c]->offset);
+    EXPECT_EQ(4096U + 1000U, compiled.heaps[0].size);
+    EXPECT_EQ(1U, compiled.placements[other]->heap);
+    EXPECT_EQ(2U, compiled.heaps[1].memoryTypeBits);
+
+    // c's first use waits for a's last read of the shared memory
+    EXPECT_TRUE(compiled.barriers[2].srcStageMask & VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+}
+
+TEST(RenderGraph, RecompilesOnlyWhenChanged)
+{
+    vka::RenderGraph graph;
+    auto declare = [&graph](VkDeviceSize size)
+    {
+        graph.Clear();
+        auto backbuffer = graph.ImportImage("backbuffer", VK_IMAGE_ASPECT_COLOR_BIT, Undefined, Present);
+        auto scene = graph.CreateTransientImage("scene", VK_IMAGE_ASPECT_COLOR_BIT, Requirements(size));
+        graph.AddPass("scene", { { scene, ColorWrite } });
+        graph.AddPass("main", { { scene, FragmentRead }, { backbuffer, ColorWrite } });
+    };
+    declare(1024);
+    graph.Compile();
+    declare(1024);
+    graph.Compile();
+    EXPECT_EQ(1U, graph.GetCompileCount());
+    declare(2048);
+    EXPECT_EQ(2048U, graph.Compile().heaps[0].size);
+    EXPECT_EQ(2U, graph.GetCompileCount());
+}
+
+TEST(RenderGraph, UploadMatchesHandWrittenBarriers)
+{
+    vka::RenderGraph graph;
+    auto image = graph.ImportImage("image", VK_IMAGE_ASPECT_COLOR_BIT, Undefined, FragmentRead);
+    graph.AddPass("copy", { { image, { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL } } });
+    const auto& compiled = graph.Compile();
+
+    const auto& before = compiled.barriers[0];
+    EXPECT_EQ(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, before.srcStageMask);
+    EXPECT_EQ(VK_PIPELINE_STAGE_TRANSFER_BIT, before.dstStageMask);
+    ASSERT_EQ(1U, before.imageBarriers.size());
+    EXPECT_EQ(0U, before.imageBarriers[0].srcAccessMask);
+    EXPECT_EQ(VK_ACCESS_TRANSFER_WRITE_BIT, before.imageBarriers[0].dstAccessMask);
+
+    const auto& after = compiled.finalBarriers;
+    EXPECT_EQ(VK_PIPELINE_STAGE_TRANSFER_BIT, after.srcStageMask);
+    EXPECT_EQ(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, after.dstStageMask);
+    ASSERT_EQ(1U, after.imageBarriers.size());
+    EXPECT_EQ(VK_ACCESS_TRANSFER_WRITE_BIT, after.imageBarriers[0].srcAccessMask);
+    EXPECT_EQ(VK_ACCESS_SHADER_READ_BIT, after.imageBarriers[0].dstAccessMask);
+    EXPECT_EQ(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, after.imageBarriers[0].oldLayout);
+    EXPECT_EQ(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, after.imageBarriers[0].newLayout);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,113 @@
+#include "gtest/gtest.h"
+#include "SpriteBatch.hpp"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <vector>
+
+static vka::SpriteData TestSprite(uint32_t textureIndex, float id)
+{
+    return vka::MakeSpriteData(
+        glm::mat4(1.f),
+        glm::vec4(0.f, 0.f, 1.f, 1.f),
+        glm::vec4(0.f, 0.f, 1.f, 1.f),
+        glm::vec4(id),
+        textureIndex);
+}
+
+TEST(SpriteBatch, MapsUnitQuadToPositionRect)
+{
+    auto transform = glm::translate(glm::mat4(1.f), glm::vec3(10.f, 20.f, 0.f));
+    transform = glm::scale(transform, glm::vec3(2.f, 3.f, 1.f));
+    auto sprite = vka::MakeSpriteData(
+        transform,
+        glm::vec4(-1.f, -2.f, 3.f, 4.f),
+        glm::vec4(0.25f, 0.5f, 0.75f, 1.f),
+        glm::vec4(1.f),
+        5);
+
+    auto leftTop = sprite.transform * glm::vec4(0.f, 0.f, 0.f, 1.f);
+    auto rightBottom = sprite.transform * glm::vec4(1.f, 1.f, 0.f, 1.f);
+    auto expectedLeftTop = transform * glm::vec4(-1.f, -2.f, 0.f, 1.f);
+    auto expectedRightBottom = transform * glm::vec4(3.f, 4.f, 0.f, 1.f);
+    for (auto i = 0; i < 4; ++i)
+    {
+        EXPECT_FLOAT_EQ(leftTop[i], expectedLeftTop[i]);
+        EXPECT_FLOAT_EQ(rightBottom[i], expectedRightBottom[i]);
+    }
+    EXPECT_EQ(sprite.uvRect, glm::vec4(0.25f, 0.5f, 0.75f, 1.f));
+    EXPECT_EQ(sprite.textureIndex, 5U);
+}
+
+TEST(SpriteBatch, SplitsWhereTheTextureChanges)
+{
+    vka::SpriteBatcher batcher;
+    std::vector<uint32_t> textures = { 2, 0, 0, 1, 1, 2 };
+    for (size_t i = 0; i < textures.size(); ++i)
+    {
+        batcher.Add(TestSprite(textures[i], static_cast<float>(i)));
+    }
+
+    std::vector<vka::SpriteData> written(batcher.size());
+    const auto& batches = batcher.Write(written.data(), 0, true);
+    ASSERT_EQ(batches.size(), 4U);
+    EXPECT_EQ(batches[0].textureIndex, 2U);
+    EXPECT_EQ(batches[0].firstInstance, 0U);
+    EXPECT_EQ(batches[0].instanceCount, 1U);
+    EXPECT_EQ(batches[1].textureIndex, 0U);
+    EXPECT_EQ(batches[1].firstInstance, 1U);
+    EXPECT_EQ(batches[1].instanceCount, 2U);
+    EXPECT_EQ(batches[2].textureIndex, 1U);
+    EXPECT_EQ(batches[2].firstInstance, 3U);
+    EXPECT_EQ(batches[2].instanceCount, 2U);
+    EXPECT_EQ(batches[3].textureIndex, 2U);
+    EXPECT_EQ(batches[3].firstInstance, 5U);
+    EXPECT_EQ(batches[3].instanceCount, 1U);
+
+    // blended sprites must keep their order
+    for (size_t i = 0; i < written.size(); ++i)
+    {
+        EXPECT_EQ(written[i].color.x, static_cast<float>(i));
+    }
+}
+
+TEST(SpriteBatch, UnsplitIsOneBatchInSubmissionOrder)
+{
+    vka::SpriteBatcher batcher;
+    for (auto i = 0; i < 4; ++i)
+    {
+        batcher.Add(TestSprite(3 - i, static_cast<float>(i)));
+    }
+
+    std::vector<vka::SpriteData> written(batcher.size());
+    const auto& batches = batcher.Write(written.data(), 0, false);
+    ASSERT_EQ(batches.size(), 1U);
+    EXPECT_EQ(batches[0].firstInstance, 0U);
+    EXPECT_EQ(batches[0].instanceCount, 4U);
+    for (auto i = 0; i < 4; ++i)
+    {
+        EXPECT_EQ(written[i].color.x, static_cast<float>(i));
+    }
+}
+
+TEST(SpriteBatch, OffsetsByFirstInstance)
+{
+    vka::SpriteBatcher batcher;
+    batcher.Add(TestSprite(1, 0.f));
+    batcher.Add(TestSprite(0, 1.f));
+
+    std::vector<vka::SpriteData> written(batcher.size());
+    const auto& batches = batcher.Write(written.data(), 100, true);
+    ASSERT_EQ(batches.size(), 2U);
+    EXPECT_EQ(batches[0].firstInstance, 100U);
+    EXPECT_EQ(batches[1].firstInstance, 101U);
+
+    batcher.Clear();
+    EXPECT_TRUE(batcher.Write(written.data(), 0, true).empty());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
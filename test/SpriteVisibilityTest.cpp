@@ -0,0 +1,66 @@
+#include "gtest/gtest.h"
+#include "SpriteVisibility.hpp"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <vector>
+#include <cstdint>
+
+TEST(SpriteVisibility, ViewRegionMatchesOrtho)
+{
+    auto region = ViewRegion(glm::ortho(100.f, 900.f, 50.f, 650.f, 0.f, 1.f));
+    EXPECT_NEAR(100.0, region.GetLeft(), 1e-3);
+    EXPECT_NEAR(900.0, region.GetRight(), 1e-3);
+    EXPECT_NEAR(50.0, region.GetTop(), 1e-3);
+    EXPECT_NEAR(650.0, region.GetBottom(), 1e-3);
+}
+
+TEST(SpriteVisibility, TransformedBoundsCoverRotation)
+{
+    auto transform = glm::translate(glm::mat4(1.f), glm::vec3(10.f, 20.f, 0.f));
+    transform = glm::rotate(transform, glm::radians(90.f), glm::vec3(0.f, 0.f, 1.f));
+    auto bounds = TransformedBounds(transform, glm::vec4(0.f, 0.f, 4.f, 2.f));
+    EXPECT_NEAR(8.0, bounds.GetLeft(), 1e-4);
+    EXPECT_NEAR(10.0, bounds.GetRight(), 1e-4);
+    EXPECT_NEAR(20.0, bounds.GetTop(), 1e-4);
+    EXPECT_NEAR(24.0, bounds.GetBottom(), 1e-4);
+}
+
+TEST(SpriteVisibility, QueriesFollowUpdates)
+{
+    SpriteVisibility<uint32_t> visibility(1000.0);
+    auto view = QT::Rect(0.0, 0.0, 100.0);
+    for (uint32_t i = 0; i < 50; ++i)
+    {
+        // every other sprite starts off screen
+        auto x = (i % 2 == 0) ? static_cast<double>(i) : 500.0 + i;
+        visibility.InsertOrUpdate(49 - i, QT::Rect(x, 0.0, 1.0));
+    }
+    EXPECT_EQ(50U, visibility.size());
+
+    auto visible = visibility.Query(view);
+    ASSERT_EQ(25U, visible.size());
+    EXPECT_TRUE(std::is_sorted(visible.begin(), visible.end()));
+    for (auto key : visible)
+    {
+        EXPECT_EQ(1U, key % 2);
+    }
+
+    // move one on screen, one off screen and drop one
+    visibility.InsertOrUpdate(0, QT::Rect(-50.0, 50.0, 1.0));
+    visibility.InsertOrUpdate(1, QT::Rect(-500.0, 50.0, 1.0));
+    visibility.Remove(3);
+    visibility.Remove(3);
+    visible = visibility.Query(view);
+    EXPECT_EQ(24U, visible.size());
+    EXPECT_EQ(0U, visible.front());
+    EXPECT_EQ(visible.end(), std::find(visible.begin(), visible.end(), 1U));
+    EXPECT_EQ(visible.end(), std::find(visible.begin(), visible.end(), 3U));
+    EXPECT_EQ(49U, visibility.size());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
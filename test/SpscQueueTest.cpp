@@ -0,0 +1,57 @@
+#include "gtest/gtest.h"
+#include "SpscQueue.hpp"
+
+#include <thread>
+
+TEST(SpscQueue, fifo_order_and_capacity)
+{
+    SpscQueue<int, 4> queue;
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.tryPop().has_value());
+
+    EXPECT_TRUE(queue.tryPush(1));
+    EXPECT_TRUE(queue.tryPush(2));
+    EXPECT_TRUE(queue.tryPush(3));
+    EXPECT_FALSE(queue.tryPush(4));
+
+    EXPECT_EQ(1, queue.tryPop().value());
+    EXPECT_TRUE(queue.tryPush(4));
+    EXPECT_EQ(2, queue.tryPop().value());
+    EXPECT_EQ(3, queue.tryPop().value());
+    EXPECT_EQ(4, queue.tryPop().value());
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(SpscQueue, concurrent_transfer_keeps_every_value)
+{
+    SpscQueue<int, 8> queue;
+    const auto count = 100000;
+    std::thread producer([&]() {
+        for (auto i = 0; i < count; ++i)
+        {
+            while (!queue.tryPush(i))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    auto expected = 0;
+    while (expected < count)
+    {
+        auto value = queue.tryPop();
+        if (value.has_value())
+        {
+            ASSERT_EQ(expected, value.value());
+            ++expected;
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(queue.empty());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
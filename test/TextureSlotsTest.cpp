@@ -0,0 +1,28 @@
+#include "gtest/gtest.h"
+#include "TextureSlots.hpp"
+
+#include <stdexcept>
+
+TEST(TextureSlots, slots_are_handed_out_in_order)
+{
+    vka::TextureSlots slots(8);
+    EXPECT_EQ(slots.Allocate(), 0U);
+    EXPECT_EQ(slots.Allocate(), 1U);
+    EXPECT_EQ(slots.Allocate(), 2U);
+    EXPECT_EQ(slots.GetSlotCount(), 3U);
+}
+
+TEST(TextureSlots, full_array_throws)
+{
+    vka::TextureSlots slots(2);
+    slots.Allocate();
+    slots.Allocate();
+    EXPECT_THROW(slots.Allocate(), std::runtime_error);
+    EXPECT_EQ(slots.GetSlotCount(), 2U);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
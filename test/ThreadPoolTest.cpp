@@ -0,0 +1,79 @@
+#include "gtest/gtest.h"
+#include "ThreadPool.hpp"
+
+#include <vector>
+#include <atomic>
+#include <set>
+#include <mutex>
+
+TEST(ThreadPool, runs_every_task)
+{
+    vka::ThreadPool pool(4);
+    std::atomic<int> sum = 0;
+    for (auto i = 1; i <= 100; ++i)
+    {
+        pool.Enqueue([&sum, i](size_t) { sum += i; });
+    }
+    pool.Wait();
+    EXPECT_EQ(5050, sum.load());
+}
+
+TEST(ThreadPool, thread_index_is_in_range)
+{
+    vka::ThreadPool pool(3);
+    std::mutex mutex;
+    std::set<size_t> indices;
+    for (auto i = 0; i < 50; ++i)
+    {
+        pool.Enqueue([&](size_t threadIndex) {
+            std::lock_guard<std::mutex> lock(mutex);
+            indices.insert(threadIndex);
+        });
+    }
+    pool.Wait();
+    for (auto index : indices)
+    {
+        EXPECT_LT(index, pool.GetThreadCount());
+    }
+}
+
+TEST(ThreadPool, parallel_for_covers_range_once)
+{
+    vka::ThreadPool pool(4);
+    std::vector<int> hits(1000, 0);
+    std::vector<size_t> partitionBegins(8, 0);
+    auto partitions = pool.ParallelFor(hits.size(), 8, [&](size_t partition, size_t begin, size_t end, size_t) {
+        partitionBegins[partition] = begin;
+        for (auto i = begin; i < end; ++i)
+        {
+            ++hits[i];
+        }
+    });
+    EXPECT_EQ(8U, partitions);
+    for (auto hit : hits)
+    {
+        EXPECT_EQ(1, hit);
+    }
+    for (size_t i = 1; i < partitions; ++i)
+    {
+        EXPECT_LT(partitionBegins[i - 1], partitionBegins[i]);
+    }
+}
+
+TEST(ThreadPool, parallel_for_small_counts)
+{
+    vka::ThreadPool pool(4);
+    EXPECT_EQ(0U, pool.ParallelFor(0, 4, [](size_t, size_t, size_t, size_t) {}));
+    std::atomic<int> calls = 0;
+    EXPECT_EQ(3U, pool.ParallelFor(3, 8, [&](size_t, size_t begin, size_t end, size_t) {
+        EXPECT_EQ(begin + 1, end);
+        ++calls;
+    }));
+    EXPECT_EQ(3, calls.load());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,77 @@
+#include "gtest/gtest.h"
+#include "TripleBuffer.hpp"
+
+#include <thread>
+#include <vector>
+
+TEST(TripleBuffer, reader_sees_latest_publish)
+{
+    TripleBuffer<int> buffer;
+    EXPECT_FALSE(buffer.Acquire());
+
+    buffer.GetWriteBuffer() = 1;
+    buffer.Publish();
+    buffer.GetWriteBuffer() = 2;
+    buffer.Publish();
+
+    EXPECT_TRUE(buffer.Acquire());
+    EXPECT_EQ(2, buffer.GetReadBuffer());
+    EXPECT_FALSE(buffer.Acquire());
+    EXPECT_EQ(2, buffer.GetReadBuffer());
+}
+
+TEST(TripleBuffer, writer_never_gets_read_buffer)
+{
+    TripleBuffer<int> buffer;
+    buffer.GetWriteBuffer() = 1;
+    buffer.Publish();
+    ASSERT_TRUE(buffer.Acquire());
+    for (auto i = 0; i < 4; ++i)
+    {
+        EXPECT_NE(&buffer.GetReadBuffer(), &buffer.GetWriteBuffer());
+        buffer.GetWriteBuffer() = 10 + i;
+        buffer.Publish();
+    }
+    EXPECT_EQ(1, buffer.GetReadBuffer());
+}
+
+TEST(TripleBuffer, concurrent_values_are_whole_and_ordered)
+{
+    struct Values
+    {
+        std::vector<int> values = std::vector<int>(64, 0);
+    };
+    TripleBuffer<Values> buffer;
+    const auto count = 20000;
+    std::thread writer([&]() {
+        for (auto i = 1; i <= count; ++i)
+        {
+            auto &values = buffer.GetWriteBuffer().values;
+            std::fill(values.begin(), values.end(), i);
+            buffer.Publish();
+        }
+    });
+
+    auto last = 0;
+    while (last < count)
+    {
+        if (!buffer.Acquire())
+        {
+            continue;
+        }
+        const auto &values = buffer.GetReadBuffer().values;
+        for (auto value : values)
+        {
+            ASSERT_EQ(values.front(), value);
+        }
+        ASSERT_GT(values.front(), last);
+        last = values.front();
+    }
+    writer.join();
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,100 @@
+#include "gtest/gtest.h"
+#include "VertexQuantization.hpp"
+#include "glm/glm.hpp"
+#include "glm/gtc/packing.hpp"
+
+#include <vector>
+#include <cstring>
+
+class VertexQuantizationFixture : public ::testing::Test
+{
+public:
+    std::vector<glm::vec3> directions;
+    std::vector<glm::vec3> positions;
+
+    virtual void SetUp()
+    {
+        for (auto x = -2; x <= 2; ++x)
+        {
+            for (auto y = -2; y <= 2; ++y)
+            {
+                for (auto z = -2; z <= 2; ++z)
+                {
+                    if (x == 0 && y == 0 && z == 0)
+                    {
+                        continue;
+                    }
+                    directions.push_back(glm::normalize(glm::vec3(x, y, z)));
+                }
+            }
+        }
+        positions = {
+            glm::vec3(-1.f, -0.5f, 3.f),
+            glm::vec3(2.f, 0.25f, 3.f),
+            glm::vec3(0.5f, 4.f, 3.f)};
+    }
+};
+
+TEST_F(VertexQuantizationFixture, octahedral_round_trip)
+{
+    for (const auto &n : directions)
+    {
+        auto decoded = vka::OctahedralDecode(vka::OctahedralEncode(n));
+        EXPECT_GT(glm::dot(n, decoded), 0.9999f);
+    }
+}
+
+TEST_F(VertexQuantizationFixture, octahedral8_error_is_small)
+{
+    for (const auto &n : directions)
+    {
+        std::vector<uint8_t> bytes;
+        vka::QuantizationBounds unitBounds = {glm::vec3(0.f), glm::vec3(1.f)};
+        vka::AppendQuantizedNormal(bytes, n, unitBounds, vka::NormalEncoding::Octahedral8);
+        ASSERT_EQ(2U, bytes.size());
+        uint16_t packed;
+        std::memcpy(&packed, bytes.data(), sizeof(packed));
+        auto decoded = vka::OctahedralDecode(glm::unpackSnorm2x8(packed));
+        EXPECT_GT(glm::dot(n, decoded), 0.999f);
+    }
+}
+
+TEST_F(VertexQuantizationFixture, dequantize_matrix_restores_positions)
+{
+    auto bounds = vka::ComputeQuantizationBounds(positions);
+    // z is flat, the extent falls back to one so the matrix stays invertible
+    EXPECT_FLOAT_EQ(1.f, bounds.extent.z);
+    auto dequantize = bounds.GetDequantizeMatrix();
+    for (const auto &p : positions)
+    {
+        auto q = vka::QuantizePosition(p, bounds);
+        auto unorm = glm::vec3(q.x, q.y, q.z) / 65535.f;
+        auto restored = glm::vec3(dequantize * glm::vec4(unorm, 1.f));
+        EXPECT_NEAR(p.x, restored.x, 1e-4f);
+        EXPECT_NEAR(p.y, restored.y, 1e-4f);
+        EXPECT_NEAR(p.z, restored.z, 1e-4f);
+    }
+}
+
+TEST_F(VertexQuantizationFixture, compensated_normals_survive_dequantize_scale)
+{
+    auto bounds = vka::ComputeQuantizationBounds(positions);
+    auto dequantize = bounds.GetDequantizeMatrix();
+    for (const auto &n : directions)
+    {
+        std::vector<uint8_t> bytes;
+        vka::AppendQuantizedNormal(bytes, n, bounds, vka::NormalEncoding::Octahedral16);
+        ASSERT_EQ(4U, bytes.size());
+        uint32_t packed;
+        std::memcpy(&packed, bytes.data(), sizeof(packed));
+        auto decoded = vka::OctahedralDecode(glm::unpackSnorm2x16(packed));
+        auto transformed = glm::normalize(glm::vec3(dequantize * glm::vec4(decoded, 0.f)));
+        EXPECT_GT(glm::dot(n, transformed), 0.9999f);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,34 @@
+#include "ConfigBlob.hpp"
+
+#include <iostream>
+#include <filesystem>
+
+// Validates every .json config below the given directories and writes the
+// CBOR blob next to each one. Exits non-zero if any config is invalid.
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: configCompiler <config directory>..." << std::endl;
+        return 2;
+    }
+
+    auto failures = 0;
+    for (auto i = 1; i < argc; ++i)
+    {
+        for (const auto &entry : std::filesystem::recursive_directory_iterator(argv[i]))
+        {
+            if (!entry.is_regular_file() || entry.path().extension() != ".json")
+            {
+                continue;
+            }
+            auto path = entry.path().string();
+            for (const auto &problem : vka::CompileConfig(path))
+            {
+                std::cerr << path << ": " << problem << std::endl;
+                ++failures;
+            }
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
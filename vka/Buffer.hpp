@@ -54,14 +54,12 @@ static UniqueAllocatedBuffer CreateBufferUnique(
     return std::move(allocatedBuffer);
 }
 
-static void CopyToBuffer(
+// records a one time submit command buffer holding a single copy
+static void RecordBufferCopy(
     const VkCommandBuffer commandBuffer,
-    const VkQueue graphicsQueue,
     const VkBuffer source,
     const VkBuffer destination,
-    const VkBufferCopy &bufferCopy,
-    const VkFence fence,
-    const std::vector<VkSemaphore> signalSemaphores = {})
+    const VkBufferCopy &bufferCopy)
 {
     auto cmdBufferBeginInfo = VkCommandBufferBeginInfo();
     cmdBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -72,6 +70,18 @@ static void CopyToBuffer(
     vkBeginCommandBuffer(commandBuffer, &cmdBufferBeginInfo);
     vkCmdCopyBuffer(commandBuffer, source, destination, 1, &bufferCopy);
     vkEndCommandBuffer(commandBuffer);
+}
+
+static void CopyToBuffer(
+    const VkCommandBuffer commandBuffer,
+    const VkQueue graphicsQueue,
+    const VkBuffer source,
+    const VkBuffer destination,
+    const VkBufferCopy &bufferCopy,
+    const VkFence fence,
+    const std::vector<VkSemaphore> signalSemaphores = {})
+{
+    RecordBufferCopy(commandBuffer, source, destination, bufferCopy);
 
     auto submitInfo = VkSubmitInfo();
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
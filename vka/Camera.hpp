@@ -51,4 +51,86 @@ namespace vka
 		float m_Rotation = 0.f;
 		std::optional<glm::mat4> m_ViewProjectionMat;
 	};
+
+	class Camera3D
+	{
+	public:
+		const glm::vec3& getPosition() { return m_Position; }
+		void setPosition(glm::vec3&& position)
+		{
+			m_Position = position;
+			m_ViewMat.reset();
+		}
+
+		const glm::vec3& getTarget() { return m_Target; }
+		void setTarget(glm::vec3&& target)
+		{
+			m_Target = target;
+			m_ViewMat.reset();
+		}
+
+		const float& getFieldOfView() { return m_FieldOfView; }
+		void setFieldOfView(float&& fieldOfView)
+		{
+			m_FieldOfView = fieldOfView;
+			m_ProjectionMat.reset();
+		}
+
+		void setSize(glm::vec2&& size)
+		{
+			m_Size = size;
+			m_ProjectionMat.reset();
+		}
+
+		void setDepthRange(float nearPlane, float farPlane)
+		{
+			m_Near = nearPlane;
+			m_Far = farPlane;
+			m_ProjectionMat.reset();
+		}
+
+		float getNearPlane() { return m_Near; }
+		float getFarPlane() { return m_Far; }
+
+		const glm::mat4& getView()
+		{
+			if (m_ViewMat.has_value() == false)
+			{
+				m_ViewMat = glm::lookAt(m_Position, m_Target, m_Up);
+			}
+			return m_ViewMat.value();
+		}
+
+		const glm::mat4& getProjection()
+		{
+			if (m_ProjectionMat.has_value() == false)
+			{
+				auto aspect = m_Size.y > 0.f ? m_Size.x / m_Size.y : 1.f;
+				m_ProjectionMat = glm::perspective(m_FieldOfView, aspect, m_Near, m_Far);
+			}
+			return m_ProjectionMat.value();
+		}
+
+		glm::mat4 getViewProjection()
+		{
+			return getProjection() * getView();
+		}
+
+		// pixels covered by one world unit at a view space distance of one
+		float getProjectionScale()
+		{
+			return getProjection()[1][1] * m_Size.y * 0.5f;
+		}
+
+	private:
+		glm::vec3 m_Position = {0.f, 0.f, -10.f};
+		glm::vec3 m_Target = {0.f, 0.f, 0.f};
+		glm::vec3 m_Up = {0.f, -1.f, 0.f};
+		glm::vec2 m_Size = {0.f, 0.f};
+		float m_FieldOfView = glm::radians(60.f);
+		float m_Near = 0.1f;
+		float m_Far = 1000.f;
+		std::optional<glm::mat4> m_ViewMat;
+		std::optional<glm::mat4> m_ProjectionMat;
+	};
 }
\ No newline at end of file
@@ -0,0 +1,267 @@
+#pragma once
+#include "glm/glm.hpp"
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(VKA_SSE) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define VKA_SSE 1
+#endif
+#ifdef VKA_SSE
+#include <emmintrin.h>
+#endif
+
+namespace vka
+{
+// the view frustum is split into screen tiles and exponential depth slices;
+// tiles per slice must stay a multiple of four for the four wide test
+constexpr uint32_t ClusterCountX = 16U;
+constexpr uint32_t ClusterCountY = 9U;
+constexpr uint32_t ClusterCountZ = 24U;
+constexpr uint32_t ClustersPerSlice = ClusterCountX * ClusterCountY;
+constexpr uint32_t ClusterCount = ClustersPerSlice * ClusterCountZ;
+static_assert(ClustersPerSlice % 4 == 0, "clusters per slice must be a multiple of four");
+
+// one light as the 3D fragment shader reads it, the position in view space
+struct LightData
+{
+	glm::vec4 positionRadius;
+	glm::vec4 color;
+};
+
+// lights [offset, offset + count) of the light index list reach the cluster
+struct ClusterRange
+{
+	uint32_t offset;
+	uint32_t count;
+};
+
+// what the fragment shader needs to find its cluster, std140 compatible
+struct ClusterParameters
+{
+	// clusters per pixel in x and y, then the slice as log(viewDepth) * z + w
+	glm::vec4 scale;
+	// cluster counts in x, y and z, then the light count
+	glm::uvec4 counts;
+};
+
+// Bins view space light spheres into the clusters of a perspective projection.
+// Each cluster keeps the view space box around its froxel, so a light lands in
+// every cluster its sphere touches; the shader then only walks those lights.
+class LightClusters
+{
+public:
+	LightClusters()
+		: minX(ClusterCount), minY(ClusterCount), minZ(ClusterCount),
+		maxX(ClusterCount), maxY(ClusterCount), maxZ(ClusterCount),
+		ranges(ClusterCount, ClusterRange{ 0, 0 })
+	{
+	}
+
+	// cluster bounds only change with the projection, so rebuilding with the
+	// same arguments returns early
+	void Build(const glm::mat4 &projection, float nearPlane, float farPlane)
+	{
+		if (built && projection == builtProjection && nearPlane == nearDepth && farPlane == farDepth)
+		{
+			return;
+		}
+		built = true;
+		builtProjection = projection;
+		nearDepth = nearPlane;
+		farDepth = farPlane;
+		auto logRatio = std::log(farDepth / nearDepth);
+		sliceScale = ClusterCountZ / logRatio;
+		sliceBias = -std::log(nearDepth) * sliceScale;
+
+		// the view space point at a depth is linear in ndc, offsets cover
+		// off center projections
+		auto viewPoint = [&projection](float ndcX, float ndcY, float depth)
+		{
+			return glm::vec3(
+				depth * (ndcX + projection[2][0]) / projection[0][0],
+				depth * (ndcY + projection[2][1]) / projection[1][1],
+				-depth);
+		};
+		for (uint32_t z = 0; z < ClusterCountZ; ++z)
+		{
+			auto sliceNear = SliceDepth(z);
+			auto sliceFar = SliceDepth(z + 1);
+			for (uint32_t y = 0; y < ClusterCountY; ++y)
+			{
+				auto top = -1.f + 2.f * y / ClusterCountY;
+				auto bottom = -1.f + 2.f * (y + 1) / ClusterCountY;
+				for (uint32_t x = 0; x < ClusterCountX; ++x)
+				{
+					auto left = -1.f + 2.f * x / ClusterCountX;
+					auto right = -1.f + 2.f * (x + 1) / ClusterCountX;
+					std::array<glm::vec3, 8> corners = {
+						viewPoint(left, top, sliceNear), viewPoint(right, top, sliceNear),
+						viewPoint(left, bottom, sliceNear), viewPoint(right, bottom, sliceNear),
+						viewPoint(left, top, sliceFar), viewPoint(right, top, sliceFar),
+						viewPoint(left, bottom, sliceFar), viewPoint(right, bottom, sliceFar) };
+					auto lower = corners[0];
+					auto upper = corners[0];
+					for (const auto &corner : corners)
+					{
+						lower = glm::min(lower, corner);
+						upper = glm::max(upper, corner);
+					}
+					auto cluster = ClusterIndex(x, y, z);
+					minX[cluster] = lower.x;
+					minY[cluster] = lower.y;
+					minZ[cluster] = lower.z;
+					maxX[cluster] = upper.x;
+					maxY[cluster] = upper.y;
+					maxZ[cluster] = upper.z;
+				}
+			}
+		}
+	}
+
+	// lights hold the view space center in xyz and the radius in w; indices
+	// within a cluster keep the order of lights
+	void Assign(const std::vector<glm::vec4> &lights)
+	{
+		hits.clear();
+		for (uint32_t light = 0; light < lights.size(); ++light)
+		{
+			const auto &sphere = lights[light];
+			auto depth = -sphere.z;
+			if (sphere.w <= 0.f || depth + sphere.w < nearDepth || depth - sphere.w > farDepth)
+			{
+				continue;
+			}
+			auto firstSlice = SliceOf(depth - sphere.w);
+			auto lastSlice = SliceOf(depth + sphere.w);
+			for (auto slice = firstSlice; slice <= lastSlice; ++slice)
+			{
+				TestSlice(slice, sphere, light);
+			}
+		}
+
+		// counting sort by cluster, stable so lights stay in order
+		for (auto &range : ranges)
+		{
+			range = { 0, 0 };
+		}
+		for (const auto &hit : hits)
+		{
+			++ranges[hit.cluster].count;
+		}
+		uint32_t offset = 0;
+		for (auto &range : ranges)
+		{
+			range.offset = offset;
+			offset += range.count;
+			range.count = 0;
+		}
+		indices.resize(hits.size());
+		for (const auto &hit : hits)
+		{
+			auto &range = ranges[hit.cluster];
+			indices[range.offset + range.count++] = hit.light;
+		}
+	}
+
+	ClusterParameters GetParameters(float width, float height, uint32_t lightCount) const
+	{
+		return {
+			glm::vec4(ClusterCountX / width, ClusterCountY / height, sliceScale, sliceBias),
+			glm::uvec4(ClusterCountX, ClusterCountY, ClusterCountZ, lightCount) };
+	}
+
+	const std::vector<ClusterRange> &GetRanges() const { return ranges; }
+
+	const std::vector<uint32_t> &GetIndices() const { return indices; }
+
+	static uint32_t ClusterIndex(uint32_t x, uint32_t y, uint32_t z)
+	{
+		return (z * ClusterCountY + y) * ClusterCountX + x;
+	}
+
+	// the slice a view space depth falls in, as the fragment shader finds it
+	uint32_t SliceOf(float viewDepth) const
+	{
+		auto slice = std::floor(std::log(std::max(viewDepth, nearDepth)) * sliceScale + sliceBias);
+		return static_cast<uint32_t>(std::clamp(slice, 0.f, static_cast<float>(ClusterCountZ - 1)));
+	}
+
+	// where slice begins, slice ClusterCountZ is the far plane
+	float SliceDepth(uint32_t slice) const
+	{
+		return nearDepth * std::pow(farDepth / nearDepth, static_cast<float>(slice) / ClusterCountZ);
+	}
+
+private:
+	struct Hit
+	{
+		uint32_t cluster;
+		uint32_t light;
+	};
+
+	// sphere against the boxes of one slice's clusters, four at a time
+	void TestSlice(uint32_t slice, const glm::vec4 &sphere, uint32_t light)
+	{
+		auto first = slice * ClustersPerSlice;
+		auto radiusSquared = sphere.w * sphere.w;
+#ifdef VKA_SSE
+		auto cx = _mm_set1_ps(sphere.x);
+		auto cy = _mm_set1_ps(sphere.y);
+		auto cz = _mm_set1_ps(sphere.z);
+		auto r2 = _mm_set1_ps(radiusSquared);
+		auto zero = _mm_setzero_ps();
+		// distance from the center to each box along one axis, zero inside
+		auto axisDistance = [zero](__m128 center, const float *lower, const float *upper)
+		{
+			auto below = _mm_sub_ps(_mm_loadu_ps(lower), center);
+			auto above = _mm_sub_ps(center, _mm_loadu_ps(upper));
+			return _mm_max_ps(_mm_max_ps(below, above), zero);
+		};
+		for (auto cluster = first; cluster < first + ClustersPerSlice; cluster += 4)
+		{
+			auto dx = axisDistance(cx, &minX[cluster], &maxX[cluster]);
+			auto dy = axisDistance(cy, &minY[cluster], &maxY[cluster]);
+			auto dz = axisDistance(cz, &minZ[cluster], &maxZ[cluster]);
+			auto distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			auto mask = _mm_movemask_ps(_mm_cmple_ps(distanceSquared, r2));
+			for (uint32_t lane = 0; mask != 0; ++lane, mask >>= 1)
+			{
+				if (mask & 1)
+				{
+					hits.push_back({ cluster + lane, light });
+				}
+			}
+		}
+#else
+		for (auto cluster = first; cluster < first + ClustersPerSlice; ++cluster)
+		{
+			auto dx = std::max(std::max(minX[cluster] - sphere.x, sphere.x - maxX[cluster]), 0.f);
+			auto dy = std::max(std::max(minY[cluster] - sphere.y, sphere.y - maxY[cluster]), 0.f);
+			auto dz = std::max(std::max(minZ[cluster] - sphere.z, sphere.z - maxZ[cluster]), 0.f);
+			if (dx * dx + dy * dy + dz * dz <= radiusSquared)
+			{
+				hits.push_back({ cluster, light });
+			}
+		}
+#endif
+	}
+
+	bool built = false;
+	glm::mat4 builtProjection;
+	float nearDepth = 0.f;
+	float farDepth = 0.f;
+	float sliceScale = 0.f;
+	float sliceBias = 0.f;
+	// view space cluster boxes in SoA layout, indexed by ClusterIndex
+	std::vector<float> minX, minY, minZ;
+	std::vector<float> maxX, maxY, maxZ;
+	std::vector<Hit> hits;
+	std::vector<ClusterRange> ranges;
+	std::vector<uint32_t> indices;
+};
+} // namespace vka
@@ -0,0 +1,137 @@
+#pragma once
+#include "nlohmann/json.hpp"
+#include "fileIO.hpp"
+
+#include <vector>
+#include <string>
+#include <map>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <cstdint>
+
+// Release builds define VKA_BINARY_CONFIGS and only read the CBOR blobs the
+// configCompiler tool writes next to each JSON config at build time. Other
+// builds prefer an up to date blob and fall back to the JSON text, so editing
+// configs needs no rebuild during development.
+
+namespace vka
+{
+using json = nlohmann::json;
+
+// keys every config of a schema must have, checked before a blob is written
+static const std::map<std::string, std::vector<std::string>>& RequiredConfigKeys()
+{
+	static const std::map<std::string, std::vector<std::string>> requiredKeys = {
+		{ "dependencyGraph.schema.json", { "vertices", "edges" } },
+		{ "renderPassConfig.schema.json", { "attachments", "subpasses", "dependencies" } },
+		{ "swapchainConfig.schema.json", { "minImageCount", "imageFormat", "imageColorSpace", "imageExtent",
+			"imageArrayLayers", "imageUsage", "preTransform", "compositeAlpha", "presentMode", "clipped" } },
+		{ "samplerConfig.schema.json", { "magFilter", "minFilter", "mipmapMode", "addressModeU", "addressModeV",
+			"addressModeW", "mipLodBias", "anisotropyEnable", "maxAnisotropy", "compareEnable", "compareOp",
+			"minLod", "maxLod", "borderColor", "unnormalizedCoordinates" } },
+		{ "descriptorSetLayout.schema.json", { "bindings", "flags" } },
+		{ "pipelineLayoutConfig.schema.json", { "descriptorSetLayouts", "pushConstantRanges" } },
+		{ "shaderStageConfig.schema.json", { "stage", "name", "module", "specializationMapEntries" } },
+		{ "pipelineConfig.schema.json", { "shaderStageConfigs", "vertexInputConfig", "inputAssemblyConfig",
+			"tesselationConfig", "viewportConfig", "rasterizationConfig", "multisampleConfig",
+			"depthStencilConfig", "colorBlendConfig", "dynamicStates", "subpass" } } };
+	return requiredKeys;
+}
+
+// Returns a description of each problem found, empty when the config is usable.
+// Configs without a known $schema are only required to be objects.
+static std::vector<std::string> ValidateConfig(const json& config)
+{
+	std::vector<std::string> problems;
+	if (!config.is_object())
+	{
+		problems.push_back("config is not an object");
+		return problems;
+	}
+	auto schema = config.find("$schema");
+	if (schema == config.end() || !schema->is_string())
+	{
+		return problems;
+	}
+	auto schemaName = std::filesystem::path(schema->get<std::string>()).filename().string();
+	auto required = RequiredConfigKeys().find(schemaName);
+	if (required == RequiredConfigKeys().end())
+	{
+		problems.push_back("unknown schema " + schemaName);
+		return problems;
+	}
+	for (const auto& key : required->second)
+	{
+		if (config.find(key) == config.end())
+		{
+			problems.push_back("missing key " + key);
+		}
+	}
+	return problems;
+}
+
+static std::string ConfigBlobPath(const std::string& jsonPath)
+{
+	return std::filesystem::path(jsonPath).replace_extension(".cbor").string();
+}
+
+// Validates a JSON config and writes its blob. Returns the problems found;
+// nothing is written unless there are none.
+static std::vector<std::string> CompileConfig(const std::string& jsonPath)
+{
+	json config;
+	try
+	{
+		std::ifstream file(jsonPath);
+		file >> config;
+	}
+	catch (const std::exception& e)
+	{
+		return { e.what() };
+	}
+	auto problems = ValidateConfig(config);
+	if (!problems.empty())
+	{
+		return problems;
+	}
+	auto blob = json::to_cbor(config);
+	if (!fileIO::writeFileAtomic(ConfigBlobPath(jsonPath), std::vector<char>(blob.begin(), blob.end())))
+	{
+		problems.push_back("could not write " + ConfigBlobPath(jsonPath));
+	}
+	return problems;
+}
+
+static json LoadConfig(const std::string& jsonPath)
+{
+	auto blobPath = ConfigBlobPath(jsonPath);
+	auto useBlob = std::filesystem::exists(blobPath);
+#ifndef VKA_BINARY_CONFIGS
+	// a blob older than its JSON is stale while configs are being edited
+	if (useBlob && std::filesystem::exists(jsonPath))
+	{
+		useBlob = std::filesystem::last_write_time(blobPath) >= std::filesystem::last_write_time(jsonPath);
+	}
+#endif
+	if (useBlob)
+	{
+		auto blob = fileIO::readFile(blobPath);
+		return json::from_cbor(
+			reinterpret_cast<const uint8_t*>(blob.data()),
+			reinterpret_cast<const uint8_t*>(blob.data()) + blob.size());
+	}
+#ifdef VKA_BINARY_CONFIGS
+	throw std::runtime_error("Missing compiled config " + blobPath);
+#else
+	std::ifstream file(jsonPath);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Missing config " + jsonPath);
+	}
+	json config;
+	file >> config;
+	return config;
+#endif
+}
+} // namespace vka
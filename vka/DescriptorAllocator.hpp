@@ -0,0 +1,275 @@
+#pragma once
+#include "vulkan/vulkan.h"
+#include "VulkanFunctions.hpp"
+#include "UniqueVulkan.hpp"
+#include "nlohmann/json.hpp"
+#include "gsl.hpp"
+
+#include <vector>
+#include <map>
+#include <stdexcept>
+#include <cstdint>
+
+namespace vka
+{
+// descriptors a pool needs to hold setsPerPool sets of each layout
+static std::vector<VkDescriptorPoolSize> DescriptorPoolSizes(
+	const std::vector<nlohmann::json>& layouts,
+	uint32_t setsPerPool)
+{
+	std::map<VkDescriptorType, uint32_t> counts;
+	for (const auto& layoutJson : layouts)
+	{
+		for (const auto& bindingJson : layoutJson["bindings"])
+		{
+			VkDescriptorType type = bindingJson["descriptorType"];
+			counts[type] += bindingJson["descriptorCount"].get<uint32_t>() * setsPerPool;
+		}
+	}
+	std::vector<VkDescriptorPoolSize> poolSizes;
+	for (const auto& [type, count] : counts)
+	{
+		poolSizes.push_back({ type, count });
+	}
+	return poolSizes;
+}
+
+// Builds the writes a template update would perform, for devices without
+// VK_KHR_descriptor_update_template. Infos are copied out of data at each
+// entry's offset and stride; writes point into the info vectors, so those must
+// outlive the update and not be touched until it is done.
+static void TemplateWrites(
+	const std::vector<VkDescriptorUpdateTemplateEntry>& entries,
+	VkDescriptorSet set,
+	const void* data,
+	std::vector<VkWriteDescriptorSet>& writes,
+	std::vector<VkDescriptorImageInfo>& imageInfos,
+	std::vector<VkDescriptorBufferInfo>& bufferInfos,
+	std::vector<VkBufferView>& texelBufferViews)
+{
+	writes.clear();
+	imageInfos.clear();
+	bufferInfos.clear();
+	texelBufferViews.clear();
+	// infos are copied out first, so the write pointers stay valid
+	auto bytes = static_cast<const uint8_t*>(data);
+	std::vector<size_t> firstInfo;
+	for (const auto& entry : entries)
+	{
+		// an empty entry gets no write, its placeholder keeps firstInfo indexed by entry
+		if (entry.descriptorCount == 0)
+		{
+			firstInfo.push_back(0);
+			continue;
+		}
+		for (uint32_t i = 0; i < entry.descriptorCount; ++i)
+		{
+			auto element = bytes + entry.offset + i * entry.stride;
+			switch (entry.descriptorType)
+			{
+			case VK_DESCRIPTOR_TYPE_SAMPLER:
+			case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+			case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+			case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+			case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+				if (i == 0) firstInfo.push_back(imageInfos.size());
+				imageInfos.push_back(*reinterpret_cast<const VkDescriptorImageInfo*>(element));
+				break;
+			case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+			case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+				if (i == 0) firstInfo.push_back(texelBufferViews.size());
+				texelBufferViews.push_back(*reinterpret_cast<const VkBufferView*>(element));
+				break;
+			default:
+				if (i == 0) firstInfo.push_back(bufferInfos.size());
+				bufferInfos.push_back(*reinterpret_cast<const VkDescriptorBufferInfo*>(element));
+				break;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		const auto& entry = entries[i];
+		if (entry.descriptorCount == 0)
+		{
+			continue;
+		}
+		VkWriteDescriptorSet write = {};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.pNext = nullptr;
+		write.dstSet = set;
+		write.dstBinding = entry.dstBinding;
+		write.dstArrayElement = entry.dstArrayElement;
+		write.descriptorCount = entry.descriptorCount;
+		write.descriptorType = entry.descriptorType;
+		switch (entry.descriptorType)
+		{
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+			write.pImageInfo = imageInfos.data() + firstInfo[i];
+			break;
+		case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+		case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+			write.pTexelBufferView = texelBufferViews.data() + firstInfo[i];
+			break;
+		default:
+			write.pBufferInfo = bufferInfos.data() + firstInfo[i];
+			break;
+		}
+		writes.push_back(write);
+	}
+}
+
+// Allocates descriptor sets from pools it creates on demand. Sets are never
+// freed one by one: Reset returns every pool at once, so an allocator owned
+// by a frame is reset when the timeline passes that frame and its sets cost
+// one allocation each, with no bookkeeping.
+class DescriptorAllocator
+{
+public:
+	DescriptorAllocator(
+		VkDevice device,
+		std::vector<VkDescriptorPoolSize> sizesPerPool,
+		uint32_t setsPerPool,
+		VkDescriptorPoolCreateFlags flags = 0)
+		:
+		device(device),
+		sizesPerPool(std::move(sizesPerPool)),
+		setsPerPool(setsPerPool),
+		flags(flags)
+	{
+	}
+
+	VkDescriptorSet Allocate(VkDescriptorSetLayout layout)
+	{
+		if (currentPool == pools.size())
+		{
+			CreatePool();
+		}
+		VkDescriptorSetAllocateInfo allocateInfo = {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.pNext = nullptr;
+		allocateInfo.descriptorPool = pools[currentPool].get();
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &layout;
+
+		VkDescriptorSet set = VK_NULL_HANDLE;
+		auto result = vkAllocateDescriptorSets(device, &allocateInfo, &set);
+		if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+		{
+			// the current pool is full, move on to the next one
+			++currentPool;
+			if (currentPool == pools.size())
+			{
+				CreatePool();
+			}
+			allocateInfo.descriptorPool = pools[currentPool].get();
+			result = vkAllocateDescriptorSets(device, &allocateInfo, &set);
+		}
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate descriptor set");
+		}
+		return set;
+	}
+
+	// every set allocated since the last reset must no longer be in use
+	void Reset()
+	{
+		for (size_t i = 0; i < pools.size() && i <= currentPool; ++i)
+		{
+			vkResetDescriptorPool(device, pools[i].get(), 0);
+		}
+		currentPool = 0;
+	}
+
+	size_t GetPoolCount() const { return pools.size(); }
+
+private:
+	VkDevice device;
+	std::vector<VkDescriptorPoolSize> sizesPerPool;
+	uint32_t setsPerPool;
+	VkDescriptorPoolCreateFlags flags;
+	std::vector<VkDescriptorPoolUnique> pools;
+	size_t currentPool = 0;
+
+	void CreatePool()
+	{
+		VkDescriptorPoolCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		createInfo.pNext = nullptr;
+		createInfo.flags = flags;
+		createInfo.maxSets = setsPerPool;
+		createInfo.poolSizeCount = gsl::narrow<uint32_t>(sizesPerPool.size());
+		createInfo.pPoolSizes = sizesPerPool.data();
+
+		VkDescriptorPool pool;
+		if (vkCreateDescriptorPool(device, &createInfo, nullptr, &pool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create descriptor pool");
+		}
+		pools.emplace_back(pool, VkDescriptorPoolDeleter(device));
+	}
+};
+
+// Writes a whole set from a caller struct in one call. Each entry says where
+// in the struct a binding's infos live. Falls back to plain writes built from
+// the same entries when update templates are not available.
+class DescriptorUpdateTemplate
+{
+public:
+	DescriptorUpdateTemplate(
+		VkDevice device,
+		VkDescriptorSetLayout layout,
+		std::vector<VkDescriptorUpdateTemplateEntry> entries)
+		:
+		device(device),
+		entries(std::move(entries))
+	{
+		if (vkCreateDescriptorUpdateTemplateKHR == nullptr || vkUpdateDescriptorSetWithTemplateKHR == nullptr)
+		{
+			return;
+		}
+		VkDescriptorUpdateTemplateCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+		createInfo.pNext = nullptr;
+		createInfo.flags = 0;
+		createInfo.descriptorUpdateEntryCount = gsl::narrow<uint32_t>(this->entries.size());
+		createInfo.pDescriptorUpdateEntries = this->entries.data();
+		createInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+		createInfo.descriptorSetLayout = layout;
+
+		VkDescriptorUpdateTemplate updateTemplate;
+		if (vkCreateDescriptorUpdateTemplateKHR(device, &createInfo, nullptr, &updateTemplate) == VK_SUCCESS)
+		{
+			templateUnique = VkDescriptorUpdateTemplateUnique(updateTemplate, VkDescriptorUpdateTemplateDeleter(device));
+		}
+	}
+
+	void Update(VkDescriptorSet set, const void* data)
+	{
+		if (templateUnique)
+		{
+			vkUpdateDescriptorSetWithTemplateKHR(device, set, templateUnique.get(), data);
+			return;
+		}
+		TemplateWrites(entries, set, data, writes, imageInfos, bufferInfos, texelBufferViews);
+		vkUpdateDescriptorSets(device, gsl::narrow<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+
+private:
+	VkDevice device;
+	std::vector<VkDescriptorUpdateTemplateEntry> entries;
+	VkDescriptorUpdateTemplateUnique templateUnique;
+
+	// fallback scratch, reused between updates
+	std::vector<VkWriteDescriptorSet> writes;
+	std::vector<VkDescriptorImageInfo> imageInfos;
+	std::vector<VkDescriptorBufferInfo> bufferInfos;
+	std::vector<VkBufferView> texelBufferViews;
+};
+} // namespace vka
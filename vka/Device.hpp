@@ -5,6 +5,8 @@
 #include "Results.hpp"
 #include "fileIO.hpp"
 #include "Allocator.hpp"
+#include "PipelineCache.hpp"
+#include "InternCache.hpp"
 #include "VulkanFunctionLoader.hpp"
 #include "gsl.hpp"
 #include "nlohmann/json.hpp"
@@ -17,6 +19,10 @@
 #include <algorithm>
 #include <stdexcept>
 #include <string>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <deque>
 
 namespace vka
 {
@@ -35,6 +41,22 @@ namespace vka
 		return physicalDevices[0];
 	}
 
+	static bool DeviceExtensionSupported(VkPhysicalDevice physicalDevice, const std::string& extensionName)
+	{
+		uint32_t extensionCount;
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> extensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+		for (const auto& extension : extensions)
+		{
+			if (extensionName == extension.extensionName)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
 	class DeviceManager
 	{
 	public:
@@ -61,6 +83,15 @@ namespace vka
 
 		bool HostDeviceCombined() { return hostDeviceCombined; }
 
+		const VkPhysicalDeviceFeatures& GetEnabledFeatures() { return enabledFeatures; }
+
+		bool TimelineSemaphoresEnabled() { return timelineSemaphoresEnabled; }
+
+		// sampled image arrays may be partially bound and updated after bind
+		bool DescriptorIndexingEnabled() { return descriptorIndexingEnabled; }
+
+		uint32_t GetMaxUpdateAfterBindSampledImages() { return maxUpdateAfterBindSampledImages; }
+
 		VkDevice GetDevice()
 		{
 			return device;
@@ -119,6 +150,24 @@ namespace vka
 			return semaphore;
 		}
 
+		// requires TimelineSemaphoresEnabled()
+		VkSemaphore CreateTimelineSemaphore(uint64_t initialValue)
+		{
+			VkSemaphore semaphore;
+			VkSemaphoreTypeCreateInfoKHR typeInfo = {};
+			typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+			typeInfo.pNext = nullptr;
+			typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+			typeInfo.initialValue = initialValue;
+			VkSemaphoreCreateInfo createInfo = {};
+			createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			createInfo.pNext = &typeInfo;
+			vkCreateSemaphore(GetDevice(), &createInfo, nullptr, &semaphore);
+			semaphores[semaphore] =
+				VkSemaphoreUnique(semaphore, VkSemaphoreDeleter(GetDevice()));
+			return semaphore;
+		}
+
 		VkImageView CreateColorImageView2D(
 			VkImage image,
 			VkFormat format = VK_FORMAT_R8G8B8A8_SRGB)
@@ -197,7 +246,8 @@ namespace vka
 
 		std::vector<VkCommandBuffer> AllocateCommandBuffers(
 			const VkCommandPool& pool,
-			const uint32_t& count)
+			const uint32_t& count,
+			const VkCommandBufferLevel& level = VK_COMMAND_BUFFER_LEVEL_PRIMARY)
 		{
 			std::vector<VkCommandBuffer> commandBuffers;
 			commandBuffers.resize(count);
@@ -205,7 +255,7 @@ namespace vka
 			allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 			allocateInfo.pNext = nullptr;
 			allocateInfo.commandPool = pool;
-			allocateInfo.level = (VkCommandBufferLevel)0;
+			allocateInfo.level = level;
 			allocateInfo.commandBufferCount = count;
 			vkAllocateCommandBuffers(GetDevice(), &allocateInfo, commandBuffers.data());
 			return commandBuffers;
@@ -354,7 +404,10 @@ namespace vka
 			VkRenderPass renderPass;
 			vkCreateRenderPass(device, &createInfo, nullptr, &renderPass);
 
-			renderPasses[renderPass] = VkRenderPassUnique(renderPass, VkRenderPassDeleter(device));
+			{
+				std::lock_guard<std::mutex> lock(objectsMutex);
+				renderPasses[renderPass] = VkRenderPassUnique(renderPass, VkRenderPassDeleter(device));
+			}
 
 			return renderPass;
 		}
@@ -400,7 +453,8 @@ namespace vka
 		VkSwapchainKHR CreateSwapchain(
 			const VkSurfaceKHR& surface,
 			const VkSurfaceFormatKHR& surfaceFormat,
-			json swapchainConfig)
+			json swapchainConfig,
+			VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE)
 		{
 			VkSurfaceCapabilitiesKHR capabilities = {};
 			vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &capabilities);
@@ -452,7 +506,7 @@ namespace vka
 			createInfo.presentMode = selectedPresentMode;
 			createInfo.preTransform = capabilities.currentTransform;
 			createInfo.surface = surface;
-			createInfo.oldSwapchain = VK_NULL_HANDLE;
+			createInfo.oldSwapchain = oldSwapchain;
 
 			VkSwapchainKHR swapchain;
 			vkCreateSwapchainKHR(device, &createInfo, nullptr, &swapchain);
@@ -478,7 +532,10 @@ namespace vka
 
 			VkShaderModule shaderModule;
 			vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule);
-			shaderModules[shaderModule] = VkShaderModuleUnique(shaderModule, VkShaderModuleDeleter(device));
+			{
+				std::lock_guard<std::mutex> lock(objectsMutex);
+				shaderModules[shaderModule] = VkShaderModuleUnique(shaderModule, VkShaderModuleDeleter(device));
+			}
 
 			return shaderModule;
 		}
@@ -506,9 +563,17 @@ namespace vka
 			createInfo.borderColor = samplerJson["borderColor"];
 			createInfo.unnormalizedCoordinates = samplerJson["unnormalizedCoordinates"];
 
+			// identical samplers are created once, each request adds a reference
+			std::lock_guard<std::mutex> lock(objectsMutex);
+			SamplerKey key(createInfo);
+			if (auto cached = samplerCache.Acquire(key); cached != VK_NULL_HANDLE)
+			{
+				return cached;
+			}
 			VkSampler sampler;
 			vkCreateSampler(GetDevice(), &createInfo, nullptr, &sampler);
 			samplers[sampler] = VkSamplerUnique(sampler, VkSamplerDeleter(GetDevice()));
+			samplerCache.Insert(key, sampler);
 
 			return sampler;
 		}
@@ -522,6 +587,8 @@ namespace vka
 			createInfo.pNext = nullptr;
 
 			std::vector<VkDescriptorSetLayoutBinding> bindings;
+			std::vector<VkDescriptorBindingFlagsEXT> bindingFlags;
+			auto anyBindingFlags = false;
 			for (const auto& bindingJson : descriptorSetLayoutJson["bindings"])
 			{
 				auto& binding = bindings.emplace_back(VkDescriptorSetLayoutBinding());
@@ -536,6 +603,13 @@ namespace vka
 				{
 					binding.pImmutableSamplers = immutableSamplers.data();
 				}
+				// descriptor indexing flags, only present in layouts that need the extension
+				auto& flags = bindingFlags.emplace_back(0);
+				for (const auto& flag : bindingJson.value("bindingFlags", json::array()))
+				{
+					flags |= flag.get<VkDescriptorBindingFlagsEXT>();
+				}
+				anyBindingFlags |= flags != 0;
 			}
 			createInfo.bindingCount = gsl::narrow<uint32_t>(bindings.size());
 			createInfo.pBindings = bindings.data();
@@ -543,10 +617,26 @@ namespace vka
 			{
 				createInfo.flags |= flag;
 			}
+			VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo = {};
+			bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+			bindingFlagsInfo.pNext = nullptr;
+			bindingFlagsInfo.bindingCount = createInfo.bindingCount;
+			bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+			if (anyBindingFlags)
+			{
+				createInfo.pNext = &bindingFlagsInfo;
+			}
 
+			std::lock_guard<std::mutex> lock(objectsMutex);
+			DescriptorSetLayoutKey key(createInfo);
+			if (auto cached = descriptorSetLayoutCache.Acquire(key); cached != VK_NULL_HANDLE)
+			{
+				return cached;
+			}
 			VkDescriptorSetLayout setLayout;
 			vkCreateDescriptorSetLayout(device, &createInfo, nullptr, &setLayout);
 			descriptorSetLayouts[setLayout] = VkDescriptorSetLayoutUnique(setLayout, VkDescriptorSetLayoutDeleter(device));
+			descriptorSetLayoutCache.Insert(key, setLayout);
 
 			return setLayout;
 		}
@@ -574,6 +664,14 @@ namespace vka
 			{
 				createInfo.flags |= VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 			}
+			// sets of update after bind layouts must come from update after bind pools
+			for (const auto& flag : descriptorSetLayoutJson["flags"])
+			{
+				if (flag.get<VkDescriptorSetLayoutCreateFlags>() & VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT)
+				{
+					createInfo.flags |= VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+				}
+			}
 
 			VkDescriptorPool pool;
 			vkCreateDescriptorPool(device, &createInfo, nullptr, &pool);
@@ -625,13 +723,83 @@ namespace vka
 			createInfo.pPushConstantRanges = pushConstantRanges.data();
 			createInfo.flags = 0;
 
+			// layouts shared between pipelines also keep them layout compatible
+			std::lock_guard<std::mutex> lock(objectsMutex);
+			PipelineLayoutKey key(createInfo);
+			if (auto cached = pipelineLayoutCache.Acquire(key); cached != VK_NULL_HANDLE)
+			{
+				return cached;
+			}
 			VkPipelineLayout pipelineLayout;
 			vkCreatePipelineLayout(device, &createInfo, nullptr, &pipelineLayout);
 			pipelineLayouts[pipelineLayout] = VkPipelineLayoutUnique(pipelineLayout, VkPipelineLayoutDeleter(device));
+			pipelineLayoutCache.Insert(key, pipelineLayout);
 
 			return pipelineLayout;
 		}
 
+		// Creates the cache every pipeline is built through, seeded from the file
+		// saved for this device and driver if there is one. Must be called before
+		// any pipeline is created to have an effect.
+		void LoadPipelineCache(const std::string& directory)
+		{
+			VkPhysicalDeviceProperties properties = {};
+			vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+			pipelineCachePath = directory + PipelineCacheFileName(properties);
+
+			std::vector<char> initialData;
+			if (std::filesystem::exists(pipelineCachePath))
+			{
+				initialData = fileIO::readFile(pipelineCachePath);
+				if (!PipelineCacheDataMatches(initialData, properties))
+				{
+					initialData.clear();
+				}
+			}
+
+			VkPipelineCacheCreateInfo createInfo = {};
+			createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+			createInfo.pNext = nullptr;
+			createInfo.flags = 0;
+			createInfo.initialDataSize = initialData.size();
+			createInfo.pInitialData = initialData.data();
+			auto result = vkCreatePipelineCache(device, &createInfo, nullptr, &pipelineCache);
+			if (result != VK_SUCCESS && !initialData.empty())
+			{
+				// the driver may still refuse data that passed the header check
+				createInfo.initialDataSize = 0;
+				createInfo.pInitialData = nullptr;
+				result = vkCreatePipelineCache(device, &createInfo, nullptr, &pipelineCache);
+			}
+			if (result != VK_SUCCESS)
+			{
+				pipelineCache = VK_NULL_HANDLE;
+				return;
+			}
+			pipelineCacheUnique = VkPipelineCacheUnique(pipelineCache, VkPipelineCacheDeleter(device));
+		}
+
+		// writes the cache back to the file LoadPipelineCache read from
+		bool SavePipelineCache()
+		{
+			if (pipelineCache == VK_NULL_HANDLE)
+			{
+				return false;
+			}
+			size_t dataSize = 0;
+			if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+			{
+				return false;
+			}
+			std::vector<char> data(dataSize);
+			if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, data.data()) != VK_SUCCESS)
+			{
+				return false;
+			}
+			data.resize(dataSize);
+			return fileIO::writeFileAtomic(pipelineCachePath, data);
+		}
+
 		VkPipeline CreateGraphicsPipeline(
 			const VkPipelineLayout& layout,
 			const VkRenderPass& renderPass,
@@ -851,13 +1019,79 @@ namespace vka
 			createInfo.subpass = pipelineJson["subpass"];
 
 			VkPipeline pipeline;
-			vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &pipeline);
-			pipelines[pipeline] = VkPipelineUnique(pipeline, VkPipelineDeleter(device));
+			vkCreateGraphicsPipelines(device, pipelineCache, 1, &createInfo, nullptr, &pipeline);
+			{
+				std::lock_guard<std::mutex> lock(objectsMutex);
+				pipelines[pipeline] = VkPipelineUnique(pipeline, VkPipelineDeleter(device));
+			}
 
 			return pipeline;
 		}
 
+		// Retire* hand an object over to be destroyed once frame has completed on
+		// the GPU, instead of destroying it while earlier frames may still use it
+		void RetireImageView(VkImageView view, uint64_t frame) { Retire(imageViews, view, frame); }
+		void RetireFramebuffer(VkFramebuffer framebuffer, uint64_t frame) { Retire(framebuffers, framebuffer, frame); }
+		void RetireCommandPool(VkCommandPool pool, uint64_t frame) { Retire(commandPools, pool, frame); }
+		void RetireFence(VkFence fence, uint64_t frame) { Retire(fences, fence, frame); }
+		void RetireSemaphore(VkSemaphore semaphore, uint64_t frame) { Retire(semaphores, semaphore, frame); }
+		// interned objects are only retired once their last user retires them
+		void RetireSampler(VkSampler sampler, uint64_t frame)
+		{
+			std::lock_guard<std::mutex> lock(objectsMutex);
+			if (samplerCache.Release(sampler))
+			{
+				Retire(samplers, sampler, frame);
+			}
+		}
+		void RetireShaderModule(VkShaderModule module, uint64_t frame) { Retire(shaderModules, module, frame); }
+		void RetireSwapchain(VkSwapchainKHR swapchain, uint64_t frame) { Retire(swapchains, swapchain, frame); }
+		void RetireRenderPass(VkRenderPass renderPass, uint64_t frame) { Retire(renderPasses, renderPass, frame); }
+		void RetireDescriptorSetLayout(VkDescriptorSetLayout layout, uint64_t frame)
+		{
+			std::lock_guard<std::mutex> lock(objectsMutex);
+			if (descriptorSetLayoutCache.Release(layout))
+			{
+				Retire(descriptorSetLayouts, layout, frame);
+			}
+		}
+		void RetireDescriptorPool(VkDescriptorPool pool, uint64_t frame) { Retire(descriptorPools, pool, frame); }
+		void RetirePipelineLayout(VkPipelineLayout layout, uint64_t frame)
+		{
+			std::lock_guard<std::mutex> lock(objectsMutex);
+			if (pipelineLayoutCache.Release(layout))
+			{
+				Retire(pipelineLayouts, layout, frame);
+			}
+		}
+		void RetirePipeline(VkPipeline pipeline, uint64_t frame) { Retire(pipelines, pipeline, frame); }
+
+		// destroys everything retired in or before completedFrame; frames on one
+		// queue complete in submission order, so that is all the GPU could still use.
+		// Objects retired for a later frame than ones queued after them hold those
+		// back until it completes, which only delays them.
+		void CollectGarbage(uint64_t completedFrame)
+		{
+			while (!retiredObjects.empty() && retiredObjects.front().first <= completedFrame)
+			{
+				retiredObjects.pop_front();
+			}
+		}
+
 	private:
+		// the Unique wrapper is kept alive type-erased by shared_ptr<void>
+		template <typename HandleT, typename UniqueT>
+		void Retire(std::map<HandleT, UniqueT>& objects, HandleT handle, uint64_t frame)
+		{
+			auto found = objects.find(handle);
+			if (found == objects.end())
+			{
+				return;
+			}
+			retiredObjects.emplace_back(frame, std::make_shared<UniqueT>(std::move(found->second)));
+			objects.erase(found);
+		}
+
 		VkPhysicalDevice physicalDevice;
 		std::vector<const char*> deviceExtensions;
 		VkSurfaceKHR surface;
@@ -868,12 +1102,19 @@ namespace vka
 		VkDeviceQueueCreateInfo presentQueueCreateInfo;
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 		VkDeviceCreateInfo createInfo;
+		VkPhysicalDeviceFeatures enabledFeatures = {};
+		bool timelineSemaphoresEnabled = false;
+		bool descriptorIndexingEnabled = false;
+		uint32_t maxUpdateAfterBindSampledImages = 0;
 		VkDevice device;
 		VkDeviceUnique deviceUnique;
 		VkQueue graphicsQueue;
 		VkQueue presentQueue;
 		Allocator allocator;
 
+		// render passes, shader modules, layouts and pipelines may be created
+		// from several threads while the object graph is built
+		std::mutex objectsMutex;
 		std::map<VkImageView, VkImageViewUnique> imageViews;
 		std::map<VkFramebuffer, VkFramebufferUnique> framebuffers;
 		std::map<VkCommandPool, VkCommandPoolUnique> commandPools;
@@ -887,6 +1128,14 @@ namespace vka
 		std::map<VkDescriptorPool, VkDescriptorPoolUnique> descriptorPools;
 		std::map<VkPipelineLayout, VkPipelineLayoutUnique> pipelineLayouts;
 		std::map<VkPipeline, VkPipelineUnique> pipelines;
+		InternCache<SamplerKey, VkSampler> samplerCache;
+		InternCache<DescriptorSetLayoutKey, VkDescriptorSetLayout> descriptorSetLayoutCache;
+		InternCache<PipelineLayoutKey, VkPipelineLayout> pipelineLayoutCache;
+		std::string pipelineCachePath;
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+		VkPipelineCacheUnique pipelineCacheUnique;
+		// ordered by retire frame, which only ever grows
+		std::deque<std::pair<uint64_t, std::shared_ptr<void>>> retiredObjects;
 
 		void GetQueueFamilyProperties()
 		{
@@ -952,6 +1201,50 @@ namespace vka
 			presentQueueCreateInfo.pQueuePriorities = &presentQueuePriority;
 		}
 
+		// Enables only what a runtime sized, partially bound sampled image array
+		// updated after bind and indexed per sprite needs. Returns false when
+		// any of it is missing.
+		bool SelectDescriptorIndexingFeatures(VkPhysicalDeviceDescriptorIndexingFeaturesEXT& enabled)
+		{
+			if (vkGetPhysicalDeviceFeatures2KHR == nullptr || vkGetPhysicalDeviceProperties2KHR == nullptr)
+			{
+				return false;
+			}
+			VkPhysicalDeviceDescriptorIndexingFeaturesEXT supported = {};
+			supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+			VkPhysicalDeviceFeatures2 features = {};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features.pNext = &supported;
+			vkGetPhysicalDeviceFeatures2KHR(physicalDevice, &features);
+			if (!supported.runtimeDescriptorArray ||
+				!supported.shaderSampledImageArrayNonUniformIndexing ||
+				!supported.descriptorBindingPartiallyBound ||
+				!supported.descriptorBindingSampledImageUpdateAfterBind ||
+				!supported.descriptorBindingUpdateUnusedWhilePending)
+			{
+				return false;
+			}
+
+			VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties = {};
+			indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+			VkPhysicalDeviceProperties2 properties = {};
+			properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+			properties.pNext = &indexingProperties;
+			vkGetPhysicalDeviceProperties2KHR(physicalDevice, &properties);
+			maxUpdateAfterBindSampledImages = std::min(
+				indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+				indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages);
+
+			enabled = {};
+			enabled.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+			enabled.runtimeDescriptorArray = VK_TRUE;
+			enabled.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+			enabled.descriptorBindingPartiallyBound = VK_TRUE;
+			enabled.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+			enabled.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+			return true;
+		}
+
 		void CreateDevice()
 		{
 			GetQueueFamilyProperties();
@@ -976,16 +1269,54 @@ namespace vka
 			createInfo.ppEnabledLayerNames = nullptr;
 			createInfo.enabledExtensionCount = gsl::narrow<uint32_t>(deviceExtensions.size());
 			createInfo.ppEnabledExtensionNames = deviceExtensions.data();
-			createInfo.pEnabledFeatures = nullptr;
+			// only features the renderer has a fallback for are requested, and only when supported
+			VkPhysicalDeviceFeatures supportedFeatures = {};
+			vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+			enabledFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+			enabledFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+			createInfo.pEnabledFeatures = &enabledFeatures;
+			// extensions are only listed when the physical device supports them
+			auto extensionEnabled = [this](const char* name)
+			{
+				return std::find_if(deviceExtensions.begin(), deviceExtensions.end(),
+					[name](const char* extension) { return std::string(extension) == name; }) != deviceExtensions.end();
+			};
+			VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures = {};
+			timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+			timelineFeatures.pNext = nullptr;
+			timelineFeatures.timelineSemaphore = VK_TRUE;
+			auto timelineRequested = extensionEnabled(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+			if (timelineRequested)
+			{
+				timelineFeatures.pNext = const_cast<void*>(createInfo.pNext);
+				createInfo.pNext = &timelineFeatures;
+			}
+			VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+			auto indexingRequested = extensionEnabled(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) &&
+				extensionEnabled(VK_KHR_MAINTENANCE3_EXTENSION_NAME) &&
+				SelectDescriptorIndexingFeatures(indexingFeatures);
+			if (indexingRequested)
+			{
+				indexingFeatures.pNext = const_cast<void*>(createInfo.pNext);
+				createInfo.pNext = &indexingFeatures;
+			}
 			vkCreateDevice(physicalDevice, &createInfo, nullptr, &device);
 			deviceUnique = VkDeviceUnique(device, VkDeviceDeleter());
 			LoadDeviceLevelEntryPoints(device);
+			timelineSemaphoresEnabled = timelineRequested &&
+				vkGetSemaphoreCounterValueKHR != nullptr &&
+				vkWaitSemaphoresKHR != nullptr;
+			descriptorIndexingEnabled = indexingRequested;
 
 			vkGetDeviceQueue(device, graphicsQueueID, 0, &graphicsQueue);
 			if (!singleQueue)
 			{
 				vkGetDeviceQueue(device, presentQueueID, 0, &presentQueue);
 			}
+			else
+			{
+				presentQueue = graphicsQueue;
+			}
 		}
 
 		void CheckMemoryLocality()
@@ -0,0 +1,134 @@
+#pragma once
+#include "ThreadPool.hpp"
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+namespace vka
+{
+// Sort key layout, most significant first: layer 4 bits, pipeline 8,
+// material or texture 16, mesh 16, depth 20. Sorting by key groups draws by
+// the state that is most expensive to change, then orders them by depth.
+struct DrawKeyFields
+{
+	uint32_t layer;
+	uint32_t pipeline;
+	uint32_t material;
+	uint32_t mesh;
+	uint32_t depth;
+};
+
+constexpr uint32_t DrawKeyDepthBits = 20U;
+constexpr uint32_t DrawKeyMaxDepth = (1U << DrawKeyDepthBits) - 1U;
+
+static uint64_t EncodeDrawKey(const DrawKeyFields& fields)
+{
+	return (uint64_t(fields.layer & 0xFU) << 60) |
+		(uint64_t(fields.pipeline & 0xFFU) << 52) |
+		(uint64_t(fields.material & 0xFFFFU) << 36) |
+		(uint64_t(fields.mesh & 0xFFFFU) << 20) |
+		uint64_t(fields.depth & DrawKeyMaxDepth);
+}
+
+static DrawKeyFields DecodeDrawKey(uint64_t key)
+{
+	return {
+		uint32_t(key >> 60) & 0xFU,
+		uint32_t(key >> 52) & 0xFFU,
+		uint32_t(key >> 36) & 0xFFFFU,
+		uint32_t(key >> 20) & 0xFFFFU,
+		uint32_t(key) & DrawKeyMaxDepth };
+}
+
+// Positive floats order like their bit patterns, so the top bits below the
+// sign keep that order at reduced precision. Opaque draws sort front to back
+// to reject hidden fragments early, blended ones back to front.
+static uint32_t DepthKey(float viewDepth, bool backToFront)
+{
+	viewDepth = std::max(viewDepth, 0.f);
+	uint32_t bits;
+	std::memcpy(&bits, &viewDepth, sizeof(bits));
+	auto depth = (bits >> (31U - DrawKeyDepthBits)) & DrawKeyMaxDepth;
+	return backToFront ? DrawKeyMaxDepth - depth : depth;
+}
+
+// index refers to whatever the caller keeps per draw
+struct DrawPacket
+{
+	uint64_t key;
+	uint32_t index;
+};
+
+// below this many packets per partition a pass is cheaper on one thread
+constexpr size_t MinPacketsPerPartition = 2048U;
+
+// Stable LSD radix sort on the key, one byte per pass. Each pass counts
+// bytes per partition in parallel, then scatters every partition to its own
+// precomputed offsets in parallel. Bytes equal across all keys are skipped,
+// which for typical scenes leaves only a few passes. scratch is resized and
+// reused between calls.
+static void RadixSortDrawPackets(ThreadPool& threadPool, std::vector<DrawPacket>& packets, std::vector<DrawPacket>& scratch)
+{
+	auto count = packets.size();
+	if (count < 2)
+	{
+		return;
+	}
+	auto anyBits = uint64_t(0);
+	auto allBits = ~uint64_t(0);
+	for (const auto& packet : packets)
+	{
+		anyBits |= packet.key;
+		allBits &= packet.key;
+	}
+	auto varyingBits = anyBits ^ allBits;
+
+	scratch.resize(count);
+	auto partitionCount = std::min(
+		threadPool.GetThreadCount(),
+		(count + MinPacketsPerPartition - 1) / MinPacketsPerPartition);
+	std::vector<std::array<size_t, 256>> offsets(std::max(partitionCount, size_t(1)));
+	for (uint32_t shift = 0; shift < 64; shift += 8)
+	{
+		if (((varyingBits >> shift) & 0xFFU) == 0)
+		{
+			continue;
+		}
+
+		auto partitionsUsed = threadPool.ParallelFor(count, partitionCount, [&](size_t partition, size_t begin, size_t end, size_t)
+		{
+			auto& histogram = offsets[partition];
+			histogram.fill(0);
+			for (auto i = begin; i < end; ++i)
+			{
+				++histogram[(packets[i].key >> shift) & 0xFFU];
+			}
+		});
+
+		// bucket major, partition minor keeps equal bytes in their current order
+		size_t total = 0;
+		for (size_t bucket = 0; bucket < 256; ++bucket)
+		{
+			for (size_t partition = 0; partition < partitionsUsed; ++partition)
+			{
+				auto bucketCount = offsets[partition][bucket];
+				offsets[partition][bucket] = total;
+				total += bucketCount;
+			}
+		}
+
+		threadPool.ParallelFor(count, partitionCount, [&](size_t partition, size_t begin, size_t end, size_t)
+		{
+			auto& offset = offsets[partition];
+			for (auto i = begin; i < end; ++i)
+			{
+				scratch[offset[(packets[i].key >> shift) & 0xFFU]++] = packets[i];
+			}
+		});
+		std::swap(packets, scratch);
+	}
+}
+} // namespace vka
@@ -0,0 +1,131 @@
+#pragma once
+#include "glm/glm.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VKA_SSE 1
+#include <emmintrin.h>
+#endif
+
+// MSVC only defines __AVX__ and __AVX2__ under /arch:AVX or /arch:AVX2
+#if defined(__AVX__)
+#define VKA_AVX 1
+#include <immintrin.h>
+#endif
+
+namespace vka
+{
+// six inward facing planes, xyz is the unit normal and w the distance term
+struct Frustum
+{
+	std::array<glm::vec4, 6> planes;
+};
+
+// extracts the planes of a [0, 1] depth range clip matrix; passing
+// projection * view * model yields the frustum in that model's object space
+static Frustum FrustumFromMatrix(const glm::mat4 &m)
+{
+	auto row = [&m](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+	auto r0 = row(0);
+	auto r1 = row(1);
+	auto r2 = row(2);
+	auto r3 = row(3);
+
+	Frustum frustum;
+	frustum.planes = {
+		r3 + r0,
+		r3 - r0,
+		r3 + r1,
+		r3 - r1,
+		r2,
+		r3 - r2};
+	for (auto &plane : frustum.planes)
+	{
+		auto length = glm::length(glm::vec3(plane));
+		if (length > 0.f)
+		{
+			plane /= length;
+		}
+	}
+	return frustum;
+}
+
+static bool SphereInFrustum(const Frustum &frustum, const glm::vec3 &center, float radius)
+{
+	for (const auto &plane : frustum.planes)
+	{
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Tests four spheres at once from SoA arrays. Bit i of the result is set when
+// sphere i intersects the frustum.
+static uint32_t SpheresInFrustum4(
+	const Frustum &frustum,
+	const float *centerX,
+	const float *centerY,
+	const float *centerZ,
+	const float *radius)
+{
+#ifdef VKA_SSE
+	auto x = _mm_loadu_ps(centerX);
+	auto y = _mm_loadu_ps(centerY);
+	auto z = _mm_loadu_ps(centerZ);
+	auto negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius));
+	auto inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+	for (const auto &plane : frustum.planes)
+	{
+		auto distance = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+			_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+		inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+	}
+	return static_cast<uint32_t>(_mm_movemask_ps(inside));
+#else
+	uint32_t mask = 0;
+	for (auto i = 0U; i < 4; ++i)
+	{
+		if (SphereInFrustum(frustum, glm::vec3(centerX[i], centerY[i], centerZ[i]), radius[i]))
+		{
+			mask |= 1U << i;
+		}
+	}
+	return mask;
+#endif
+}
+
+// eight wide version of SpheresInFrustum4, bit i set when sphere i is visible
+static uint32_t SpheresInFrustum8(
+	const Frustum &frustum,
+	const float *centerX,
+	const float *centerY,
+	const float *centerZ,
+	const float *radius)
+{
+#ifdef VKA_AVX
+	auto x = _mm256_loadu_ps(centerX);
+	auto y = _mm256_loadu_ps(centerY);
+	auto z = _mm256_loadu_ps(centerZ);
+	auto negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius));
+	auto inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+	for (const auto &plane : frustum.planes)
+	{
+		auto distance = _mm256_add_ps(
+			_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane.x)), _mm256_mul_ps(y, _mm256_set1_ps(plane.y))),
+			_mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+		inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+	}
+	return static_cast<uint32_t>(_mm256_movemask_ps(inside));
+#else
+	return SpheresInFrustum4(frustum, centerX, centerY, centerZ, radius) |
+		(SpheresInFrustum4(frustum, centerX + 4, centerY + 4, centerZ + 4, radius + 4) << 4);
+#endif
+}
+} // namespace vka
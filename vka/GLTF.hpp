@@ -4,6 +4,7 @@
 #include "glm/glm.hpp"
 #include "gsl.hpp"
 #include "UniqueVulkan.hpp"
+#include "VertexQuantization.hpp"
 
 #include <fstream>
 #include <vector>
@@ -15,6 +16,42 @@ using json = nlohmann::json;
 
 namespace vka
 {
+// a simplified index list over the vertices of its parent mesh
+struct MeshLOD
+{
+	std::vector<uint8_t> indices;
+	size_t firstIndex;
+	// object space error relative to the parent mesh's bounding radius
+	float error;
+};
+
+// a cluster of triangles occupying a contiguous range of its mesh's indices
+struct Meshlet
+{
+	// relative to the mesh's first index
+	size_t firstIndex;
+	size_t indexCount;
+	glm::vec3 center;
+	float radius;
+	glm::vec3 coneAxis;
+	// sine of the cone's spread, 1 when the cluster can never be backface culled
+	float coneCutoff;
+};
+
+// meshlet culling data in SoA layout, padded to a multiple of four with
+// clusters that always fail the frustum test
+struct MeshletBounds
+{
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> radius;
+	std::vector<float> coneAxisX;
+	std::vector<float> coneAxisY;
+	std::vector<float> coneAxisZ;
+	std::vector<float> coneCutoff;
+};
+
 struct Mesh
 {
 	std::vector<glm::vec3> positions;
@@ -22,12 +59,24 @@ struct Mesh
 	std::vector<uint8_t> indices;
 	size_t firstIndex;
 	size_t firstVertex;
+	glm::vec3 boundsCenter;
+	float boundsRadius;
+	// progressively coarser levels, the mesh itself is LOD 0
+	std::vector<MeshLOD> lods;
+	// clusters of the full detail indices, empty for meshes small enough to draw whole
+	std::vector<Meshlet> meshlets;
+	MeshletBounds meshletBounds;
 };
 
 struct Model
 {
 	Mesh collision;
 	Mesh full;
+	VertexFormat vertexFormat = VertexFormat::Float;
+	// takes quantized positions back to object space, identity for float models
+	glm::mat4 dequantize = glm::mat4(1.f);
+	// dense index used as the mesh field of draw sort keys
+	uint32_t drawID = 0;
 };
 
 namespace detail
@@ -0,0 +1,195 @@
+#pragma once
+#include "Device.hpp"
+
+#include <deque>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+namespace vka
+{
+// Tracks GPU progress as one monotonically increasing value. Every submit made
+// through Submit signals the next value, so waiting for a frame or an upload is
+// a single wait-for-value. Uses a timeline semaphore when the device supports
+// one, otherwise a recycled fence per pending value. Values only complete in
+// submission order, so all submits must go to the same queue. Not thread safe.
+class GpuTimeline
+{
+public:
+	GpuTimeline(DeviceManager& deviceManager)
+		:
+		deviceManager(deviceManager),
+		device(deviceManager.GetDevice())
+	{
+		if (deviceManager.TimelineSemaphoresEnabled())
+		{
+			semaphore = deviceManager.CreateTimelineSemaphore(0);
+		}
+	}
+
+	bool UsesTimelineSemaphore() const { return semaphore != VK_NULL_HANDLE; }
+
+	// value signaled by the most recent Submit
+	uint64_t GetSubmittedValue() const { return submittedValue; }
+
+	// Submits to queue and signals the next timeline value, written to
+	// signaledValue. The caller's signal semaphores are still signaled.
+	VkResult Submit(VkQueue queue, const VkSubmitInfo& submitInfo, uint64_t& signaledValue)
+	{
+		auto value = submittedValue + 1;
+		auto info = submitInfo;
+		auto fence = VkFence(VK_NULL_HANDLE);
+		VkTimelineSemaphoreSubmitInfoKHR timelineInfo = {};
+		if (UsesTimelineSemaphore())
+		{
+			signalSemaphores.assign(
+				submitInfo.pSignalSemaphores,
+				submitInfo.pSignalSemaphores + submitInfo.signalSemaphoreCount);
+			signalSemaphores.push_back(semaphore);
+			// binary semaphores ignore their value
+			signalValues.assign(signalSemaphores.size(), 0);
+			signalValues.back() = value;
+
+			timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+			timelineInfo.pNext = submitInfo.pNext;
+			timelineInfo.signalSemaphoreValueCount = gsl::narrow<uint32_t>(signalValues.size());
+			timelineInfo.pSignalSemaphoreValues = signalValues.data();
+			if (submitInfo.waitSemaphoreCount > 0)
+			{
+				waitValues.assign(submitInfo.waitSemaphoreCount, 0);
+				timelineInfo.waitSemaphoreValueCount = submitInfo.waitSemaphoreCount;
+				timelineInfo.pWaitSemaphoreValues = waitValues.data();
+			}
+			info.pNext = &timelineInfo;
+			info.signalSemaphoreCount = gsl::narrow<uint32_t>(signalSemaphores.size());
+			info.pSignalSemaphores = signalSemaphores.data();
+		}
+		else
+		{
+			fence = AcquireFence();
+		}
+
+		auto result = vkQueueSubmit(queue, 1, &info, fence);
+		if (result != VK_SUCCESS)
+		{
+			if (fence != VK_NULL_HANDLE)
+			{
+				freeFences.push_back(fence);
+			}
+			return result;
+		}
+		if (fence != VK_NULL_HANDLE)
+		{
+			pendingFences.emplace_back(value, fence);
+		}
+		submittedValue = value;
+		signaledValue = value;
+		return result;
+	}
+
+	// blocks until the GPU has passed value, or until timeout nanoseconds elapse
+	VkResult Wait(uint64_t value, uint64_t timeout = std::numeric_limits<uint64_t>::max())
+	{
+		if (value <= completedValue)
+		{
+			return VK_SUCCESS;
+		}
+		if (UsesTimelineSemaphore())
+		{
+			VkSemaphoreWaitInfoKHR waitInfo = {};
+			waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+			waitInfo.pNext = nullptr;
+			waitInfo.flags = 0;
+			waitInfo.semaphoreCount = 1;
+			waitInfo.pSemaphores = &semaphore;
+			waitInfo.pValues = &value;
+			auto result = vkWaitSemaphoresKHR(device, &waitInfo, timeout);
+			if (result == VK_SUCCESS)
+			{
+				completedValue = std::max(completedValue, value);
+			}
+			return result;
+		}
+
+		// the first pending fence at or past value covers it
+		auto pending = std::find_if(pendingFences.begin(), pendingFences.end(),
+			[value](const auto& entry) { return entry.first >= value; });
+		if (pending == pendingFences.end())
+		{
+			return VK_SUCCESS;
+		}
+		auto result = vkWaitForFences(device, 1, &pending->second, VK_TRUE, timeout);
+		if (result == VK_SUCCESS)
+		{
+			RetireFences(pending->first);
+		}
+		return result;
+	}
+
+	// highest value the GPU is known to have passed, without blocking
+	uint64_t GetCompletedValue()
+	{
+		if (UsesTimelineSemaphore())
+		{
+			uint64_t value = 0;
+			if (vkGetSemaphoreCounterValueKHR(device, semaphore, &value) == VK_SUCCESS)
+			{
+				completedValue = std::max(completedValue, value);
+			}
+			return completedValue;
+		}
+
+		auto signaled = completedValue;
+		for (const auto& [value, fence] : pendingFences)
+		{
+			if (vkGetFenceStatus(device, fence) != VK_SUCCESS)
+			{
+				break;
+			}
+			signaled = value;
+		}
+		RetireFences(signaled);
+		return completedValue;
+	}
+
+private:
+	DeviceManager& deviceManager;
+	VkDevice device;
+	VkSemaphore semaphore = VK_NULL_HANDLE;
+	uint64_t submittedValue = 0;
+	uint64_t completedValue = 0;
+
+	// scratch for the timeline submit info, reused to avoid per submit allocations
+	std::vector<VkSemaphore> signalSemaphores;
+	std::vector<uint64_t> signalValues;
+	std::vector<uint64_t> waitValues;
+
+	// fallback: one fence per value still in flight, in submission order
+	std::deque<std::pair<uint64_t, VkFence>> pendingFences;
+	std::vector<VkFence> freeFences;
+
+	VkFence AcquireFence()
+	{
+		if (freeFences.empty())
+		{
+			return deviceManager.CreateFence(false);
+		}
+		auto fence = freeFences.back();
+		freeFences.pop_back();
+		return fence;
+	}
+
+	// fences signal in submission order, so everything up to value is done
+	void RetireFences(uint64_t value)
+	{
+		while (!pendingFences.empty() && pendingFences.front().first <= value)
+		{
+			auto fence = pendingFences.front().second;
+			vkResetFences(device, 1, &fence);
+			freeFences.push_back(fence);
+			pendingFences.pop_front();
+		}
+		completedValue = std::max(completedValue, value);
+	}
+};
+} // namespace vka
@@ -7,6 +7,7 @@
 #include "Buffer.hpp"
 #include "Bitmap.hpp"
 #include "UniqueVulkan.hpp"
+#include "RenderGraph.hpp"
 #include <limits>
 
 namespace vka
@@ -20,6 +21,23 @@ namespace vka
 		uint64_t imageOffset;
 	};
 
+	// copies into a fresh image, which is then left ready for fragment shaders to sample
+	static const CompiledRenderGraph& ImageUploadGraph()
+	{
+		static const CompiledRenderGraph compiled = []
+		{
+			RenderGraph graph;
+			auto image = graph.ImportImage(
+				"image",
+				VK_IMAGE_ASPECT_COLOR_BIT,
+				{ VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED },
+				ResourceState{ VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+			graph.AddPass("copy", { { image, { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL } } });
+			return graph.Compile();
+		}();
+		return compiled;
+	}
+
 	static UniqueImage2D CreateImage2D(VkDevice device,
 			VkCommandBuffer commandBuffer,
 			VkFence fence,
@@ -86,82 +104,31 @@ namespace vka
 
 		vkBeginCommandBuffer(commandBuffer, &cmdBufferBeginInfo);
 
-		// transition image layout for transfer
-		VkImageMemoryBarrier imageMemoryBarrier = {};
-		imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		imageMemoryBarrier.pNext = nullptr;
-		imageMemoryBarrier.srcAccessMask = VkAccessFlags(0);
-		imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		imageMemoryBarrier.srcQueueFamilyIndex = queueFamilyIndex;
-		imageMemoryBarrier.dstQueueFamilyIndex = queueFamilyIndex;
-		imageMemoryBarrier.image = image;
-		imageMemoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		imageMemoryBarrier.subresourceRange.baseMipLevel = 0;
-		imageMemoryBarrier.subresourceRange.levelCount = 1;
-		imageMemoryBarrier.subresourceRange.baseArrayLayer = 0;
-		imageMemoryBarrier.subresourceRange.layerCount = 1;
-
-		vkCmdPipelineBarrier(commandBuffer, 
-			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VkDependencyFlags(0),
-			0,
-			nullptr,
-			0,
-			nullptr,
-			1,
-			&imageMemoryBarrier);
-
-		// copy from host to device (to image)
-		VkBufferImageCopy bufferImageCopy = {};
-		bufferImageCopy.bufferOffset = 0;
-		bufferImageCopy.bufferRowLength = 0;
-		bufferImageCopy.bufferImageHeight = 0;
-		bufferImageCopy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		bufferImageCopy.imageSubresource.mipLevel = 0;
-		bufferImageCopy.imageSubresource.baseArrayLayer = 0;
-		bufferImageCopy.imageSubresource.layerCount = 1;
-		bufferImageCopy.imageOffset = {};
-		bufferImageCopy.imageExtent.width = bitmap.m_Width;
-		bufferImageCopy.imageExtent.height = bitmap.m_Height;
-		bufferImageCopy.imageExtent.depth = 1;
-
-		vkCmdCopyBufferToImage(commandBuffer, 
-			stagingBufferResult.buffer.get(),
-			image,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			1,
-			&bufferImageCopy);
-
-		// transition image for shader access
-		VkImageMemoryBarrier imageMemoryBarrier2 = {};
-		imageMemoryBarrier2.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		imageMemoryBarrier2.pNext = nullptr;
-		imageMemoryBarrier2.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		imageMemoryBarrier2.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-		imageMemoryBarrier2.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		imageMemoryBarrier2.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imageMemoryBarrier2.srcQueueFamilyIndex = queueFamilyIndex;
-		imageMemoryBarrier2.dstQueueFamilyIndex = queueFamilyIndex;
-		imageMemoryBarrier2.image = image;
-		imageMemoryBarrier2.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		imageMemoryBarrier2.subresourceRange.baseMipLevel = 0;
-		imageMemoryBarrier2.subresourceRange.levelCount = 1;
-		imageMemoryBarrier2.subresourceRange.baseArrayLayer = 0;
-		imageMemoryBarrier2.subresourceRange.layerCount = 1;
-
-		vkCmdPipelineBarrier(commandBuffer, 
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-			VkDependencyFlags(0),
-			0,
-			nullptr,
-			0,
-			nullptr,
-			1,
-			&imageMemoryBarrier2);
+		// the upload graph supplies both layout transitions around the copy
+		std::vector<VkImage> graphImages = { image };
+		ExecuteRenderGraph(commandBuffer, ImageUploadGraph(), graphImages, [&](size_t)
+		{
+			// copy from host to device (to image)
+			VkBufferImageCopy bufferImageCopy = {};
+			bufferImageCopy.bufferOffset = 0;
+			bufferImageCopy.bufferRowLength = 0;
+			bufferImageCopy.bufferImageHeight = 0;
+			bufferImageCopy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			bufferImageCopy.imageSubresource.mipLevel = 0;
+			bufferImageCopy.imageSubresource.baseArrayLayer = 0;
+			bufferImageCopy.imageSubresource.layerCount = 1;
+			bufferImageCopy.imageOffset = {};
+			bufferImageCopy.imageExtent.width = bitmap.m_Width;
+			bufferImageCopy.imageExtent.height = bitmap.m_Height;
+			bufferImageCopy.imageExtent.depth = 1;
+
+			vkCmdCopyBufferToImage(commandBuffer, 
+				stagingBufferResult.buffer.get(),
+				image,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				1,
+				&bufferImageCopy);
+		});
 
 		vkEndCommandBuffer(commandBuffer);
 
@@ -0,0 +1,99 @@
+#pragma once
+#include "Frustum.hpp"
+#include "glm/glm.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+
+namespace vka
+{
+// bounding spheres in SoA layout, padded to a multiple of eight with spheres
+// that no frustum accepts so the eight wide test needs no tail handling
+struct InstanceBounds
+{
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> radius;
+
+	void Clear()
+	{
+		centerX.clear();
+		centerY.clear();
+		centerZ.clear();
+		radius.clear();
+		count = 0;
+	}
+
+	// size before Pad was called
+	size_t size() const { return count; }
+
+	void Push(const glm::vec3 &center, float sphereRadius)
+	{
+		centerX.push_back(center.x);
+		centerY.push_back(center.y);
+		centerZ.push_back(center.z);
+		radius.push_back(sphereRadius);
+		count = centerX.size();
+	}
+
+	void Pad()
+	{
+		while (centerX.size() % 8 != 0)
+		{
+			centerX.push_back(0.f);
+			centerY.push_back(0.f);
+			centerZ.push_back(0.f);
+			radius.push_back(-std::numeric_limits<float>::max());
+		}
+	}
+
+private:
+	size_t count = 0;
+};
+
+// a local bounding sphere moved by modelMatrix; the radius grows with the
+// largest axis scale so the sphere stays conservative under non uniform scale
+static void TransformSphere(
+	const glm::mat4 &modelMatrix,
+	const glm::vec3 &center,
+	float radius,
+	glm::vec3 &worldCenter,
+	float &worldRadius)
+{
+	worldCenter = glm::vec3(modelMatrix * glm::vec4(center, 1.f));
+	auto scale = std::max({glm::length(glm::vec3(modelMatrix[0])),
+						   glm::length(glm::vec3(modelMatrix[1])),
+						   glm::length(glm::vec3(modelMatrix[2]))});
+	worldRadius = radius * scale;
+}
+
+// Writes 1 to visible[i] for each sphere inside the frustum and 0 otherwise.
+// Pads bounds first. Returns the visible count.
+static size_t CullSpheres(const Frustum &frustum, InstanceBounds &bounds, std::vector<uint8_t> &visible)
+{
+	bounds.Pad();
+	visible.resize(bounds.size());
+	size_t visibleCount = 0;
+	for (size_t offset = 0; offset < bounds.size(); offset += 8)
+	{
+		auto mask = SpheresInFrustum8(
+			frustum,
+			&bounds.centerX[offset],
+			&bounds.centerY[offset],
+			&bounds.centerZ[offset],
+			&bounds.radius[offset]);
+		auto end = std::min(offset + 8, bounds.size());
+		for (auto i = offset; i < end; ++i)
+		{
+			auto inside = (mask >> (i - offset)) & 1U;
+			visible[i] = static_cast<uint8_t>(inside);
+			visibleCount += inside;
+		}
+	}
+	return visibleCount;
+}
+} // namespace vka
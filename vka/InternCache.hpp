@@ -0,0 +1,290 @@
+#pragma once
+#include "vulkan/vulkan.h"
+#include "VulkanExtensions.hpp"
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+namespace vka
+{
+static void HashCombine(size_t& seed, size_t value)
+{
+	seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+template <typename T>
+static void HashValue(size_t& seed, const T& value)
+{
+	HashCombine(seed, std::hash<T>()(value));
+}
+
+// Create info reduced to the fields that decide what object is created, in a
+// canonical order, so equal objects described differently compare equal.
+struct SamplerKey
+{
+	VkSamplerCreateInfo info;
+
+	explicit SamplerKey(const VkSamplerCreateInfo& createInfo)
+		:
+		info(createInfo)
+	{
+		info.pNext = nullptr;
+	}
+
+	bool operator==(const SamplerKey& other) const
+	{
+		return info.flags == other.info.flags &&
+			info.magFilter == other.info.magFilter &&
+			info.minFilter == other.info.minFilter &&
+			info.mipmapMode == other.info.mipmapMode &&
+			info.addressModeU == other.info.addressModeU &&
+			info.addressModeV == other.info.addressModeV &&
+			info.addressModeW == other.info.addressModeW &&
+			info.mipLodBias == other.info.mipLodBias &&
+			info.anisotropyEnable == other.info.anisotropyEnable &&
+			info.maxAnisotropy == other.info.maxAnisotropy &&
+			info.compareEnable == other.info.compareEnable &&
+			info.compareOp == other.info.compareOp &&
+			info.minLod == other.info.minLod &&
+			info.maxLod == other.info.maxLod &&
+			info.borderColor == other.info.borderColor &&
+			info.unnormalizedCoordinates == other.info.unnormalizedCoordinates;
+	}
+
+	size_t Hash() const
+	{
+		size_t seed = 0;
+		HashValue(seed, info.flags);
+		HashValue(seed, static_cast<int>(info.magFilter));
+		HashValue(seed, static_cast<int>(info.minFilter));
+		HashValue(seed, static_cast<int>(info.mipmapMode));
+		HashValue(seed, static_cast<int>(info.addressModeU));
+		HashValue(seed, static_cast<int>(info.addressModeV));
+		HashValue(seed, static_cast<int>(info.addressModeW));
+		HashValue(seed, info.mipLodBias);
+		HashValue(seed, info.anisotropyEnable);
+		HashValue(seed, info.maxAnisotropy);
+		HashValue(seed, info.compareEnable);
+		HashValue(seed, static_cast<int>(info.compareOp));
+		HashValue(seed, info.minLod);
+		HashValue(seed, info.maxLod);
+		HashValue(seed, static_cast<int>(info.borderColor));
+		HashValue(seed, info.unnormalizedCoordinates);
+		return seed;
+	}
+};
+
+struct DescriptorSetLayoutKey
+{
+	struct Binding
+	{
+		uint32_t binding;
+		VkDescriptorType descriptorType;
+		uint32_t descriptorCount;
+		VkShaderStageFlags stageFlags;
+		VkDescriptorBindingFlagsEXT bindingFlags;
+		std::vector<VkSampler> immutableSamplers;
+
+		bool operator==(const Binding& other) const
+		{
+			return binding == other.binding &&
+				descriptorType == other.descriptorType &&
+				descriptorCount == other.descriptorCount &&
+				stageFlags == other.stageFlags &&
+				bindingFlags == other.bindingFlags &&
+				immutableSamplers == other.immutableSamplers;
+		}
+	};
+	VkDescriptorSetLayoutCreateFlags flags;
+	std::vector<Binding> bindings;
+
+	explicit DescriptorSetLayoutKey(const VkDescriptorSetLayoutCreateInfo& createInfo)
+		:
+		flags(createInfo.flags)
+	{
+		// binding flags are the one extension struct that changes the layout
+		struct ChainHeader
+		{
+			VkStructureType sType;
+			const ChainHeader* pNext;
+		};
+		const VkDescriptorSetLayoutBindingFlagsCreateInfoEXT* flagsInfo = nullptr;
+		for (auto next = static_cast<const ChainHeader*>(createInfo.pNext); next != nullptr; next = next->pNext)
+		{
+			if (next->sType == VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT)
+			{
+				flagsInfo = reinterpret_cast<const VkDescriptorSetLayoutBindingFlagsCreateInfoEXT*>(next);
+			}
+		}
+		for (uint32_t i = 0; i < createInfo.bindingCount; ++i)
+		{
+			const auto& layoutBinding = createInfo.pBindings[i];
+			Binding binding = {
+				layoutBinding.binding,
+				layoutBinding.descriptorType,
+				layoutBinding.descriptorCount,
+				layoutBinding.stageFlags,
+				flagsInfo != nullptr && i < flagsInfo->bindingCount ? flagsInfo->pBindingFlags[i] : 0,
+				{} };
+			// immutable samplers only apply to sampler bindings
+			auto samplerType = layoutBinding.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+				layoutBinding.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			if (samplerType && layoutBinding.pImmutableSamplers != nullptr)
+			{
+				binding.immutableSamplers.assign(
+					layoutBinding.pImmutableSamplers,
+					layoutBinding.pImmutableSamplers + layoutBinding.descriptorCount);
+			}
+			bindings.push_back(std::move(binding));
+		}
+		// binding order in the create info carries no meaning
+		std::sort(bindings.begin(), bindings.end(),
+			[](const Binding& a, const Binding& b) { return a.binding < b.binding; });
+	}
+
+	bool operator==(const DescriptorSetLayoutKey& other) const
+	{
+		return flags == other.flags && bindings == other.bindings;
+	}
+
+	size_t Hash() const
+	{
+		size_t seed = 0;
+		HashValue(seed, flags);
+		for (const auto& binding : bindings)
+		{
+			HashValue(seed, binding.binding);
+			HashValue(seed, static_cast<int>(binding.descriptorType));
+			HashValue(seed, binding.descriptorCount);
+			HashValue(seed, binding.stageFlags);
+			HashValue(seed, binding.bindingFlags);
+			for (auto sampler : binding.immutableSamplers)
+			{
+				HashValue(seed, sampler);
+			}
+		}
+		return seed;
+	}
+};
+
+// set layouts are interned themselves, so comparing their handles compares content
+struct PipelineLayoutKey
+{
+	VkPipelineLayoutCreateFlags flags;
+	std::vector<VkDescriptorSetLayout> setLayouts;
+	std::vector<VkPushConstantRange> pushConstantRanges;
+
+	explicit PipelineLayoutKey(const VkPipelineLayoutCreateInfo& createInfo)
+		:
+		flags(createInfo.flags),
+		setLayouts(createInfo.pSetLayouts, createInfo.pSetLayouts + createInfo.setLayoutCount),
+		pushConstantRanges(createInfo.pPushConstantRanges, createInfo.pPushConstantRanges + createInfo.pushConstantRangeCount)
+	{
+		std::sort(pushConstantRanges.begin(), pushConstantRanges.end(),
+			[](const VkPushConstantRange& a, const VkPushConstantRange& b)
+		{
+			if (a.offset != b.offset) return a.offset < b.offset;
+			if (a.size != b.size) return a.size < b.size;
+			return a.stageFlags < b.stageFlags;
+		});
+	}
+
+	bool operator==(const PipelineLayoutKey& other) const
+	{
+		return flags == other.flags &&
+			setLayouts == other.setLayouts &&
+			std::equal(pushConstantRanges.begin(), pushConstantRanges.end(),
+				other.pushConstantRanges.begin(), other.pushConstantRanges.end(),
+				[](const VkPushConstantRange& a, const VkPushConstantRange& b)
+		{
+			return a.offset == b.offset && a.size == b.size && a.stageFlags == b.stageFlags;
+		});
+	}
+
+	size_t Hash() const
+	{
+		size_t seed = 0;
+		HashValue(seed, flags);
+		for (auto setLayout : setLayouts)
+		{
+			HashValue(seed, setLayout);
+		}
+		for (const auto& range : pushConstantRanges)
+		{
+			HashValue(seed, range.stageFlags);
+			HashValue(seed, range.offset);
+			HashValue(seed, range.size);
+		}
+		return seed;
+	}
+};
+
+// Maps create info keys to the one handle created for them and counts the
+// users of each handle. Not thread safe; DeviceManager locks around it.
+template <typename Key, typename Handle>
+class InternCache
+{
+public:
+	// returns the interned handle and adds a reference, or a null handle
+	Handle Acquire(const Key& key)
+	{
+		auto found = handles.find(key);
+		if (found == handles.end())
+		{
+			return Handle();
+		}
+		++entries.at(found->second).references;
+		return found->second;
+	}
+
+	// records a newly created handle with one reference
+	void Insert(const Key& key, Handle handle)
+	{
+		handles.emplace(key, handle);
+		entries.emplace(handle, Entry{ 1, key });
+	}
+
+	// drops a reference, returns true when it was the last and the handle
+	// should be destroyed; handles the cache does not know are always destroyed
+	bool Release(Handle handle)
+	{
+		auto entry = entries.find(handle);
+		if (entry == entries.end())
+		{
+			return true;
+		}
+		if (--entry->second.references > 0)
+		{
+			return false;
+		}
+		handles.erase(entry->second.key);
+		entries.erase(entry);
+		return true;
+	}
+
+	size_t GetReferenceCount(Handle handle) const
+	{
+		auto entry = entries.find(handle);
+		return entry == entries.end() ? 0 : entry->second.references;
+	}
+
+	size_t size() const { return handles.size(); }
+
+private:
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const { return key.Hash(); }
+	};
+	struct Entry
+	{
+		size_t references;
+		Key key;
+	};
+	std::unordered_map<Key, Handle, KeyHash> handles;
+	std::unordered_map<Handle, Entry> entries;
+};
+} // namespace vka
@@ -0,0 +1,118 @@
+#pragma once
+#include "GLTF.hpp"
+#include "MeshSimplify.hpp"
+#include "glm/glm.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+namespace vka
+{
+// each LOD aims for half the triangles of the previous one
+constexpr float LODReductionRatio = 0.5f;
+// a level is dropped if it removes less than this fraction of the previous level
+constexpr float LODMinimumReduction = 0.1f;
+// simplification gives up once the error exceeds this fraction of the bounding radius
+constexpr float LODMaxError = 0.25f;
+// projected error in pixels that is considered invisible at a bias of 0
+constexpr float LODPixelError = 1.f;
+
+static void ComputeMeshBounds(Mesh &mesh)
+{
+	auto sphere = ComputeBoundingSphere(mesh.positions);
+	mesh.boundsCenter = sphere.center;
+	mesh.boundsRadius = sphere.radius;
+}
+
+// fills mesh.lods with up to lodCount simplified index lists, stopping early when
+// the mesh cannot be reduced any further within LODMaxError
+static void GenerateLODs(Mesh &mesh, size_t lodCount)
+{
+	ComputeMeshBounds(mesh);
+	mesh.lods.clear();
+
+	const auto *source = &mesh.indices;
+	auto sourceError = 0.f;
+	for (size_t level = 0; level < lodCount; ++level)
+	{
+		auto targetTriangles = static_cast<size_t>(source->size() / 3 * LODReductionRatio);
+		if (targetTriangles == 0)
+		{
+			break;
+		}
+
+		MeshLOD lod;
+		lod.firstIndex = 0;
+		lod.error = 0.f;
+		lod.indices = SimplifyMesh(
+			mesh.positions,
+			mesh.normals,
+			*source,
+			targetTriangles * 3,
+			LODMaxError,
+			&lod.error);
+		lod.error = std::max(lod.error, sourceError);
+
+		auto reduction = 1.f - static_cast<float>(lod.indices.size()) / source->size();
+		if (lod.indices.empty() || reduction < LODMinimumReduction)
+		{
+			break;
+		}
+
+		sourceError = lod.error;
+		mesh.lods.push_back(std::move(lod));
+		source = &mesh.lods.back().indices;
+	}
+}
+
+// picks the coarsest LOD whose simplification error projects to less than
+// LODPixelError * 2^lodBias pixels; 0 is the full mesh. projectionScale is
+// Camera3D::getProjectionScale(), taken by value so workers can call this
+// without touching the camera's lazily cached matrices
+static size_t SelectLOD(
+	const Mesh &mesh,
+	const glm::mat4 &modelMatrix,
+	const glm::vec3 &cameraPosition,
+	float projectionScale,
+	float lodBias)
+{
+	if (mesh.lods.empty())
+	{
+		return 0;
+	}
+
+	auto worldCenter = glm::vec3(modelMatrix * glm::vec4(mesh.boundsCenter, 1.f));
+	auto scale = std::max({glm::length(glm::vec3(modelMatrix[0])),
+						   glm::length(glm::vec3(modelMatrix[1])),
+						   glm::length(glm::vec3(modelMatrix[2]))});
+	auto worldRadius = mesh.boundsRadius * scale;
+	auto distance = glm::length(worldCenter - cameraPosition) - worldRadius;
+	if (distance <= 0.f)
+	{
+		return 0;
+	}
+
+	auto projectedRadius = worldRadius * projectionScale / distance;
+	auto threshold = LODPixelError * std::exp2(lodBias);
+	for (auto level = mesh.lods.size(); level > 0; --level)
+	{
+		if (mesh.lods[level - 1].error * projectedRadius <= threshold)
+		{
+			return level;
+		}
+	}
+	return 0;
+}
+
+// first index and index count of a LOD within the shared index buffer
+static std::pair<size_t, size_t> GetLODRange(const Mesh &mesh, size_t lod)
+{
+	if (lod == 0 || lod > mesh.lods.size())
+	{
+		return {mesh.firstIndex, mesh.indices.size()};
+	}
+	const auto &level = mesh.lods[lod - 1];
+	return {level.firstIndex, level.indices.size()};
+}
+} // namespace vka
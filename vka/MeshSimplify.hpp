@@ -0,0 +1,319 @@
+#pragma once
+#include "glm/glm.hpp"
+
+#include <vector>
+#include <array>
+#include <map>
+#include <tuple>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace vka
+{
+struct BoundingSphere
+{
+	glm::vec3 center = glm::vec3(0.f);
+	float radius = 0.f;
+};
+
+// sphere around the center of the axis aligned bounds, not the minimal sphere
+static BoundingSphere ComputeBoundingSphere(const std::vector<glm::vec3> &positions)
+{
+	BoundingSphere sphere;
+	if (positions.size() == 0)
+	{
+		return sphere;
+	}
+	auto minimum = positions[0];
+	auto maximum = positions[0];
+	for (const auto &position : positions)
+	{
+		minimum = glm::min(minimum, position);
+		maximum = glm::max(maximum, position);
+	}
+	sphere.center = (minimum + maximum) * 0.5f;
+	for (const auto &position : positions)
+	{
+		sphere.radius = std::max(sphere.radius, glm::length(position - sphere.center));
+	}
+	return sphere;
+}
+
+namespace detail
+{
+// area weighted symmetric 4x4 error quadric, stored as the upper triangle
+struct Quadric
+{
+	std::array<double, 10> m = {};
+	double weight = 0.0;
+
+	static Quadric FromPlane(double a, double b, double c, double d, double area)
+	{
+		Quadric q;
+		q.m = {a * a, a * b, a * c, a * d,
+			   b * b, b * c, b * d,
+			   c * c, c * d,
+			   d * d};
+		for (auto &element : q.m)
+		{
+			element *= area;
+		}
+		q.weight = area;
+		return q;
+	}
+
+	Quadric &operator+=(const Quadric &other)
+	{
+		for (auto i = 0U; i < m.size(); ++i)
+		{
+			m[i] += other.m[i];
+		}
+		weight += other.weight;
+		return *this;
+	}
+
+	// mean squared distance from p to the accumulated planes
+	double Error(const glm::vec3 &p) const
+	{
+		if (weight <= 0.0)
+		{
+			return 0.0;
+		}
+		double x = p.x, y = p.y, z = p.z;
+		auto error = m[0] * x * x + 2 * m[1] * x * y + 2 * m[2] * x * z + 2 * m[3] * x +
+					 m[4] * y * y + 2 * m[5] * y * z + 2 * m[6] * y +
+					 m[7] * z * z + 2 * m[8] * z +
+					 m[9];
+		return std::max(error / weight, 0.0);
+	}
+};
+
+struct Collapse
+{
+	uint32_t from;
+	uint32_t to;
+	double cost;
+};
+
+// maps every vertex to the first vertex sharing its exact position, so that
+// flat shaded meshes (split normals) are simplified as one connected surface
+static std::vector<uint32_t> WeldPositions(const std::vector<glm::vec3> &positions)
+{
+	std::vector<uint32_t> remap(positions.size());
+	std::map<std::tuple<float, float, float>, uint32_t> firstByPosition;
+	for (uint32_t i = 0; i < positions.size(); ++i)
+	{
+		const auto &p = positions[i];
+		auto key = std::make_tuple(p.x, p.y, p.z);
+		auto inserted = firstByPosition.emplace(key, i);
+		remap[i] = inserted.first->second;
+	}
+	return remap;
+}
+
+static glm::vec3 TriangleNormal(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c)
+{
+	return glm::cross(b - a, c - a);
+}
+} // namespace detail
+
+// Quadric error simplification restricted to collapsing vertices onto existing
+// neighbours, so the result indexes the same vertex data as the input.
+// targetError is relative to the mesh bounding radius. The achieved relative
+// error is written to resultError when it is provided.
+template <typename IndexT>
+static std::vector<IndexT> SimplifyMesh(
+	const std::vector<glm::vec3> &positions,
+	const std::vector<glm::vec3> &normals,
+	const std::vector<IndexT> &indices,
+	size_t targetIndexCount,
+	float targetError,
+	float *resultError = nullptr)
+{
+	auto vertexCount = positions.size();
+	auto radius = ComputeBoundingSphere(positions).radius;
+	auto maxCost = static_cast<double>(targetError * radius);
+	maxCost *= maxCost;
+
+	auto weld = detail::WeldPositions(positions);
+
+	// original vertices belonging to each welded vertex
+	std::vector<std::vector<uint32_t>> wedges(vertexCount);
+	for (uint32_t i = 0; i < vertexCount; ++i)
+	{
+		wedges[weld[i]].push_back(i);
+	}
+
+	// corners hold original vertex indices, welded ids are looked up on demand
+	std::vector<uint32_t> corners(indices.begin(), indices.end());
+	std::vector<detail::Quadric> quadrics(vertexCount);
+	std::map<std::pair<uint32_t, uint32_t>, uint32_t> edgeUse;
+	for (size_t t = 0; t + 2 < corners.size(); t += 3)
+	{
+		std::array<uint32_t, 3> w = {weld[corners[t]], weld[corners[t + 1]], weld[corners[t + 2]]};
+		auto n = detail::TriangleNormal(positions[w[0]], positions[w[1]], positions[w[2]]);
+		auto length = glm::length(n);
+		if (length > 0.f)
+		{
+			n /= length;
+			auto d = -glm::dot(n, positions[w[0]]);
+			auto plane = detail::Quadric::FromPlane(n.x, n.y, n.z, d, length * 0.5f);
+			for (auto v : w)
+			{
+				quadrics[v] += plane;
+			}
+		}
+		for (auto e = 0U; e < 3; ++e)
+		{
+			auto a = w[e];
+			auto b = w[(e + 1) % 3];
+			++edgeUse[std::make_pair(std::min(a, b), std::max(a, b))];
+		}
+	}
+
+	// vertices on open edges are locked to keep silhouettes of flat meshes intact
+	std::vector<bool> locked(vertexCount, false);
+	for (const auto &[edge, useCount] : edgeUse)
+	{
+		if (useCount == 1)
+		{
+			locked[edge.first] = true;
+			locked[edge.second] = true;
+		}
+	}
+
+	double achievedCost = 0.0;
+	while (corners.size() > targetIndexCount)
+	{
+		std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+		std::vector<detail::Collapse> collapses;
+		for (uint32_t t = 0; t < corners.size(); t += 3)
+		{
+			for (auto e = 0U; e < 3; ++e)
+			{
+				auto a = weld[corners[t + e]];
+				auto b = weld[corners[t + (e + 1) % 3]];
+				vertexTriangles[a].push_back(t);
+				for (auto [from, to] : {std::make_pair(a, b), std::make_pair(b, a)})
+				{
+					if (locked[from])
+					{
+						continue;
+					}
+					auto quadric = quadrics[from];
+					quadric += quadrics[to];
+					collapses.push_back({from, to, quadric.Error(positions[to])});
+				}
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(),
+				  [](const auto &l, const auto &r) { return l.cost < r.cost; });
+
+		std::vector<bool> touched(vertexCount, false);
+		std::vector<uint32_t> collapseTarget(vertexCount);
+		for (uint32_t i = 0; i < vertexCount; ++i)
+		{
+			collapseTarget[i] = i;
+		}
+		auto remainingIndices = corners.size();
+		auto collapsed = false;
+		for (const auto &collapse : collapses)
+		{
+			if (collapse.cost > maxCost || remainingIndices <= targetIndexCount)
+			{
+				break;
+			}
+			if (touched[collapse.from] || touched[collapse.to])
+			{
+				continue;
+			}
+
+			// reject collapses that would flip a surviving triangle
+			auto removedTriangles = 0U;
+			auto flips = false;
+			for (auto t : vertexTriangles[collapse.from])
+			{
+				std::array<uint32_t, 3> w = {weld[corners[t]], weld[corners[t + 1]], weld[corners[t + 2]]};
+				if (std::find(w.begin(), w.end(), collapse.to) != w.end())
+				{
+					++removedTriangles;
+					continue;
+				}
+				auto before = detail::TriangleNormal(positions[w[0]], positions[w[1]], positions[w[2]]);
+				std::replace(w.begin(), w.end(), collapse.from, collapse.to);
+				auto after = detail::TriangleNormal(positions[w[0]], positions[w[1]], positions[w[2]]);
+				if (glm::dot(before, after) <= 0.f)
+				{
+					flips = true;
+					break;
+				}
+			}
+			if (flips)
+			{
+				continue;
+			}
+
+			collapseTarget[collapse.from] = collapse.to;
+			quadrics[collapse.to] += quadrics[collapse.from];
+			for (auto t : vertexTriangles[collapse.from])
+			{
+				for (auto c = 0U; c < 3; ++c)
+				{
+					touched[weld[corners[t + c]]] = true;
+				}
+			}
+			remainingIndices -= removedTriangles * 3;
+			achievedCost = std::max(achievedCost, collapse.cost);
+			collapsed = true;
+		}
+
+		if (!collapsed)
+		{
+			break;
+		}
+
+		// move corners onto their collapse targets, picking the wedge whose normal
+		// best matches the original so hard edges survive where possible
+		std::vector<uint32_t> simplified;
+		simplified.reserve(remainingIndices);
+		for (size_t t = 0; t < corners.size(); t += 3)
+		{
+			std::array<uint32_t, 3> triangle;
+			std::array<uint32_t, 3> w;
+			for (auto c = 0U; c < 3; ++c)
+			{
+				auto original = corners[t + c];
+				w[c] = collapseTarget[weld[original]];
+				triangle[c] = original;
+				if (w[c] != weld[original])
+				{
+					auto bestDot = -std::numeric_limits<float>::max();
+					for (auto candidate : wedges[w[c]])
+					{
+						auto d = glm::dot(normals[candidate], normals[original]);
+						if (d > bestDot)
+						{
+							bestDot = d;
+							triangle[c] = candidate;
+						}
+					}
+				}
+			}
+			if (w[0] == w[1] || w[1] == w[2] || w[2] == w[0])
+			{
+				continue;
+			}
+			simplified.insert(simplified.end(), triangle.begin(), triangle.end());
+		}
+		corners = std::move(simplified);
+	}
+
+	if (resultError != nullptr)
+	{
+		*resultError = radius > 0.f ? static_cast<float>(std::sqrt(achievedCost)) / radius : 0.f;
+	}
+	return std::vector<IndexT>(corners.begin(), corners.end());
+}
+} // namespace vka
@@ -0,0 +1,353 @@
+#pragma once
+#include "GLTF.hpp"
+#include "LOD.hpp"
+#include "MeshSimplify.hpp"
+#include "Frustum.hpp"
+#include "glm/glm.hpp"
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+
+namespace vka
+{
+constexpr size_t MeshletMaxVertices = 64U;
+constexpr size_t MeshletMaxTriangles = 124U;
+
+// first index and index count within the shared index buffer
+using IndexRange = std::pair<size_t, size_t>;
+
+namespace detail
+{
+static void ComputeMeshletBounds(
+	Meshlet &meshlet,
+	const std::vector<glm::vec3> &positions,
+	const uint32_t *indices)
+{
+	std::vector<glm::vec3> meshletPositions;
+	meshletPositions.reserve(meshlet.indexCount);
+	for (size_t i = 0; i < meshlet.indexCount; ++i)
+	{
+		meshletPositions.push_back(positions[indices[i]]);
+	}
+	auto sphere = ComputeBoundingSphere(meshletPositions);
+	meshlet.center = sphere.center;
+	meshlet.radius = sphere.radius;
+
+	std::vector<glm::vec3> normals;
+	auto axis = glm::vec3(0.f);
+	for (size_t i = 0; i + 2 < meshletPositions.size(); i += 3)
+	{
+		auto n = TriangleNormal(meshletPositions[i], meshletPositions[i + 1], meshletPositions[i + 2]);
+		auto length = glm::length(n);
+		if (length > 0.f)
+		{
+			normals.push_back(n / length);
+			axis += normals.back();
+		}
+	}
+
+	// a cutoff of one can never satisfy the backface test
+	meshlet.coneAxis = glm::vec3(0.f);
+	meshlet.coneCutoff = 1.f;
+	auto axisLength = glm::length(axis);
+	if (normals.empty() || axisLength <= 0.f)
+	{
+		return;
+	}
+	axis /= axisLength;
+	auto minimumDot = 1.f;
+	for (const auto &n : normals)
+	{
+		minimumDot = std::min(minimumDot, glm::dot(axis, n));
+	}
+	if (minimumDot <= 0.f)
+	{
+		return;
+	}
+	meshlet.coneAxis = axis;
+	meshlet.coneCutoff = std::sqrt(1.f - minimumDot * minimumDot);
+}
+
+// Bit i is set when cluster offset + i has at least one triangle that may face
+// the camera. A cluster is backfacing when every point in its sphere sees every
+// normal in its cone from behind.
+static uint32_t ConesVisible4(const MeshletBounds &bounds, size_t offset, const glm::vec3 &camera)
+{
+#ifdef VKA_SSE
+	auto dx = _mm_sub_ps(_mm_loadu_ps(&bounds.centerX[offset]), _mm_set1_ps(camera.x));
+	auto dy = _mm_sub_ps(_mm_loadu_ps(&bounds.centerY[offset]), _mm_set1_ps(camera.y));
+	auto dz = _mm_sub_ps(_mm_loadu_ps(&bounds.centerZ[offset]), _mm_set1_ps(camera.z));
+	auto distance = _mm_sqrt_ps(_mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+		_mm_mul_ps(dz, dz)));
+	auto alongAxis = _mm_add_ps(
+		_mm_add_ps(
+			_mm_mul_ps(dx, _mm_loadu_ps(&bounds.coneAxisX[offset])),
+			_mm_mul_ps(dy, _mm_loadu_ps(&bounds.coneAxisY[offset]))),
+		_mm_mul_ps(dz, _mm_loadu_ps(&bounds.coneAxisZ[offset])));
+	auto limit = _mm_add_ps(
+		_mm_mul_ps(_mm_loadu_ps(&bounds.coneCutoff[offset]), distance),
+		_mm_loadu_ps(&bounds.radius[offset]));
+	return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmplt_ps(alongAxis, limit)));
+#else
+	uint32_t mask = 0;
+	for (auto i = 0U; i < 4; ++i)
+	{
+		auto j = offset + i;
+		auto d = glm::vec3(bounds.centerX[j], bounds.centerY[j], bounds.centerZ[j]) - camera;
+		auto axis = glm::vec3(bounds.coneAxisX[j], bounds.coneAxisY[j], bounds.coneAxisZ[j]);
+		if (glm::dot(d, axis) < bounds.coneCutoff[j] * glm::length(d) + bounds.radius[j])
+		{
+			mask |= 1U << i;
+		}
+	}
+	return mask;
+#endif
+}
+} // namespace detail
+
+// Splits a triangle list into clusters of at most maxVertices unique vertices and
+// maxTriangles triangles. Clusters grow greedily across position-welded
+// neighbours, preferring triangles that add the fewest vertices. indices is
+// reordered in place so that each cluster is a contiguous range.
+template <typename IndexT>
+static std::vector<Meshlet> BuildMeshlets(
+	const std::vector<glm::vec3> &positions,
+	std::vector<IndexT> &indices,
+	size_t maxVertices = MeshletMaxVertices,
+	size_t maxTriangles = MeshletMaxTriangles)
+{
+	constexpr auto Invalid = std::numeric_limits<uint32_t>::max();
+	auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	auto weld = detail::WeldPositions(positions);
+
+	std::vector<std::vector<uint32_t>> vertexTriangles(positions.size());
+	for (uint32_t t = 0; t < triangleCount; ++t)
+	{
+		for (auto c = 0U; c < 3; ++c)
+		{
+			vertexTriangles[weld[indices[t * 3 + c]]].push_back(t);
+		}
+	}
+
+	std::vector<uint32_t> reordered;
+	reordered.reserve(triangleCount * 3);
+	std::vector<Meshlet> meshlets;
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<bool> inMeshlet(positions.size(), false);
+	std::vector<uint32_t> meshletVertices;
+	std::vector<uint32_t> candidates;
+	size_t meshletTriangles = 0;
+	uint32_t nextSeed = 0;
+
+	auto newVertexCount = [&](uint32_t t) {
+		size_t count = 0;
+		for (auto c = 0U; c < 3; ++c)
+		{
+			auto v = indices[t * 3 + c];
+			auto repeated = (c > 0 && indices[t * 3] == v) || (c > 1 && indices[t * 3 + 1] == v);
+			if (!inMeshlet[v] && !repeated)
+			{
+				++count;
+			}
+		}
+		return count;
+	};
+
+	auto finishMeshlet = [&]() {
+		Meshlet meshlet;
+		meshlet.indexCount = meshletTriangles * 3;
+		meshlet.firstIndex = reordered.size() - meshlet.indexCount;
+		detail::ComputeMeshletBounds(meshlet, positions, reordered.data() + meshlet.firstIndex);
+		meshlets.push_back(meshlet);
+		for (auto v : meshletVertices)
+		{
+			inMeshlet[v] = false;
+		}
+		meshletVertices.clear();
+		candidates.clear();
+		meshletTriangles = 0;
+	};
+
+	for (;;)
+	{
+		auto best = Invalid;
+		if (meshletTriangles < maxTriangles)
+		{
+			candidates.erase(
+				std::remove_if(candidates.begin(), candidates.end(), [&](uint32_t t) { return emitted[t]; }),
+				candidates.end());
+			auto bestNew = std::numeric_limits<size_t>::max();
+			for (auto t : candidates)
+			{
+				auto added = newVertexCount(t);
+				if (meshletVertices.size() + added > maxVertices)
+				{
+					continue;
+				}
+				if (added < bestNew || (added == bestNew && t < best))
+				{
+					best = t;
+					bestNew = added;
+				}
+			}
+		}
+
+		if (best == Invalid)
+		{
+			if (meshletTriangles > 0)
+			{
+				finishMeshlet();
+				continue;
+			}
+			while (nextSeed < triangleCount && emitted[nextSeed])
+			{
+				++nextSeed;
+			}
+			if (nextSeed == triangleCount)
+			{
+				break;
+			}
+			best = nextSeed;
+		}
+
+		emitted[best] = true;
+		++meshletTriangles;
+		for (auto c = 0U; c < 3; ++c)
+		{
+			auto v = static_cast<uint32_t>(indices[best * 3 + c]);
+			reordered.push_back(v);
+			if (!inMeshlet[v])
+			{
+				inMeshlet[v] = true;
+				meshletVertices.push_back(v);
+			}
+			for (auto neighbour : vertexTriangles[weld[v]])
+			{
+				if (!emitted[neighbour])
+				{
+					candidates.push_back(neighbour);
+				}
+			}
+		}
+	}
+	if (meshletTriangles > 0)
+	{
+		finishMeshlet();
+	}
+
+	std::transform(reordered.begin(), reordered.end(), indices.begin(),
+				   [](uint32_t v) { return static_cast<IndexT>(v); });
+	return meshlets;
+}
+
+static MeshletBounds BuildMeshletBounds(const std::vector<Meshlet> &meshlets)
+{
+	MeshletBounds bounds;
+	auto paddedCount = (meshlets.size() + 3) / 4 * 4;
+	for (size_t i = 0; i < paddedCount; ++i)
+	{
+		Meshlet meshlet = {};
+		meshlet.radius = -std::numeric_limits<float>::max();
+		meshlet.coneCutoff = 1.f;
+		if (i < meshlets.size())
+		{
+			meshlet = meshlets[i];
+		}
+		bounds.centerX.push_back(meshlet.center.x);
+		bounds.centerY.push_back(meshlet.center.y);
+		bounds.centerZ.push_back(meshlet.center.z);
+		bounds.radius.push_back(meshlet.radius);
+		bounds.coneAxisX.push_back(meshlet.coneAxis.x);
+		bounds.coneAxisY.push_back(meshlet.coneAxis.y);
+		bounds.coneAxisZ.push_back(meshlet.coneAxis.z);
+		bounds.coneCutoff.push_back(meshlet.coneCutoff);
+	}
+	return bounds;
+}
+
+// meshes that fit in a single cluster are left without meshlets and drawn whole
+static void GenerateMeshlets(Mesh &mesh)
+{
+	mesh.meshlets.clear();
+	mesh.meshletBounds = MeshletBounds();
+	if (mesh.indices.size() / 3 <= MeshletMaxTriangles)
+	{
+		return;
+	}
+	mesh.meshlets = BuildMeshlets(mesh.positions, mesh.indices);
+	mesh.meshletBounds = BuildMeshletBounds(mesh.meshlets);
+}
+
+// Appends the index ranges of the clusters that survive frustum and backface
+// cone culling. Culling runs in object space so non uniform scale stays exact.
+// Adjacent surviving clusters are merged into a single range.
+static void CullMeshlets(
+	const Mesh &mesh,
+	const glm::mat4 &modelMatrix,
+	const glm::mat4 &viewProjection,
+	const glm::vec3 &cameraPosition,
+	std::vector<IndexRange> &ranges)
+{
+	auto frustum = FrustumFromMatrix(viewProjection * modelMatrix);
+	auto camera = glm::vec3(glm::inverse(modelMatrix) * glm::vec4(cameraPosition, 1.f));
+	const auto &bounds = mesh.meshletBounds;
+
+	for (size_t offset = 0; offset < mesh.meshlets.size(); offset += 4)
+	{
+		auto visible = SpheresInFrustum4(
+			frustum,
+			&bounds.centerX[offset],
+			&bounds.centerY[offset],
+			&bounds.centerZ[offset],
+			&bounds.radius[offset]);
+		if (visible == 0)
+		{
+			continue;
+		}
+		visible &= detail::ConesVisible4(bounds, offset, camera);
+
+		auto end = std::min(offset + 4, mesh.meshlets.size());
+		for (auto i = offset; i < end; ++i)
+		{
+			if ((visible & (1U << (i - offset))) == 0)
+			{
+				continue;
+			}
+			const auto &meshlet = mesh.meshlets[i];
+			auto firstIndex = mesh.firstIndex + meshlet.firstIndex;
+			if (!ranges.empty() && ranges.back().first + ranges.back().second == firstIndex)
+			{
+				ranges.back().second += meshlet.indexCount;
+			}
+			else
+			{
+				ranges.push_back({firstIndex, meshlet.indexCount});
+			}
+		}
+	}
+}
+
+// replaces ranges with what should be drawn of the given LOD; only the full
+// detail level is clustered, coarser levels are drawn whole
+static void GetDrawRanges(
+	const Mesh &mesh,
+	size_t lod,
+	const glm::mat4 &modelMatrix,
+	const glm::mat4 &viewProjection,
+	const glm::vec3 &cameraPosition,
+	std::vector<IndexRange> &ranges)
+{
+	ranges.clear();
+	if (lod == 0 && !mesh.meshlets.empty())
+	{
+		CullMeshlets(mesh, modelMatrix, viewProjection, cameraPosition, ranges);
+		return;
+	}
+	ranges.push_back(GetLODRange(mesh, lod));
+}
+} // namespace vka
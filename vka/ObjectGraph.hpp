@@ -0,0 +1,181 @@
+#pragma once
+#include "ThreadPool.hpp"
+#include "nlohmann/json.hpp"
+#include "boost/graph/adjacency_list.hpp"
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <exception>
+#include <stdexcept>
+#include <functional>
+
+namespace vka
+{
+enum class VulkanType
+{
+	Instance,
+	PhysicalDevice,
+	Surface,
+	Device,
+	RenderPass,
+	Swapchain,
+	ShaderModule,
+	DescriptorSetLayout,
+	DescriptorPool,
+	DescriptorSet,
+	PushConstantRange,
+	PipelineLayout,
+	Pipeline,
+	CommandPool,
+	CommandBuffer
+};
+
+static VulkanType VulkanTypeFromString(const std::string& name)
+{
+	static const std::pair<const char*, VulkanType> names[] = {
+		{ "Instance", VulkanType::Instance },
+		{ "PhysicalDevice", VulkanType::PhysicalDevice },
+		{ "Surface", VulkanType::Surface },
+		{ "Device", VulkanType::Device },
+		{ "RenderPass", VulkanType::RenderPass },
+		{ "Swapchain", VulkanType::Swapchain },
+		{ "ShaderModule", VulkanType::ShaderModule },
+		{ "DescriptorSetLayout", VulkanType::DescriptorSetLayout },
+		{ "DescriptorPool", VulkanType::DescriptorPool },
+		{ "DescriptorSet", VulkanType::DescriptorSet },
+		{ "PushConstantRange", VulkanType::PushConstantRange },
+		{ "PipelineLayout", VulkanType::PipelineLayout },
+		{ "Pipeline", VulkanType::Pipeline },
+		{ "CommandPool", VulkanType::CommandPool },
+		{ "CommandBuffer", VulkanType::CommandBuffer } };
+	for (const auto& [typeName, type] : names)
+	{
+		if (name == typeName)
+		{
+			return type;
+		}
+	}
+	throw std::runtime_error("Unknown vulkanType in object graph: " + name);
+}
+
+struct NodeProps
+{
+	VulkanType vulkanType;
+	std::string path;
+};
+
+// an edge from a to b means b is created from a
+using ObjectGraph = boost::adjacency_list<boost::vecS, boost::vecS, boost::bidirectionalS, NodeProps>;
+
+// reads the vertices and edges of config/dependencyGraph.json
+static ObjectGraph LoadObjectGraph(const nlohmann::json& graphJson)
+{
+	const auto& verticesJson = graphJson["vertices"];
+	ObjectGraph graph(verticesJson.size());
+	for (const auto& vertexJson : verticesJson)
+	{
+		size_t index = vertexJson["index"];
+		if (index >= verticesJson.size())
+		{
+			throw std::runtime_error("Object graph vertex index out of range");
+		}
+		graph[index] = NodeProps{ VulkanTypeFromString(vertexJson["vulkanType"]), vertexJson["path"] };
+	}
+	for (const auto& edgeJson : graphJson["edges"])
+	{
+		size_t start = edgeJson["start"];
+		size_t end = edgeJson["end"];
+		if (start >= verticesJson.size() || end >= verticesJson.size())
+		{
+			throw std::runtime_error("Object graph edge references a missing vertex");
+		}
+		boost::add_edge(start, end, graph);
+	}
+	return graph;
+}
+
+// Runs build(vertex, threadIndex) on the pool for every vertex isPending accepts,
+// each as soon as all of its pending dependencies have been built, so the total
+// time follows the longest chain rather than the vertex count. Vertices that are
+// not pending count as already built. The first exception thrown by build stops
+// its dependents and is rethrown here once running work has drained.
+template <typename IsPending, typename Build>
+static void BuildObjectGraph(ThreadPool& threadPool, const ObjectGraph& graph, IsPending&& isPending, Build&& build)
+{
+	auto vertexCount = boost::num_vertices(graph);
+	std::vector<bool> pending(vertexCount);
+	auto remaining = std::make_unique<std::atomic<size_t>[]>(vertexCount);
+	for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		pending[vertex] = isPending(vertex);
+	}
+	for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		size_t dependencies = 0;
+		for (auto [edge, end] = boost::in_edges(vertex, graph); edge != end; ++edge)
+		{
+			if (pending[boost::source(*edge, graph)])
+			{
+				++dependencies;
+			}
+		}
+		remaining[vertex] = dependencies;
+	}
+
+	std::atomic<size_t> builtCount = 0;
+	std::mutex errorMutex;
+	std::exception_ptr error;
+	std::function<void(size_t, size_t)> run = [&](size_t vertex, size_t threadIndex)
+	{
+		try
+		{
+			build(vertex, threadIndex);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(errorMutex);
+			if (!error)
+			{
+				error = std::current_exception();
+			}
+			return;
+		}
+		++builtCount;
+		for (auto [edge, end] = boost::out_edges(vertex, graph); edge != end; ++edge)
+		{
+			auto target = boost::target(*edge, graph);
+			if (pending[target] && --remaining[target] == 0)
+			{
+				threadPool.Enqueue([&run, target](size_t threadIndex) { run(target, threadIndex); });
+			}
+		}
+	};
+
+	size_t pendingCount = 0;
+	for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		if (!pending[vertex])
+		{
+			continue;
+		}
+		++pendingCount;
+		if (remaining[vertex] == 0)
+		{
+			threadPool.Enqueue([&run, vertex](size_t threadIndex) { run(vertex, threadIndex); });
+		}
+	}
+	threadPool.Wait();
+
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+	if (builtCount != pendingCount)
+	{
+		throw std::runtime_error("Object graph contains a dependency cycle");
+	}
+}
+} // namespace vka
@@ -0,0 +1,341 @@
+#pragma once
+#include "glm/glm.hpp"
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(VKA_SSE) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define VKA_SSE 1
+#endif
+#ifdef VKA_SSE
+#include <emmintrin.h>
+#endif
+
+namespace vka
+{
+// Low resolution depth buffer that occluder meshes are rasterized into on the
+// CPU, with a Hi-Z pyramid of per texel farthest depths for testing bounds.
+// Depth follows the [0, 1] clip convention, the buffer clears to the far plane.
+// Coverage is sampled at pixel centers, so an object peeking past an
+// occluder's silhouette by less than a pixel may be reported hidden.
+class OcclusionBuffer
+{
+public:
+	// width must be a multiple of four, rows are rasterized four pixels at a time
+	OcclusionBuffer(size_t width, size_t height)
+		: width(width), height(height)
+	{
+		if (width == 0 || height == 0 || width % 4 != 0)
+		{
+			throw std::runtime_error("Occlusion buffer width must be a nonzero multiple of four");
+		}
+		auto levelWidth = width;
+		auto levelHeight = height;
+		while (true)
+		{
+			levels.push_back({levelWidth, levelHeight, std::vector<float>(levelWidth * levelHeight, 1.f)});
+			if (levelWidth == 1 && levelHeight == 1)
+			{
+				break;
+			}
+			levelWidth = (levelWidth + 1) / 2;
+			levelHeight = (levelHeight + 1) / 2;
+		}
+	}
+
+	size_t GetWidth() const { return width; }
+	size_t GetHeight() const { return height; }
+	size_t GetLevelCount() const { return levels.size(); }
+
+	float GetDepth(size_t x, size_t y, size_t level = 0) const
+	{
+		const auto &hiz = levels.at(level);
+		return hiz.depth.at(y * hiz.width + x);
+	}
+
+	void Clear()
+	{
+		std::fill(levels[0].depth.begin(), levels[0].depth.end(), 1.f);
+	}
+
+	// rasterizes an indexed triangle list, keeping the nearest depth per pixel;
+	// triangles are clipped against the near plane and both faces are drawn
+	template <typename IndexT>
+	void RasterizeMesh(
+		const glm::mat4 &clipFromObject,
+		const std::vector<glm::vec3> &positions,
+		const std::vector<IndexT> &indices)
+	{
+		clipPositions.resize(positions.size());
+		std::transform(positions.begin(), positions.end(), clipPositions.begin(),
+					   [&clipFromObject](const glm::vec3 &p) { return clipFromObject * glm::vec4(p, 1.f); });
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			RasterizeClipTriangle(
+				clipPositions[indices[i]],
+				clipPositions[indices[i + 1]],
+				clipPositions[indices[i + 2]]);
+		}
+	}
+
+	// each level keeps the farthest depth of the up to four texels below it
+	void BuildHiZ()
+	{
+		for (size_t level = 1; level < levels.size(); ++level)
+		{
+			const auto &source = levels[level - 1];
+			auto &target = levels[level];
+			for (size_t y = 0; y < target.height; ++y)
+			{
+				auto y0 = y * 2;
+				auto y1 = std::min(y0 + 1, source.height - 1);
+				for (size_t x = 0; x < target.width; ++x)
+				{
+					auto x0 = x * 2;
+					auto x1 = std::min(x0 + 1, source.width - 1);
+					target.depth[y * target.width + x] = std::max(
+						std::max(source.depth[y0 * source.width + x0], source.depth[y0 * source.width + x1]),
+						std::max(source.depth[y1 * source.width + x0], source.depth[y1 * source.width + x1]));
+				}
+			}
+		}
+	}
+
+	// True when every pixel of the NDC rectangle already holds something nearer
+	// than nearestDepth. Reads the coarsest level where the rectangle spans at
+	// most two texels per axis. Call BuildHiZ after rasterizing first.
+	bool IsRectOccluded(const glm::vec2 &ndcMin, const glm::vec2 &ndcMax, float nearestDepth) const
+	{
+		auto toPixel = [](float ndc, size_t size) {
+			return (ndc * 0.5f + 0.5f) * static_cast<float>(size);
+		};
+		auto minX = std::max(toPixel(ndcMin.x, width), 0.f);
+		auto minY = std::max(toPixel(ndcMin.y, height), 0.f);
+		auto maxX = std::min(toPixel(ndcMax.x, width), static_cast<float>(width));
+		auto maxY = std::min(toPixel(ndcMax.y, height), static_cast<float>(height));
+		if (minX >= maxX || minY >= maxY)
+		{
+			// off screen is for frustum culling to decide
+			return false;
+		}
+		auto x0 = static_cast<size_t>(minX);
+		auto y0 = static_cast<size_t>(minY);
+		auto x1 = std::min(static_cast<size_t>(std::ceil(maxX)), width) - 1;
+		auto y1 = std::min(static_cast<size_t>(std::ceil(maxY)), height) - 1;
+
+		size_t level = 0;
+		while (level + 1 < levels.size() && (x1 - x0 > 1 || y1 - y0 > 1))
+		{
+			x0 /= 2;
+			y0 /= 2;
+			x1 /= 2;
+			y1 /= 2;
+			++level;
+		}
+		const auto &hiz = levels[level];
+		for (auto y = y0; y <= y1; ++y)
+		{
+			for (auto x = x0; x <= x1; ++x)
+			{
+				if (hiz.depth[y * hiz.width + x] >= nearestDepth)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// tests the sphere's bounding box, anything reaching the near plane counts as visible
+	bool IsSphereOccluded(const glm::mat4 &viewProjection, const glm::vec3 &center, float radius) const
+	{
+		glm::vec2 ndcMin(std::numeric_limits<float>::max());
+		glm::vec2 ndcMax(-std::numeric_limits<float>::max());
+		auto nearestDepth = std::numeric_limits<float>::max();
+		for (auto corner = 0U; corner < 8U; ++corner)
+		{
+			glm::vec3 offset(
+				(corner & 1U) ? radius : -radius,
+				(corner & 2U) ? radius : -radius,
+				(corner & 4U) ? radius : -radius);
+			auto clip = viewProjection * glm::vec4(center + offset, 1.f);
+			if (clip.w <= 0.f || clip.z < 0.f)
+			{
+				return false;
+			}
+			auto ndc = glm::vec3(clip) / clip.w;
+			ndcMin = glm::min(ndcMin, glm::vec2(ndc));
+			ndcMax = glm::max(ndcMax, glm::vec2(ndc));
+			nearestDepth = std::min(nearestDepth, ndc.z);
+		}
+		return IsRectOccluded(ndcMin, ndcMax, nearestDepth);
+	}
+
+private:
+	struct Level
+	{
+		size_t width;
+		size_t height;
+		std::vector<float> depth;
+	};
+	size_t width;
+	size_t height;
+	// level 0 is the rasterized depth buffer
+	std::vector<Level> levels;
+	std::vector<glm::vec4> clipPositions;
+
+	// clips against z >= 0 in clip space, which may turn the triangle into a quad
+	void RasterizeClipTriangle(const glm::vec4 &a, const glm::vec4 &b, const glm::vec4 &c)
+	{
+		std::array<glm::vec4, 3> input = {a, b, c};
+		std::array<glm::vec4, 4> clipped;
+		size_t clippedCount = 0;
+		for (size_t i = 0; i < 3; ++i)
+		{
+			const auto &current = input[i];
+			const auto &next = input[(i + 1) % 3];
+			if (current.z >= 0.f)
+			{
+				clipped[clippedCount++] = current;
+			}
+			if ((current.z >= 0.f) != (next.z >= 0.f))
+			{
+				auto t = current.z / (current.z - next.z);
+				clipped[clippedCount++] = current + (next - current) * t;
+			}
+		}
+		if (clippedCount < 3)
+		{
+			return;
+		}
+
+		std::array<glm::vec3, 4> screen;
+		for (size_t i = 0; i < clippedCount; ++i)
+		{
+			if (clipped[i].w <= 0.f)
+			{
+				return;
+			}
+			auto ndc = glm::vec3(clipped[i]) / clipped[i].w;
+			screen[i] = glm::vec3(
+				(ndc.x * 0.5f + 0.5f) * static_cast<float>(width),
+				(ndc.y * 0.5f + 0.5f) * static_cast<float>(height),
+				ndc.z);
+		}
+		RasterizeScreenTriangle(screen[0], screen[1], screen[2]);
+		if (clippedCount == 4)
+		{
+			RasterizeScreenTriangle(screen[0], screen[2], screen[3]);
+		}
+	}
+
+	// xy in pixels, z is depth
+	void RasterizeScreenTriangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c)
+	{
+		// sorted vertices give every edge the same endpoint order whichever
+		// triangle or winding it comes from, so coverage and depth come out of
+		// identical arithmetic, contracted or not
+		std::array<glm::vec3, 3> sorted = {a, b, c};
+		std::sort(sorted.begin(), sorted.end(), [](const glm::vec3 &l, const glm::vec3 &r) {
+			return l.x < r.x || (l.x == r.x && l.y < r.y);
+		});
+		const auto &v0 = sorted[0];
+		const auto &v1 = sorted[1];
+		const auto &v2 = sorted[2];
+		auto area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+		if (area == 0.f)
+		{
+			return;
+		}
+		auto minX = std::max(std::min({v0.x, v1.x, v2.x}), 0.f);
+		auto minY = std::max(std::min({v0.y, v1.y, v2.y}), 0.f);
+		auto maxX = std::min(std::max({v0.x, v1.x, v2.x}), static_cast<float>(width));
+		auto maxY = std::min(std::max({v0.y, v1.y, v2.y}), static_cast<float>(height));
+		if (minX >= maxX || minY >= maxY)
+		{
+			return;
+		}
+
+		// edge i is opposite vertex i and positive inside for either winding,
+		// depth is the area weighted sum of the vertex depths; flipping the sign
+		// is exact, so triangles sharing an edge see exactly negated values
+		auto sign = area > 0.f ? 1.f : -1.f;
+		std::array<glm::vec3, 3> edges;
+		auto edge = [sign](const glm::vec3 &from, const glm::vec3 &to) {
+			auto a = (from.y - to.y) * sign;
+			auto b = (to.x - from.x) * sign;
+			return glm::vec3(a, b, -(a * from.x + b * from.y));
+		};
+		edges[0] = edge(v1, v2);
+		edges[1] = -edge(v0, v2);
+		edges[2] = edge(v0, v1);
+		// a pixel exactly on an edge belongs to one side only, the top-left
+		// rule of the two triangles sharing it
+		std::array<bool, 3> ownsEdge;
+		for (size_t i = 0; i < 3; ++i)
+		{
+			ownsEdge[i] = edges[i].x > 0.f || (edges[i].x == 0.f && edges[i].y > 0.f);
+		}
+		auto inverseArea = 1.f / std::abs(area);
+		glm::vec3 depthWeights(v0.z * inverseArea, v1.z * inverseArea, v2.z * inverseArea);
+
+		auto x0 = static_cast<size_t>(minX) & ~size_t(3);
+		auto y0 = static_cast<size_t>(minY);
+		auto x1 = static_cast<size_t>(std::ceil(maxX));
+		auto y1 = static_cast<size_t>(std::ceil(maxY));
+		auto &depth = levels[0].depth;
+		for (auto y = y0; y < y1; ++y)
+		{
+			auto py = static_cast<float>(y) + 0.5f;
+			auto row = depth.data() + y * width;
+			for (auto x = x0; x < x1; x += 4)
+			{
+				auto px = static_cast<float>(x) + 0.5f;
+#ifdef VKA_SSE
+				auto xs = _mm_add_ps(_mm_set1_ps(px), _mm_set_ps(3.f, 2.f, 1.f, 0.f));
+				auto evaluate = [&xs, py](const glm::vec3 &e) {
+					return _mm_add_ps(_mm_mul_ps(xs, _mm_set1_ps(e.x)), _mm_set1_ps(e.y * py + e.z));
+				};
+				auto e0 = evaluate(edges[0]);
+				auto e1 = evaluate(edges[1]);
+				auto e2 = evaluate(edges[2]);
+				auto zero = _mm_setzero_ps();
+				auto covers = [&ownsEdge, zero](size_t i, __m128 e) {
+					return ownsEdge[i] ? _mm_cmpge_ps(e, zero) : _mm_cmpgt_ps(e, zero);
+				};
+				auto inside = _mm_and_ps(_mm_and_ps(covers(0, e0), covers(1, e1)), covers(2, e2));
+				if (_mm_movemask_ps(inside) == 0)
+				{
+					continue;
+				}
+				auto z = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(e0, _mm_set1_ps(depthWeights.x)), _mm_mul_ps(e1, _mm_set1_ps(depthWeights.y))),
+					_mm_mul_ps(e2, _mm_set1_ps(depthWeights.z)));
+				auto current = _mm_loadu_ps(row + x);
+				auto nearer = _mm_min_ps(current, z);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, current)));
+#else
+				for (size_t lane = 0; lane < 4; ++lane)
+				{
+					auto p = glm::vec3(px + static_cast<float>(lane), py, 1.f);
+					glm::vec3 e(glm::dot(edges[0], p), glm::dot(edges[1], p), glm::dot(edges[2], p));
+					auto covers = [&ownsEdge](size_t i, float value) {
+						return ownsEdge[i] ? value >= 0.f : value > 0.f;
+					};
+					if (covers(0, e.x) && covers(1, e.y) && covers(2, e.z))
+					{
+						row[x + lane] = std::min(row[x + lane], glm::dot(e, depthWeights));
+					}
+				}
+#endif
+			}
+		}
+	}
+};
+} // namespace vka
@@ -0,0 +1,58 @@
+#pragma once
+#include "vulkan/vulkan.h"
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cstdint>
+
+namespace vka
+{
+// layout of the header version one pipeline cache blobs start with
+struct PipelineCacheHeader
+{
+	uint32_t headerSize;
+	uint32_t headerVersion;
+	uint32_t vendorID;
+	uint32_t deviceID;
+	uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+};
+static_assert(sizeof(PipelineCacheHeader) == 16 + VK_UUID_SIZE, "pipeline cache header must not be padded");
+
+// Drivers reject or, worse, misread data from another device or driver, so a
+// blob is only handed back when its header matches the running device.
+static bool PipelineCacheDataMatches(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties)
+{
+	if (data.size() < sizeof(PipelineCacheHeader))
+	{
+		return false;
+	}
+	PipelineCacheHeader header;
+	std::memcpy(&header, data.data(), sizeof(header));
+	return header.headerSize >= sizeof(PipelineCacheHeader) &&
+		header.headerSize <= data.size() &&
+		header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		header.vendorID == properties.vendorID &&
+		header.deviceID == properties.deviceID &&
+		std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+// One file per device and driver build, so switching GPUs or updating the
+// driver starts a fresh cache rather than overwriting the other one.
+static std::string PipelineCacheFileName(const VkPhysicalDeviceProperties& properties)
+{
+	std::ostringstream name;
+	name << "pipeline_" << std::hex << std::setfill('0')
+		<< std::setw(8) << properties.vendorID << '_'
+		<< std::setw(8) << properties.deviceID << '_'
+		<< std::setw(8) << properties.driverVersion << '_';
+	for (auto byte : properties.pipelineCacheUUID)
+	{
+		name << std::setw(2) << static_cast<uint32_t>(byte);
+	}
+	name << ".cache";
+	return name.str();
+}
+} // namespace vka
@@ -0,0 +1,599 @@
+#pragma once
+#include "vulkan/vulkan.h"
+#include "VulkanFunctions.hpp"
+
+#include <vector>
+#include <string>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+
+namespace vka
+{
+using RenderGraphHandle = size_t;
+
+constexpr VkAccessFlags WriteAccessMask =
+	VK_ACCESS_SHADER_WRITE_BIT |
+	VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+	VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+	VK_ACCESS_TRANSFER_WRITE_BIT |
+	VK_ACCESS_HOST_WRITE_BIT |
+	VK_ACCESS_MEMORY_WRITE_BIT;
+
+// how a pass uses a resource, layout is ignored for buffers
+struct ResourceState
+{
+	VkPipelineStageFlags stageMask;
+	VkAccessFlags accessMask;
+	VkImageLayout layout;
+
+	bool operator==(const ResourceState& other) const
+	{
+		return stageMask == other.stageMask && accessMask == other.accessMask && layout == other.layout;
+	}
+	bool operator!=(const ResourceState& other) const { return !(*this == other); }
+};
+
+struct RenderGraphResource
+{
+	std::string name;
+	bool image;
+	// transient resources exist only between their first and last pass and may share memory
+	bool transient;
+	VkImageAspectFlags aspectMask;
+	VkMemoryRequirements memoryRequirements;
+	// imported resources start in initialState and, if given, are left in finalState
+	ResourceState initialState;
+	std::optional<ResourceState> finalState;
+
+	bool operator==(const RenderGraphResource& other) const
+	{
+		return name == other.name &&
+			image == other.image &&
+			transient == other.transient &&
+			aspectMask == other.aspectMask &&
+			memoryRequirements.size == other.memoryRequirements.size &&
+			memoryRequirements.alignment == other.memoryRequirements.alignment &&
+			memoryRequirements.memoryTypeBits == other.memoryRequirements.memoryTypeBits &&
+			initialState == other.initialState &&
+			finalState == other.finalState;
+	}
+};
+
+// a pass writes a resource when the access mask holds any write bit
+struct RenderGraphAccess
+{
+	RenderGraphHandle resource;
+	ResourceState state;
+
+	bool operator==(const RenderGraphAccess& other) const
+	{
+		return resource == other.resource && state == other.state;
+	}
+};
+
+struct RenderGraphPass
+{
+	std::string name;
+	std::vector<RenderGraphAccess> accesses;
+	// kept even when nothing reads what it writes
+	bool sideEffects;
+
+	bool operator==(const RenderGraphPass& other) const
+	{
+		return name == other.name && accesses == other.accesses && sideEffects == other.sideEffects;
+	}
+};
+
+struct RenderGraphImageBarrier
+{
+	RenderGraphHandle resource;
+	VkAccessFlags srcAccessMask;
+	VkAccessFlags dstAccessMask;
+	VkImageLayout oldLayout;
+	VkImageLayout newLayout;
+	VkImageAspectFlags aspectMask;
+};
+
+// everything one vkCmdPipelineBarrier call needs; accesses without a layout
+// change share a single global memory barrier
+struct BarrierBatch
+{
+	VkPipelineStageFlags srcStageMask = 0;
+	VkPipelineStageFlags dstStageMask = 0;
+	VkAccessFlags srcAccessMask = 0;
+	VkAccessFlags dstAccessMask = 0;
+	std::vector<RenderGraphImageBarrier> imageBarriers;
+
+	bool empty() const { return dstStageMask == 0; }
+};
+
+struct TransientHeap
+{
+	VkDeviceSize size;
+	VkDeviceSize alignment;
+	uint32_t memoryTypeBits;
+};
+
+struct TransientPlacement
+{
+	size_t heap;
+	VkDeviceSize offset;
+};
+
+struct CompiledRenderGraph
+{
+	// indices of the declared passes that survived culling, in submission order
+	std::vector<size_t> passes;
+	// recorded before each compiled pass, parallel to passes
+	std::vector<BarrierBatch> barriers;
+	// moves imported resources to their final states after the last pass
+	BarrierBatch finalBarriers;
+	// transient resources with disjoint lifetimes share ranges of these
+	std::vector<TransientHeap> heaps;
+	// by resource handle, empty for imported resources and transients no pass uses
+	std::vector<std::optional<TransientPlacement>> placements;
+};
+
+// Passes declare the resources they read and write and are submitted in the
+// order they were added. Compile culls passes whose writes nobody reads,
+// batches the barriers each pass needs into one, and packs transient
+// resources into shared heaps. The declaration can be rebuilt every frame;
+// Compile only does the work again when it differs from the last one.
+class RenderGraph
+{
+public:
+	void Clear()
+	{
+		resources.clear();
+		passes.clear();
+	}
+
+	RenderGraphHandle ImportImage(
+		const std::string& name,
+		VkImageAspectFlags aspectMask,
+		const ResourceState& initialState,
+		std::optional<ResourceState> finalState = {})
+	{
+		resources.push_back({ name, true, false, aspectMask, {}, initialState, finalState });
+		return resources.size() - 1;
+	}
+
+	RenderGraphHandle ImportBuffer(
+		const std::string& name,
+		const ResourceState& initialState,
+		std::optional<ResourceState> finalState = {})
+	{
+		resources.push_back({ name, false, false, 0, {}, initialState, finalState });
+		return resources.size() - 1;
+	}
+
+	RenderGraphHandle CreateTransientImage(
+		const std::string& name,
+		VkImageAspectFlags aspectMask,
+		const VkMemoryRequirements& memoryRequirements)
+	{
+		resources.push_back({ name, true, true, aspectMask, memoryRequirements, UndefinedState(), {} });
+		return resources.size() - 1;
+	}
+
+	RenderGraphHandle CreateTransientBuffer(const std::string& name, const VkMemoryRequirements& memoryRequirements)
+	{
+		resources.push_back({ name, false, true, 0, memoryRequirements, UndefinedState(), {} });
+		return resources.size() - 1;
+	}
+
+	// several accesses to one resource are merged, but must agree on the layout
+	void AddPass(const std::string& name, const std::vector<RenderGraphAccess>& accesses, bool sideEffects = false)
+	{
+		RenderGraphPass pass = { name, {}, sideEffects };
+		for (const auto& access : accesses)
+		{
+			if (access.resource >= resources.size())
+			{
+				throw std::runtime_error("Render graph pass " + name + " uses an undeclared resource");
+			}
+			auto merged = std::find_if(pass.accesses.begin(), pass.accesses.end(),
+				[&access](const RenderGraphAccess& existing) { return existing.resource == access.resource; });
+			if (merged == pass.accesses.end())
+			{
+				pass.accesses.push_back(access);
+				continue;
+			}
+			if (resources[access.resource].image && merged->state.layout != access.state.layout)
+			{
+				throw std::runtime_error("Render graph pass " + name + " uses one image in two layouts");
+			}
+			merged->state.stageMask |= access.state.stageMask;
+			merged->state.accessMask |= access.state.accessMask;
+		}
+		passes.push_back(std::move(pass));
+	}
+
+	const CompiledRenderGraph& Compile()
+	{
+		if (compileCount > 0 && resources == compiledResources && passes == compiledPasses)
+		{
+			return compiled;
+		}
+		compiled = CompiledRenderGraph();
+		CullPasses();
+		PlaceTransients();
+		BuildBarriers();
+		compiledResources = resources;
+		compiledPasses = passes;
+		++compileCount;
+		return compiled;
+	}
+
+	// how often Compile found a changed declaration
+	size_t GetCompileCount() const { return compileCount; }
+
+	const RenderGraphPass& GetPass(size_t index) const { return passes.at(index); }
+
+private:
+	std::vector<RenderGraphResource> resources;
+	std::vector<RenderGraphPass> passes;
+	std::vector<RenderGraphResource> compiledResources;
+	std::vector<RenderGraphPass> compiledPasses;
+	CompiledRenderGraph compiled;
+	size_t compileCount = 0;
+	// transients whose memory an earlier transient used, by resource handle
+	std::vector<std::vector<RenderGraphHandle>> aliasPredecessors;
+
+	static ResourceState UndefinedState()
+	{
+		return { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED };
+	}
+
+	static bool Writes(const RenderGraphAccess& access)
+	{
+		return (access.state.accessMask & WriteAccessMask) != 0;
+	}
+
+	static bool Reads(const RenderGraphAccess& access)
+	{
+		return (access.state.accessMask & ~WriteAccessMask) != 0 || !Writes(access);
+	}
+
+	// walks backwards from imported writes and side effects
+	void CullPasses()
+	{
+		std::vector<bool> needed(resources.size(), false);
+		std::vector<bool> live(passes.size(), false);
+		for (auto index = passes.size(); index-- > 0;)
+		{
+			const auto& pass = passes[index];
+			auto keep = pass.sideEffects;
+			for (const auto& access : pass.accesses)
+			{
+				if (Writes(access) && (!resources[access.resource].transient || needed[access.resource]))
+				{
+					keep = true;
+				}
+			}
+			if (!keep)
+			{
+				continue;
+			}
+			live[index] = true;
+			for (const auto& access : pass.accesses)
+			{
+				if (Reads(access))
+				{
+					needed[access.resource] = true;
+				}
+			}
+		}
+		for (size_t index = 0; index < passes.size(); ++index)
+		{
+			if (live[index])
+			{
+				compiled.passes.push_back(index);
+			}
+		}
+	}
+
+	// Largest first, each transient goes at the lowest offset not used by a
+	// transient alive at the same time. Only equal memory type masks share a heap.
+	void PlaceTransients()
+	{
+		struct Lifetime
+		{
+			size_t first;
+			size_t last;
+		};
+		std::vector<std::optional<Lifetime>> lifetimes(resources.size());
+		for (size_t order = 0; order < compiled.passes.size(); ++order)
+		{
+			for (const auto& access : passes[compiled.passes[order]].accesses)
+			{
+				auto& lifetime = lifetimes[access.resource];
+				if (!lifetime)
+				{
+					lifetime = Lifetime{ order, order };
+				}
+				lifetime->last = order;
+			}
+		}
+
+		std::vector<RenderGraphHandle> transients;
+		for (RenderGraphHandle handle = 0; handle < resources.size(); ++handle)
+		{
+			if (resources[handle].transient && lifetimes[handle])
+			{
+				transients.push_back(handle);
+			}
+		}
+		std::stable_sort(transients.begin(), transients.end(), [this](RenderGraphHandle a, RenderGraphHandle b)
+		{
+			return resources[a].memoryRequirements.size > resources[b].memoryRequirements.size;
+		});
+
+		auto overlapsInTime = [&lifetimes](RenderGraphHandle a, RenderGraphHandle b)
+		{
+			return lifetimes[a]->first <= lifetimes[b]->last && lifetimes[b]->first <= lifetimes[a]->last;
+		};
+		auto overlapsInMemory = [this](RenderGraphHandle a, RenderGraphHandle b)
+		{
+			const auto& placementA = *compiled.placements[a];
+			const auto& placementB = *compiled.placements[b];
+			return placementA.heap == placementB.heap &&
+				placementA.offset < placementB.offset + resources[b].memoryRequirements.size &&
+				placementB.offset < placementA.offset + resources[a].memoryRequirements.size;
+		};
+		auto alignUp = [](VkDeviceSize value, VkDeviceSize alignment)
+		{
+			return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+		};
+
+		compiled.placements.assign(resources.size(), std::nullopt);
+		std::vector<std::vector<RenderGraphHandle>> heapResources;
+		for (auto handle : transients)
+		{
+			const auto& requirements = resources[handle].memoryRequirements;
+			auto heap = std::find_if(compiled.heaps.begin(), compiled.heaps.end(),
+				[&requirements](const TransientHeap& existing) { return existing.memoryTypeBits == requirements.memoryTypeBits; });
+			auto heapIndex = static_cast<size_t>(heap - compiled.heaps.begin());
+			if (heap == compiled.heaps.end())
+			{
+				compiled.heaps.push_back({ 0, 1, requirements.memoryTypeBits });
+				heapResources.emplace_back();
+			}
+
+			// the lowest fitting offset is zero or directly after a live neighbour
+			std::vector<VkDeviceSize> candidates = { 0 };
+			for (auto other : heapResources[heapIndex])
+			{
+				if (overlapsInTime(handle, other))
+				{
+					candidates.push_back(alignUp(
+						compiled.placements[other]->offset + resources[other].memoryRequirements.size,
+						requirements.alignment));
+				}
+			}
+			std::sort(candidates.begin(), candidates.end());
+			for (auto offset : candidates)
+			{
+				compiled.placements[handle] = TransientPlacement{ heapIndex, offset };
+				auto collides = std::any_of(heapResources[heapIndex].begin(), heapResources[heapIndex].end(),
+					[&](RenderGraphHandle other) { return overlapsInTime(handle, other) && overlapsInMemory(handle, other); });
+				if (!collides)
+				{
+					break;
+				}
+			}
+			auto& target = compiled.heaps[heapIndex];
+			target.size = std::max(target.size, compiled.placements[handle]->offset + requirements.size);
+			target.alignment = std::max(target.alignment, requirements.alignment);
+			heapResources[heapIndex].push_back(handle);
+		}
+
+		aliasPredecessors.assign(resources.size(), {});
+		for (auto handle : transients)
+		{
+			for (auto other : transients)
+			{
+				if (other != handle &&
+					lifetimes[other]->last < lifetimes[handle]->first &&
+					overlapsInMemory(handle, other))
+				{
+					aliasPredecessors[handle].push_back(other);
+				}
+			}
+		}
+	}
+
+	// what has happened to a resource since its last write
+	struct TrackedState
+	{
+		VkImageLayout layout;
+		VkPipelineStageFlags writeStages;
+		VkAccessFlags writeAccess;
+		VkPipelineStageFlags readStages;
+		// stages and accesses the last write was already made visible to
+		VkPipelineStageFlags visibleStages;
+		VkAccessFlags visibleAccess;
+	};
+
+	void BuildBarriers()
+	{
+		std::vector<TrackedState> tracked(resources.size());
+		std::vector<bool> touched(resources.size(), false);
+		for (RenderGraphHandle handle = 0; handle < resources.size(); ++handle)
+		{
+			const auto& initial = resources[handle].initialState;
+			auto& state = tracked[handle];
+			state = { initial.layout, 0, 0, 0, 0, 0 };
+			if (resources[handle].transient)
+			{
+				continue;
+			}
+			if ((initial.accessMask & WriteAccessMask) != 0)
+			{
+				state.writeStages = initial.stageMask;
+				state.writeAccess = initial.accessMask & WriteAccessMask;
+			}
+			else
+			{
+				// top of pipe means nothing is still using it
+				state.readStages = initial.stageMask & ~VkPipelineStageFlags(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+			}
+		}
+
+		for (auto passIndex : compiled.passes)
+		{
+			BarrierBatch batch;
+			for (const auto& access : passes[passIndex].accesses)
+			{
+				auto& state = tracked[access.resource];
+				if (!touched[access.resource])
+				{
+					touched[access.resource] = true;
+					// memory shared with an earlier transient waits for its last use
+					for (auto predecessor : aliasPredecessors[access.resource])
+					{
+						const auto& previous = tracked[predecessor];
+						state.writeStages |= previous.writeStages | previous.readStages;
+						state.writeAccess |= previous.writeAccess;
+					}
+				}
+				Transition(batch, access.resource, state, access.state);
+			}
+			compiled.barriers.push_back(std::move(batch));
+		}
+
+		for (RenderGraphHandle handle = 0; handle < resources.size(); ++handle)
+		{
+			if (resources[handle].finalState)
+			{
+				Transition(compiled.finalBarriers, handle, tracked[handle], *resources[handle].finalState);
+			}
+		}
+	}
+
+	void Transition(BarrierBatch& batch, RenderGraphHandle handle, TrackedState& state, const ResourceState& next)
+	{
+		const auto& resource = resources[handle];
+		auto writes = (next.accessMask & WriteAccessMask) != 0;
+		if (resource.image && next.layout != state.layout)
+		{
+			auto srcStages = state.writeStages | state.readStages;
+			batch.srcStageMask |= srcStages != 0 ? srcStages : VkPipelineStageFlags(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+			batch.dstStageMask |= next.stageMask;
+			batch.imageBarriers.push_back({
+				handle,
+				state.writeAccess,
+				next.accessMask,
+				state.layout,
+				next.layout,
+				resource.aspectMask });
+			// the transition is a write that completes before the destination stages
+			state.layout = next.layout;
+			state.writeStages = next.stageMask;
+			state.writeAccess = writes ? next.accessMask & WriteAccessMask : 0;
+			state.readStages = writes ? 0 : next.stageMask;
+			state.visibleStages = writes ? 0 : next.stageMask;
+			state.visibleAccess = writes ? 0 : next.accessMask;
+			return;
+		}
+
+		if (writes)
+		{
+			// write after write needs the old write made available, write after read only waits
+			auto srcStages = state.writeStages | state.readStages;
+			if (srcStages != 0)
+			{
+				batch.srcStageMask |= srcStages;
+				batch.dstStageMask |= next.stageMask;
+				batch.srcAccessMask |= state.writeAccess;
+				batch.dstAccessMask |= next.accessMask;
+			}
+			state.writeStages = next.stageMask;
+			state.writeAccess = next.accessMask & WriteAccessMask;
+			state.readStages = 0;
+			state.visibleStages = 0;
+			state.visibleAccess = 0;
+			return;
+		}
+
+		auto alreadyVisible = (next.stageMask & ~state.visibleStages) == 0 && (next.accessMask & ~state.visibleAccess) == 0;
+		if (state.writeStages != 0 && !alreadyVisible)
+		{
+			batch.srcStageMask |= state.writeStages;
+			batch.dstStageMask |= next.stageMask;
+			batch.srcAccessMask |= state.writeAccess;
+			batch.dstAccessMask |= next.accessMask;
+			state.visibleStages |= next.stageMask;
+			state.visibleAccess |= next.accessMask;
+		}
+		state.readStages |= next.stageMask;
+	}
+};
+
+// images holds each image resource's VkImage by handle, other entries are ignored
+static void RecordBarriers(VkCommandBuffer commandBuffer, const BarrierBatch& batch, const std::vector<VkImage>& images)
+{
+	if (batch.empty())
+	{
+		return;
+	}
+	VkMemoryBarrier memoryBarrier = {};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memoryBarrier.pNext = nullptr;
+	memoryBarrier.srcAccessMask = batch.srcAccessMask;
+	memoryBarrier.dstAccessMask = batch.dstAccessMask;
+	auto memoryBarrierCount = batch.srcAccessMask != 0 || batch.dstAccessMask != 0 ? 1U : 0U;
+
+	std::vector<VkImageMemoryBarrier> imageBarriers;
+	imageBarriers.reserve(batch.imageBarriers.size());
+	for (const auto& barrier : batch.imageBarriers)
+	{
+		VkImageMemoryBarrier imageBarrier = {};
+		imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imageBarrier.pNext = nullptr;
+		imageBarrier.srcAccessMask = barrier.srcAccessMask;
+		imageBarrier.dstAccessMask = barrier.dstAccessMask;
+		imageBarrier.oldLayout = barrier.oldLayout;
+		imageBarrier.newLayout = barrier.newLayout;
+		imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.image = images.at(barrier.resource);
+		imageBarrier.subresourceRange.aspectMask = barrier.aspectMask;
+		imageBarrier.subresourceRange.baseMipLevel = 0;
+		imageBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+		imageBarrier.subresourceRange.baseArrayLayer = 0;
+		imageBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+		imageBarriers.push_back(imageBarrier);
+	}
+
+	vkCmdPipelineBarrier(commandBuffer,
+		batch.srcStageMask,
+		batch.dstStageMask,
+		VkDependencyFlags(0),
+		memoryBarrierCount,
+		memoryBarrierCount > 0 ? &memoryBarrier : nullptr,
+		0,
+		nullptr,
+		static_cast<uint32_t>(imageBarriers.size()),
+		imageBarriers.data());
+}
+
+// records each compiled pass after its barriers; recordPass gets the declared pass index
+template <typename RecordPass>
+static void ExecuteRenderGraph(
+	VkCommandBuffer commandBuffer,
+	const CompiledRenderGraph& graph,
+	const std::vector<VkImage>& images,
+	RecordPass&& recordPass)
+{
+	for (size_t order = 0; order < graph.passes.size(); ++order)
+	{
+		RecordBarriers(commandBuffer, graph.barriers[order], images);
+		recordPass(graph.passes[order]);
+	}
+	RecordBarriers(commandBuffer, graph.finalBarriers, images);
+}
+} // namespace vka
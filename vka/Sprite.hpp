@@ -39,6 +39,18 @@ namespace vka
 		return quad;
 	}
 
+	// left, top, right, bottom of the quad's positions
+	static glm::vec4 QuadRect(const Quad& quad)
+	{
+		return glm::vec4(quad.vertices[0].Position, quad.vertices[2].Position);
+	}
+
+	// left, top, right, bottom of the quad's texture coordinates
+	static glm::vec4 QuadUVRect(const Quad& quad)
+	{
+		return glm::vec4(quad.vertices[0].UV, quad.vertices[2].UV);
+	}
+
 	struct Sprite
 	{
 		uint64_t imageID;
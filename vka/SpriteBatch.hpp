@@ -0,0 +1,100 @@
+#pragma once
+#include "glm/glm.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace vka
+{
+// one sprite as the 2D vertex shader reads it from a std430 storage buffer;
+// transform maps the unit quad to the sprite's placement
+struct SpriteData
+{
+	glm::mat4 transform;
+	// left, top, right, bottom texture coordinates
+	glm::vec4 uvRect;
+	glm::vec4 color;
+	uint32_t textureIndex;
+	uint32_t padding[3];
+};
+static_assert(sizeof(SpriteData) == 112, "SpriteData must match the shader's std430 layout");
+
+// positionRect is left, top, right, bottom in sprite space
+static SpriteData MakeSpriteData(
+	const glm::mat4 &transform,
+	const glm::vec4 &positionRect,
+	const glm::vec4 &uvRect,
+	const glm::vec4 &color,
+	uint32_t textureIndex)
+{
+	// transform * translate(left, top) * scale(width, height), without the full products
+	auto width = positionRect.z - positionRect.x;
+	auto height = positionRect.w - positionRect.y;
+	SpriteData sprite;
+	sprite.transform[0] = transform[0] * width;
+	sprite.transform[1] = transform[1] * height;
+	sprite.transform[2] = transform[2];
+	sprite.transform[3] = transform[0] * positionRect.x + transform[1] * positionRect.y + transform[3];
+	sprite.uvRect = uvRect;
+	sprite.color = color;
+	sprite.textureIndex = textureIndex;
+	sprite.padding[0] = sprite.padding[1] = sprite.padding[2] = 0;
+	return sprite;
+}
+
+// instances [firstInstance, firstInstance + instanceCount) all sample textureIndex
+// unless the batch was built without splitting
+struct SpriteBatch
+{
+	uint32_t textureIndex;
+	uint32_t firstInstance;
+	uint32_t instanceCount;
+};
+
+// Collects a frame's sprites and writes them out as few instanced draws.
+// Sprites are blended, so they always stay in submission order; when the shader
+// can index textures per instance they go out as one batch, otherwise a new
+// batch starts wherever the texture changes.
+class SpriteBatcher
+{
+public:
+	void Clear() { sprites.clear(); }
+
+	void Add(const SpriteData &sprite) { sprites.push_back(sprite); }
+
+	size_t size() const { return sprites.size(); }
+
+	// writes size() sprites to destination, firstInstance is where destination
+	// starts in the instance buffer
+	const std::vector<SpriteBatch> &Write(SpriteData *destination, uint32_t firstInstance, bool splitByTexture)
+	{
+		batches.clear();
+		if (sprites.empty())
+		{
+			return batches;
+		}
+		std::copy(sprites.begin(), sprites.end(), destination);
+		if (!splitByTexture)
+		{
+			batches.push_back({ 0, firstInstance, static_cast<uint32_t>(sprites.size()) });
+			return batches;
+		}
+
+		for (uint32_t i = 0; i < sprites.size(); ++i)
+		{
+			if (batches.empty() || batches.back().textureIndex != sprites[i].textureIndex)
+			{
+				batches.push_back({ sprites[i].textureIndex, firstInstance + i, 0 });
+			}
+			++batches.back().instanceCount;
+		}
+		return batches;
+	}
+
+private:
+	std::vector<SpriteData> sprites;
+	std::vector<SpriteBatch> batches;
+};
+} // namespace vka
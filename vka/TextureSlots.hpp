@@ -0,0 +1,37 @@
+#pragma once
+#include <stdexcept>
+#include <cstdint>
+
+namespace vka
+{
+// Hands out stable indices into a texture descriptor array. A texture keeps
+// its slot for as long as the app runs, so draws only need the slot and
+// nothing that refers to the array changes when textures are loaded.
+class TextureSlots
+{
+public:
+	explicit TextureSlots(uint32_t capacity)
+		:
+		capacity(capacity)
+	{
+	}
+
+	uint32_t Allocate()
+	{
+		if (slotCount == capacity)
+		{
+			throw std::runtime_error("Texture descriptor array is full");
+		}
+		return slotCount++;
+	}
+
+	// the slots handed out so far, the size a fixed array needs
+	uint32_t GetSlotCount() const { return slotCount; }
+
+	uint32_t GetCapacity() const { return capacity; }
+
+private:
+	uint32_t capacity;
+	uint32_t slotCount = 0;
+};
+} // namespace vka
@@ -0,0 +1,136 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <cstddef>
+
+namespace vka
+{
+// Fixed set of worker threads fed from a single queue. Tasks receive the index
+// of the worker running them so callers can keep per thread resources, such as
+// command pools, without locking.
+class ThreadPool
+{
+public:
+	using Task = std::function<void(size_t threadIndex)>;
+
+	explicit ThreadPool(size_t threadCount)
+	{
+		threadCount = std::max(threadCount, size_t(1));
+		for (size_t i = 0; i < threadCount; ++i)
+		{
+			threads.emplace_back([this, i]() { WorkerLoop(i); });
+		}
+	}
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		taskAvailable.notify_all();
+		for (auto &thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	size_t GetThreadCount() const
+	{
+		return threads.size();
+	}
+
+	// leaves one core for the thread that submits the work
+	static size_t DefaultThreadCount()
+	{
+		auto cores = static_cast<size_t>(std::thread::hardware_concurrency());
+		return cores > 1 ? cores - 1 : 1;
+	}
+
+	void Enqueue(Task task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.push_back(std::move(task));
+			++pendingCount;
+		}
+		taskAvailable.notify_one();
+	}
+
+	// blocks until every task enqueued so far has finished
+	void Wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		allDone.wait(lock, [this]() { return pendingCount == 0; });
+	}
+
+	// Splits [0, count) into at most partitionCount contiguous ranges and runs
+	// func(partitionIndex, begin, end, threadIndex) for each, returning once all
+	// have finished. Returns the number of partitions used.
+	template <typename Func>
+	size_t ParallelFor(size_t count, size_t partitionCount, Func &&func)
+	{
+		partitionCount = std::min(std::max(partitionCount, size_t(1)), count);
+		if (partitionCount == 0)
+		{
+			return 0;
+		}
+		auto partitionSize = (count + partitionCount - 1) / partitionCount;
+		partitionCount = (count + partitionSize - 1) / partitionSize;
+		for (size_t partition = 0; partition < partitionCount; ++partition)
+		{
+			auto begin = partition * partitionSize;
+			auto end = std::min(begin + partitionSize, count);
+			Enqueue([&func, partition, begin, end](size_t threadIndex) {
+				func(partition, begin, end, threadIndex);
+			});
+		}
+		Wait();
+		return partitionCount;
+	}
+
+private:
+	std::vector<std::thread> threads;
+	std::deque<Task> tasks;
+	std::mutex mutex;
+	std::condition_variable taskAvailable;
+	std::condition_variable allDone;
+	size_t pendingCount = 0;
+	bool stopping = false;
+
+	void WorkerLoop(size_t threadIndex)
+	{
+		for (;;)
+		{
+			Task task;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				taskAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+				if (tasks.empty())
+				{
+					return;
+				}
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			task(threadIndex);
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				--pendingCount;
+				if (pendingCount == 0)
+				{
+					allDone.notify_all();
+				}
+			}
+		}
+	}
+};
+} // namespace vka
@@ -328,4 +328,38 @@ namespace vka
         VkPipelineDeleter() noexcept = default;
     };
     using VkPipelineUnique = std::unique_ptr<VkPipeline, VkPipelineDeleter>;
+
+    struct VkPipelineCacheDeleter
+    {
+        using pointer = VkPipelineCache;
+        VkDevice device = VK_NULL_HANDLE;
+
+        void operator()(VkPipelineCache pipelineCache)
+        {
+            vkDestroyPipelineCache(device, pipelineCache, nullptr);
+        }
+
+        VkPipelineCacheDeleter(VkDevice device) : device(device)
+        {}
+
+        VkPipelineCacheDeleter() noexcept = default;
+    };
+    using VkPipelineCacheUnique = std::unique_ptr<VkPipelineCache, VkPipelineCacheDeleter>;
+
+    struct VkDescriptorUpdateTemplateDeleter
+    {
+        using pointer = VkDescriptorUpdateTemplate;
+        VkDevice device = VK_NULL_HANDLE;
+
+        void operator()(VkDescriptorUpdateTemplate updateTemplate)
+        {
+            vkDestroyDescriptorUpdateTemplateKHR(device, updateTemplate, nullptr);
+        }
+
+        VkDescriptorUpdateTemplateDeleter(VkDevice device) : device(device)
+        {}
+
+        VkDescriptorUpdateTemplateDeleter() noexcept = default;
+    };
+    using VkDescriptorUpdateTemplateUnique = std::unique_ptr<VkDescriptorUpdateTemplate, VkDescriptorUpdateTemplateDeleter>;
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+#pragma once
+#include "vulkan/vulkan.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/packing.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+namespace vka
+{
+enum class VertexFormat
+{
+	// R32G32B32_SFLOAT positions and normals, 24 bytes per vertex
+	Float,
+	// R16G16B16A16_UNORM positions in the mesh bounds and octahedral normals
+	Quantized
+};
+
+enum class NormalEncoding
+{
+	// R8G8_SNORM, 2 bytes per normal
+	Octahedral8,
+	// R16G16_SNORM, 4 bytes per normal
+	Octahedral16
+};
+
+struct QuantizedPosition
+{
+	uint16_t x, y, z, w;
+};
+
+// the normal encoding is chosen by the format the quantized pipeline config
+// declares for the normal attribute
+static NormalEncoding NormalEncodingFromFormat(VkFormat format)
+{
+	if (format == VK_FORMAT_R8G8_SNORM)
+	{
+		return NormalEncoding::Octahedral8;
+	}
+	return NormalEncoding::Octahedral16;
+}
+
+static size_t NormalEncodingSize(NormalEncoding encoding)
+{
+	return encoding == NormalEncoding::Octahedral8 ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+// maps a unit vector onto the [-1, 1] square of an unfolded octahedron
+static glm::vec2 OctahedralEncode(glm::vec3 n)
+{
+	n /= std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+	auto encoded = glm::vec2(n.x, n.y);
+	if (n.z < 0.f)
+	{
+		auto signs = glm::vec2(n.x >= 0.f ? 1.f : -1.f, n.y >= 0.f ? 1.f : -1.f);
+		encoded = (1.f - glm::abs(glm::vec2(n.y, n.x))) * signs;
+	}
+	return encoded;
+}
+
+static glm::vec3 OctahedralDecode(glm::vec2 e)
+{
+	auto n = glm::vec3(e.x, e.y, 1.f - std::abs(e.x) - std::abs(e.y));
+	auto t = std::max(-n.z, 0.f);
+	n.x += n.x >= 0.f ? -t : t;
+	n.y += n.y >= 0.f ? -t : t;
+	return glm::normalize(n);
+}
+
+// Bounds of a mesh expressed as the matrix that takes UNORM positions back to
+// object space. Flat axes get a unit extent so the matrix stays invertible.
+struct QuantizationBounds
+{
+	glm::vec3 minimum;
+	glm::vec3 extent;
+
+	glm::mat4 GetDequantizeMatrix() const
+	{
+		return glm::scale(glm::translate(glm::mat4(1.f), minimum), extent);
+	}
+};
+
+static QuantizationBounds ComputeQuantizationBounds(const std::vector<glm::vec3> &positions)
+{
+	QuantizationBounds bounds;
+	bounds.minimum = glm::vec3(0.f);
+	bounds.extent = glm::vec3(1.f);
+	if (positions.empty())
+	{
+		return bounds;
+	}
+	auto maximum = positions[0];
+	bounds.minimum = positions[0];
+	for (const auto &position : positions)
+	{
+		bounds.minimum = glm::min(bounds.minimum, position);
+		maximum = glm::max(maximum, position);
+	}
+	bounds.extent = maximum - bounds.minimum;
+	for (auto axis = 0; axis < 3; ++axis)
+	{
+		if (bounds.extent[axis] <= 0.f)
+		{
+			bounds.extent[axis] = 1.f;
+		}
+	}
+	return bounds;
+}
+
+static QuantizedPosition QuantizePosition(const glm::vec3 &position, const QuantizationBounds &bounds)
+{
+	auto normalized = glm::clamp((position - bounds.minimum) / bounds.extent, glm::vec3(0.f), glm::vec3(1.f));
+	auto scaled = glm::round(normalized * 65535.f);
+	QuantizedPosition result;
+	result.x = static_cast<uint16_t>(scaled.x);
+	result.y = static_cast<uint16_t>(scaled.y);
+	result.z = static_cast<uint16_t>(scaled.z);
+	result.w = 0;
+	return result;
+}
+
+// Appends the encoded normal to a byte stream. The normal is pre-divided by the
+// quantization extent so that transforming it by the model matrix with the
+// dequantize scale folded in yields a vector parallel to the true normal.
+static void AppendQuantizedNormal(
+	std::vector<uint8_t> &output,
+	const glm::vec3 &normal,
+	const QuantizationBounds &bounds,
+	NormalEncoding encoding)
+{
+	auto compensated = glm::normalize(normal / bounds.extent);
+	auto encoded = OctahedralEncode(compensated);
+	if (encoding == NormalEncoding::Octahedral8)
+	{
+		uint16_t packed = glm::packSnorm2x8(encoded);
+		auto offset = output.size();
+		output.resize(offset + sizeof(packed));
+		std::memcpy(output.data() + offset, &packed, sizeof(packed));
+	}
+	else
+	{
+		uint32_t packed = glm::packSnorm2x16(encoded);
+		auto offset = output.size();
+		output.resize(offset + sizeof(packed));
+		std::memcpy(output.data() + offset, &packed, sizeof(packed));
+	}
+}
+} // namespace vka
@@ -4,32 +4,71 @@
 
 namespace vka
 {
-	void VulkanApp::CleanUpSwapchain()
+	void VulkanApp::RecreateSwapchain(bool surfaceLost)
 	{
-		vkDeviceWaitIdle(device);
-		for (const auto& imageResources : perImageResources)
+		// queued presents must reach the old swapchain before it is retired
+		WaitForPresents();
+
+		// nothing is destroyed here; the old objects go once the frames already
+		// submitted against them have completed, so resizing does not drain the GPU
+		for (uint32_t image = 0; image < perImageResources.size(); ++image)
+		{
+			const auto& imageResources = perImageResources[image];
+			deviceOptional->RetireFramebuffer(imageResources.swap.framebuffer, timelineOptional->GetSubmittedValue());
+			deviceOptional->RetireImageView(imageResources.swap.view, timelineOptional->GetSubmittedValue());
+			// the timeline does not cover the presentation engine, which may still
+			// wait on the semaphore; see AcquireNextImage
+			replacedRenderedSemaphores.push_back({ image, imageResources.imageRenderedSemaphore });
+		}
+		perImageResources.clear();
+		// the presentation engine is done with the old swapchain once every frame
+		// slot has been through another submission
+		auto oldSwapchain = swapchain;
+		deviceOptional->RetireSwapchain(oldSwapchain, timelineOptional->GetSubmittedValue() + perFrameResources.size());
+
+		if (surfaceLost)
 		{
-			deviceOptional->DestroyFramebuffer(imageResources.swap.framebuffer);
-			deviceOptional->DestroyImageView(imageResources.swap.view);
+			// a swapchain has to be destroyed before its surface, which does need a full drain;
+			// the idle present queue is done with every retired object as well
+			vkDeviceWaitIdle(device);
+			for (const auto& replaced : replacedRenderedSemaphores)
+			{
+				deviceOptional->RetireSemaphore(replaced.second, timelineOptional->GetSubmittedValue());
+			}
+			replacedRenderedSemaphores.clear();
+			deviceOptional->CollectGarbage(std::numeric_limits<uint64_t>::max());
+			CreateSurface();
+			oldSwapchain = VK_NULL_HANDLE;
 		}
-		deviceOptional->DestroySwapchain(swapchain);
+
+		UpdateSurfaceSize();
+		CreateSwapchain(oldSwapchain);
+		surfaceResized = true;
 	}
 
-	void VulkanApp::CreateSwapchain()
+	void VulkanApp::CreateSwapchain(VkSwapchainKHR oldSwapchain)
 	{
 		swapchain = deviceOptional->CreateSwapchain(
 			surface,
 			surfaceFormat,
-			configs.swapchain);
+			configs.swapchain,
+			oldSwapchain);
 
+		// the driver may hand out more images than minImageCount asks for
 		uint32_t swapImageCount;
 		vkGetSwapchainImagesKHR(device, swapchain, &swapImageCount, nullptr);
 		std::vector<VkImage> swapImages;
-		swapImages.resize(BufferCount);
+		swapImages.resize(swapImageCount);
 		vkGetSwapchainImagesKHR(device, swapchain, &swapImageCount, swapImages.data());
 
-		for (auto i = 0U; i < BufferCount; ++i)
+		perImageResources.resize(swapImageCount);
+		for (auto i = 0U; i < swapImageCount; ++i)
 		{
+			if (perImageResources[i].imageRenderedSemaphore == VK_NULL_HANDLE)
+			{
+				perImageResources[i].imageRenderedSemaphore = deviceOptional->CreateSemaphore();
+			}
+
 			auto& fbImage = perImageResources[i].swap.image;
 			auto& fbView = perImageResources[i].swap.view;
 			auto& fb = perImageResources[i].swap.framebuffer;
@@ -70,7 +109,7 @@ namespace vka
 
 	void VulkanApp::Run(std::string vulkanInitJsonPath)
 	{
-		json vulkanInitData = json::parse(fileIO::readFile(vulkanInitJsonPath));
+		json vulkanInitData = LoadConfig(vulkanInitJsonPath);
 		VulkanLibrary = LoadVulkanLibrary();
 		LoadExportedEntryPoints(VulkanLibrary);
 		LoadGlobalLevelEntryPoints();
@@ -99,10 +138,13 @@ namespace vka
 		glfwSetMouseButtonCallback(window, MouseButtonCallback);
 		camera.setSize({ static_cast<float>(width),
 						static_cast<float>(height) });
+		camera3D.setSize({ static_cast<float>(width),
+						static_cast<float>(height) });
 
 		std::vector<std::string> globalLayers;
 		std::vector<std::string> instanceExtensions;
 		std::vector<std::string> deviceExtensions;
+		std::vector<std::string> optionalDeviceExtensions;
 
 		if (!ReleaseMode)
 		{
@@ -131,6 +173,10 @@ namespace vka
 		{
 			deviceExtensions.push_back(extension);
 		}
+		for (const std::string &extension : vulkanInitData["DeviceExtensions"]["Optional"])
+		{
+			optionalDeviceExtensions.push_back(extension);
+		}
 
 		std::vector<const char *> globalLayersCstrings;
 		std::vector<const char *> instanceExtensionsCstrings;
@@ -179,15 +225,28 @@ namespace vka
 		instanceCreateInfo.enabledExtensionCount = gsl::narrow<uint32_t>(instanceExtensionsCstrings.size());
 		instanceCreateInfo.ppEnabledExtensionNames = instanceExtensionsCstrings.data();
 
-		configs.swapchain = LoadJson("config/swapchainConfig.json");
-		configs.renderPass = LoadJson("config/renderPass.json");
-
-		configs.c2D.sampler = LoadJson("config/2D/sampler.json");
-		configs.c2D.pipelineLayout = LoadJson("config/2D/pipelineLayout.json");
-		configs.c2D.pipeline = LoadJson("config/2D/pipeline.json");
-
-		configs.c3D.pipelineLayout = LoadJson("config/3D/pipelineLayout.json");
-		configs.c3D.pipeline = LoadJson("config/3D/pipeline.json");
+		configs.swapchain = LoadConfig("config/swapchain.json");
+
+		// render passes, layouts, shaders and pipelines come from the object graph
+		configs.c2D.sampler = LoadConfig("config/2D/sampler.json");
+		configs.c2D.dynamicDescriptorSetLayout = LoadConfig("config/2D/dynamicDescriptorSetLayout.json");
+
+		configs.c3D.quantizedPipeline = LoadConfig("config/3D/quantizedPipeline.json");
+		configs.c3D.staticDescriptorSetLayout = LoadConfig("config/3D/staticDescriptorSetLayout.json");
+		configs.c3D.dynamicDescriptorSetLayout = LoadConfig("config/3D/dynamicDescriptorSetLayout.json");
+		const auto &quantizedInput = configs.c3D.quantizedPipeline["vertexInputConfig"];
+		const auto &normalAttribute = quantizedInput["vertexAttributeDescriptions"][1];
+		data3D.normalEncoding = NormalEncodingFromFormat(normalAttribute["format"]);
+		// the object graph builds the pipeline from the file, so the normal stride
+		// there has to agree with the packing the loader picks from the format
+		for (const auto &binding : quantizedInput["vertexBindingDescriptions"])
+		{
+			if (binding["binding"] == normalAttribute["binding"] &&
+				binding["stride"].get<size_t>() != NormalEncodingSize(data3D.normalEncoding))
+			{
+				throw std::runtime_error("Quantized normal stride does not match its format");
+			}
+		}
 
 		instanceOptional = Instance(instanceCreateInfo);
 		instance = instanceOptional->GetInstance();
@@ -198,13 +257,51 @@ namespace vka
 		VkPhysicalDeviceProperties physicalDeviceProperties;
 		vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
 		uniformBufferAlignment = physicalDeviceProperties.limits.minUniformBufferOffsetAlignment;
+		maxDrawIndirectCount = physicalDeviceProperties.limits.maxDrawIndirectCount;
+
+		auto drawIndirectCountExtension = false;
+		for (const auto &extension : optionalDeviceExtensions)
+		{
+			if (DeviceExtensionSupported(physicalDevice, extension))
+			{
+				deviceExtensionsCstrings.push_back(extension.c_str());
+				drawIndirectCountExtension |= extension == VK_AMD_DRAW_INDIRECT_COUNT_EXTENSION_NAME;
+			}
+		}
 
 		CreateSurface();
 
-		deviceOptional = DeviceManager(physicalDevice, deviceExtensionsCstrings, surface);
+		deviceOptional.emplace(physicalDevice, deviceExtensionsCstrings, surface);
 		device = deviceOptional->GetDevice();
 
+		const auto &enabledFeatures = deviceOptional->GetEnabledFeatures();
+		multiDrawIndirect = enabledFeatures.multiDrawIndirect && enabledFeatures.drawIndirectFirstInstance;
+		drawIndirectCount = multiDrawIndirect &&
+			drawIndirectCountExtension &&
+			vkCmdDrawIndexedIndirectCountAMD != nullptr;
+
+		timelineOptional.emplace(*deviceOptional);
+
+		// without descriptor indexing the array is sized to the loaded textures
+		// and baked into the 2D pipeline
+		data2D.bindless = deviceOptional->DescriptorIndexingEnabled();
+		configs.c2D.staticDescriptorSetLayout = LoadConfig(ConfigVariant("config/2D/staticDescriptorSetLayout.json"));
+		auto textureCapacity = std::numeric_limits<uint32_t>::max();
+		if (data2D.bindless)
+		{
+			textureCapacity = configs.c2D.staticDescriptorSetLayout["bindings"].at(TextureBinding2D)["descriptorCount"].get<uint32_t>();
+			if (textureCapacity > deviceOptional->GetMaxUpdateAfterBindSampledImages())
+			{
+				throw std::runtime_error("2D texture array is larger than the device allows");
+			}
+		}
+		data2D.textureSlotsOptional.emplace(textureCapacity);
+
+		deviceOptional->LoadPipelineCache(vulkanInitData.value("PipelineCacheDirectory", std::string("cache/")));
+
 		auto graphicsQueueID = deviceOptional->GetGraphicsQueueID();
+		presentQueue = deviceOptional->GetPresentQueue();
+		presentQueueShared = presentQueue == deviceOptional->GetGraphicsQueue();
 		utilityCommandPool = deviceOptional->CreateCommandPool(graphicsQueueID, true, true);
 		auto utilityCommandBuffers = deviceOptional->AllocateCommandBuffers(utilityCommandPool, 1);
 		utilityCommandBuffer = utilityCommandBuffers.at(0);
@@ -214,16 +311,19 @@ namespace vka
 		LoadModels();
 		LoadImages();
 
-		CreateVertexBuffers2D();
+		if (!data2D.bindless)
+		{
+			configs.c2D.staticDescriptorSetLayout["bindings"].at(TextureBinding2D)["descriptorCount"] =
+				std::max(data2D.textureSlotsOptional->GetSlotCount(), 1U);
+		}
 
 		data2D.sampler = deviceOptional->CreateSampler(configs.c2D.sampler);
 
-		data2D.staticDescriptorSetLayout = deviceOptional->CreateDescriptorSetLayout(
-			configs.c2D.pipelineLayout["descriptorSetLayouts"][0],
-			data2D.sampler);
+		threadPoolOptional.emplace(ThreadPool::DefaultThreadCount());
+		CreateGraphObjects();
 
 		data2D.staticDescriptorPool = deviceOptional->CreateDescriptorPool(
-			configs.c2D.pipelineLayout["descriptorSetLayouts"][0],
+			configs.c2D.staticDescriptorSetLayout,
 			1,
 			true);
 
@@ -233,103 +333,82 @@ namespace vka
 			1);
 		data2D.staticDescriptorSet = staticDescriptorSets.at(0);
 
-		data2D.dynamicDescriptorSetLayout = deviceOptional->CreateDescriptorSetLayout(
-			configs.c2D.pipelineLayout["descriptorSetLayouts"][1],
-			data2D.sampler);
-
-		data2D.dynamicDescriptorPool = deviceOptional->CreateDescriptorPool(
-			configs.c2D.pipelineLayout["descriptorSetLayouts"][1],
-			1,
-			true);
-
-		auto dynamicDescriptorSets = deviceOptional->AllocateDescriptorSets(
-			data2D.dynamicDescriptorPool,
-			data2D.dynamicDescriptorSetLayout,
-			1);
-		data2D.dynamicDescriptorSet = dynamicDescriptorSets.at(0);
-
-		data2D.vertexShader = deviceOptional->CreateShaderModule(
-			configs.c2D.pipeline["shaderStageConfigs"][0]["module"]);
-
-		data2D.fragmentShader = deviceOptional->CreateShaderModule(
-			configs.c2D.pipeline["shaderStageConfigs"][1]["module"]);
-
-		data2D.fragmentShader = StoreHandle(
-			deviceOptional->CreateShaderModule(
-				configs.fragmentShader2D),
-			configs.fragmentShader2D,
-			shaderModules);
-
-		auto imageInfos = std::vector<VkDescriptorImageInfo>();
-		uint32_t imageCount = gsl::narrow<uint32_t>(data2D.images.size());
-		imageInfos.reserve(imageCount);
+		// images loaded from now on write their own descriptor when bindless
 		for (auto &imagePair : data2D.images)
 		{
-			VkDescriptorImageInfo imageInfo = {};
-			imageInfo.sampler = VK_NULL_HANDLE;
-			imageInfo.imageView = imagePair.second.view.get();
-			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			imageInfos.push_back(imageInfo);
+			WriteTextureDescriptor(gsl::narrow<uint32_t>(imagePair.second.imageOffset), imagePair.second.view.get());
 		}
 
-		VkWriteDescriptorSet samplerDescriptorWrite = {};
-		samplerDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		samplerDescriptorWrite.pNext = nullptr;
-		samplerDescriptorWrite.dstSet = data2D.fragmentDescriptorSet;
-		samplerDescriptorWrite.dstBinding = 1;
-		samplerDescriptorWrite.dstArrayElement = 0;
-		samplerDescriptorWrite.descriptorCount = gsl::narrow<uint32_t>(imageCount);
-		samplerDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-		samplerDescriptorWrite.pImageInfo = imageInfos.data();
-		samplerDescriptorWrite.pBufferInfo = nullptr;
-		samplerDescriptorWrite.pTexelBufferView = nullptr;
-
-		vkUpdateDescriptorSets(device, 1, &samplerDescriptorWrite, 0, nullptr);
+		VkDescriptorUpdateTemplateEntry instanceEntry = {};
+		instanceEntry.dstBinding = 0;
+		instanceEntry.dstArrayElement = 0;
+		instanceEntry.descriptorCount = 1;
+		instanceEntry.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		instanceEntry.offset = 0;
+		instanceEntry.stride = sizeof(VkDescriptorBufferInfo);
+		data3D.instanceTemplateOptional.emplace(device, data3D.dynamicDescriptorSetLayout,
+			std::vector<VkDescriptorUpdateTemplateEntry>{ instanceEntry });
+		VkDescriptorUpdateTemplateEntry spriteEntry = instanceEntry;
+		data2D.spriteTemplateOptional.emplace(device, data2D.dynamicDescriptorSetLayout,
+			std::vector<VkDescriptorUpdateTemplateEntry>{ spriteEntry });
+		// frame uniforms, light list, cluster ranges and light indices in binding order
+		std::vector<VkDescriptorUpdateTemplateEntry> lightingEntries;
+		for (uint32_t binding = 0; binding < 4; ++binding)
+		{
+			VkDescriptorUpdateTemplateEntry entry = instanceEntry;
+			entry.dstBinding = binding;
+			entry.descriptorType = binding == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			entry.offset = binding * sizeof(VkDescriptorBufferInfo);
+			lightingEntries.push_back(entry);
+		}
+		data3D.lightingTemplateOptional.emplace(device, data3D.staticDescriptorSetLayout, lightingEntries);
+		auto frameDescriptorSizes = DescriptorPoolSizes(
+			{ configs.c3D.staticDescriptorSetLayout, configs.c3D.dynamicDescriptorSetLayout, configs.c2D.dynamicDescriptorSetLayout },
+			DescriptorSetsPerPool);
 
+		size_t framesInFlight = vulkanInitData.value("FramesInFlight", DefaultFramesInFlight);
+		framesInFlight = std::max(framesInFlight, size_t(1));
 		renderCommandPool = deviceOptional->CreateCommandPool(graphicsQueueID, false, true);
 		std::vector<VkCommandBuffer> renderCommandBuffers = 
-			deviceOptional->AllocateCommandBuffers(renderCommandPool, BufferCount);
-		for (auto i = 0; i < BufferCount; ++i)
+			deviceOptional->AllocateCommandBuffers(renderCommandPool, gsl::narrow<uint32_t>(framesInFlight));
+		perFrameResources.resize(framesInFlight);
+		for (auto i = 0U; i < framesInFlight; ++i)
 		{
-			perImageResources[i].renderCommandBufferExecutedFence = deviceOptional->CreateFence(true);
-			perImageResources[i].imageRenderedSemaphore = deviceOptional->CreateSemaphore();
+			auto& frame = perFrameResources[i];
+			frame.renderCommandBuffer = renderCommandBuffers[i];
+			frame.imageAcquiredSemaphore = deviceOptional->CreateSemaphore();
+			frame.threadCommandPools.resize(threadPoolOptional->GetThreadCount());
+			for (auto& threadCommandPool : frame.threadCommandPools)
+			{
+				threadCommandPool.pool = deviceOptional->CreateCommandPool(graphicsQueueID, true, false);
+			}
+			frame.descriptorsOptional.emplace(device, frameDescriptorSizes, DescriptorSetsPerPool);
+			frame.lighting.uniforms = reinterpret_cast<FrameUniforms*>(
+				CreateMappedBuffer(frame.lighting.uniformBuffer, sizeof(FrameUniforms), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT));
+			frame.lighting.ranges = reinterpret_cast<ClusterRange*>(
+				CreateMappedBuffer(frame.lighting.rangeBuffer, ClusterCount * sizeof(ClusterRange), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
 		}
 
 		SetClearColor(0.f, 0.f, 0.f, 0.f);
 
-		renderPass = StoreHandle(
-			deviceOptional->CreateRenderPass(
-				surfaceFormat,
-				configs.renderPass),
-			configs.renderPass,
-			renderPasses);
-
 		CreateSwapchain();
 
-		data2D.pipelineLayout = StoreHandle(
-			deviceOptional->CreatePipelineLayout(
-				data2D.fragmentDescriptorSetLayout,
-				configs.pipelineLayout2D),
-			configs.pipelineLayout2D,
-			pipelineLayouts);
-
-		std::map<VkShaderModule, gsl::span<gsl::byte>> specData;
-		specData[data2D.fragmentShader] = gsl::make_span((gsl::byte*)&imageCount, sizeof(uint32_t));
-
-		data2D.pipeline = StoreHandle(
-			deviceOptional->CreateGraphicsPipeline(
-				data2D.pipelineLayout,
-				renderPass,
-				shaderModules,
-				specData,
-				configs.pipeline2D),
-			configs.pipeline2D,
-			pipelines);
+		lodBias = vulkanInitData.value("LODBias", 0.f);
+
+		uint32_t targetFrameRate = vulkanInitData.value("TargetFrameRate", 0U);
+		auto targetFrameTime = targetFrameRate > 0 ?
+			std::chrono::duration_cast<nanoseconds>(std::chrono::seconds(1)) / targetFrameRate :
+			nanoseconds::zero();
+		framePacer = FramePacer(UpdateDuration, targetFrameTime);
 
 		startupTimePoint = NowMilliseconds();
 		currentSimulationTime = startupTimePoint;
+		updatePacer.Start(startupTimePoint);
+		framePacer.Start(startupTimePoint);
 
 		std::thread gameLoopThread(&VulkanApp::GameThread, this);
+		std::thread renderThread(&VulkanApp::RenderThread, this);
+		std::thread presentThread(&VulkanApp::PresentThread, this);
 
 		// Event loop
 		while (!glfwWindowShouldClose(window))
@@ -338,10 +417,18 @@ namespace vka
 		}
 		gameLoop = false;
 		gameLoopThread.join();
+		renderThread.join();
+		presentLoop = false;
+		{
+			std::lock_guard<std::mutex> lock(presentWakeMutex);
+		}
+		presentWake.notify_one();
+		presentThread.join();
 		vkDeviceWaitIdle(device);
+		deviceOptional->SavePipelineCache();
 	}
 
-	void VulkanApp::LoadModelFromFile(std::string path, entt::HashedString fileName)
+	void VulkanApp::LoadModelFromFile(std::string path, entt::HashedString fileName, VertexFormat vertexFormat)
 	{
 		auto f = std::ifstream(path + std::string(fileName));
 		json j;
@@ -355,7 +442,14 @@ namespace vka
 			buffers.push_back(fileIO::readFile(path + bufferFileName));
 		}
 
-		auto &model = data3D.models[fileName];
+		auto drawID = gsl::narrow<uint32_t>(data3D.models.size());
+		auto [entry, inserted] = data3D.models.try_emplace(fileName);
+		auto &model = entry->second;
+		if (inserted)
+		{
+			model.drawID = drawID;
+		}
+		model.vertexFormat = vertexFormat;
 
 		for (const auto &node : j["nodes"])
 		{
@@ -366,6 +460,8 @@ namespace vka
 			else
 			{
 				detail::LoadMesh(model.full, node, j, buffers);
+				GenerateLODs(model.full, LODCount);
+				GenerateMeshlets(model.full);
 			}
 		}
 	}
@@ -374,7 +470,8 @@ namespace vka
 		const HashType imageID, 
 		const Bitmap &bitmap)
 	{
-		data2D.images[imageID] = vka::CreateImage2D(
+		auto& image = data2D.images[imageID];
+		image = vka::CreateImage2D(
 			device,
 			utilityCommandBuffer,
 			utilityCommandFence,
@@ -382,6 +479,48 @@ namespace vka
 			bitmap,
 			deviceOptional->GetGraphicsQueueID(),
 			deviceOptional->GetGraphicsQueue());
+		image.imageOffset = data2D.textureSlotsOptional->Allocate();
+
+		// slots nothing samples yet may be written while frames are in flight
+		if (data2D.bindless && data2D.staticDescriptorSet != VK_NULL_HANDLE)
+		{
+			WriteTextureDescriptor(gsl::narrow<uint32_t>(image.imageOffset), image.view.get());
+		}
+	}
+
+	void VulkanApp::WriteTextureDescriptor(uint32_t slot, VkImageView view)
+	{
+		VkDescriptorImageInfo imageInfo = {};
+		imageInfo.sampler = VK_NULL_HANDLE;
+		imageInfo.imageView = view;
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		VkWriteDescriptorSet descriptorWrite = {};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.pNext = nullptr;
+		descriptorWrite.dstSet = data2D.staticDescriptorSet;
+		descriptorWrite.dstBinding = TextureBinding2D;
+		descriptorWrite.dstArrayElement = slot;
+		descriptorWrite.descriptorCount = 1;
+		descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		descriptorWrite.pImageInfo = &imageInfo;
+		descriptorWrite.pBufferInfo = nullptr;
+		descriptorWrite.pTexelBufferView = nullptr;
+
+		vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+	}
+
+	std::string VulkanApp::ConfigVariant(const std::string& path)
+	{
+		static const std::map<std::string, std::string> bindlessVariants = {
+			{ "config/2D/staticDescriptorSetLayout.json", "config/2D/bindlessDescriptorSetLayout.json" },
+			{ "config/2D/fragmentShader.json", "config/2D/bindlessFragmentShader.json" } };
+		auto variant = bindlessVariants.find(path);
+		if (data2D.bindless && variant != bindlessVariants.end())
+		{
+			return variant->second;
+		}
+		return path;
 	}
 
 	void VulkanApp::CreateSprite(
@@ -391,42 +530,94 @@ namespace vka
 	{
 		Sprite sprite;
 		sprite.imageID = imageID;
+		sprite.imageOffset = data2D.images.at(imageID).imageOffset;
 		sprite.quad = quad;
 		data2D.sprites[spriteName] = sprite;
 	}
 
-	void VulkanApp::AcquireNextImage(VkFence & fence)
+	bool VulkanApp::AcquireNextImage(VkSemaphore imageAcquiredSemaphore)
 	{
-		auto imagePresentedFence = imagePresentedFencePool.unpoolOrCreate(deviceOptional->CreateFence);
 		auto acquireResult = vkAcquireNextImageKHR(device, swapchain,
-			0, VK_NULL_HANDLE,
-			imagePresentedFence, &nextImage);
+			AcquireTimeout, imageAcquiredSemaphore,
+			VK_NULL_HANDLE, &nextImage);
+		if (acquireResult == VK_SUCCESS || acquireResult == VK_SUBOPTIMAL_KHR)
+		{
+			RetireReplacedSemaphores(nextImage);
+		}
 
-		auto successResult = HandleRenderErrors(acquireResult);
-		if (successResult == RenderResults::Return)
+		// a suboptimal image was still acquired and its semaphore will signal, so
+		// draw it and recreate before the next frame like a suboptimal present
+		if (acquireResult == VK_SUBOPTIMAL_KHR)
 		{
-			imagePresentedFencePool.pool(imagePresentedFence);
-			return;
+			auto expected = VK_SUCCESS;
+			presentResult.compare_exchange_strong(expected, acquireResult);
+			return true;
 		}
+		return HandleRenderErrors(acquireResult) == RenderResults::Continue;
 	}
 
-	void VulkanApp::BeginRenderPass(const uint32_t & instanceCount)
+	void VulkanApp::RetireReplacedSemaphores(uint32_t imageIndex)
 	{
-		VkFence imagePresentedFence = 0;
-		AcquireNextImage(imagePresentedFence);
+		// handing the index out again means the presents that waited on the
+		// replaced semaphores for it have been processed; indices the new
+		// swapchain lacks never come back, those wait out the old swapchain
+		for (size_t i = 0; i < replacedRenderedSemaphores.size();)
+		{
+			const auto& replaced = replacedRenderedSemaphores[i];
+			auto reacquired = replaced.first == imageIndex;
+			if (reacquired || replaced.first >= perImageResources.size())
+			{
+				auto retireValue = timelineOptional->GetSubmittedValue();
+				if (!reacquired)
+				{
+					retireValue += perFrameResources.size();
+				}
+				deviceOptional->RetireSemaphore(replaced.second, retireValue);
+				replacedRenderedSemaphores[i] = replacedRenderedSemaphores.back();
+				replacedRenderedSemaphores.pop_back();
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
 
-		auto renderCommandBufferExecutedFence = perImageResources[nextImage].renderCommandBufferExecutedFence;
-		auto renderCommandBuffer = perImageResources[nextImage].renderCommandBuffer;
-		auto framebuffer = perImageResources[nextImage].swap.framebuffer;
+	bool VulkanApp::BeginFrame()
+	{
+		auto& frame = perFrameResources[currentFrame];
 
+		// Wait for this frame's render command buffer to finish executing;
+		// nothing needs resetting, so a failed acquire can simply retry
+		timelineOptional->Wait(frame.frameNumber);
 
+		// whatever was retired up to the completed value is no longer in use
+		deviceOptional->CollectGarbage(timelineOptional->GetCompletedValue());
 
-		// Wait for this frame's render command buffer to finish executing
-		vkWaitForFences(device,
-			1,
-			&renderCommandBufferExecutedFence,
-			true, std::numeric_limits<uint64_t>::max());
-		vkResetFences(device, 1, &renderCommandBufferExecutedFence);
+		return AcquireNextImage(frame.imageAcquiredSemaphore);
+	}
+
+	void VulkanApp::BeginRenderPass(const uint32_t & instanceCount)
+	{
+		auto& frame = perFrameResources[currentFrame];
+		auto renderCommandBuffer = frame.renderCommandBuffer;
+		auto framebuffer = perImageResources[nextImage].swap.framebuffer;
+
+		// the instance buffer is no longer read by the GPU once the frame's timeline value is reached
+		PrepareRender(instanceCount);
+
+		// secondary command buffers from this frame's last use are done as well
+		for (auto& threadCommandPool : frame.threadCommandPools)
+		{
+			vkResetCommandPool(device, threadCommandPool.pool, 0);
+			threadCommandPool.usedCount = 0;
+		}
+		frameCounters.pipelineBinds = 0;
+		frameCounters.descriptorBinds = 0;
+		frameCounters.drawCalls = 0;
+		frameCounters.visibleInstances = 0;
+		frameCounters.culledInstances = 0;
+		frameCounters.occludedInstances = 0;
 
 		// record the command buffer
 		VkCommandBufferBeginInfo beginInfo = {};
@@ -444,29 +635,81 @@ namespace vka
 		renderPassBeginInfo.renderArea = scissorRect;
 		renderPassBeginInfo.clearValueCount = 1;
 		renderPassBeginInfo.pClearValues = &clearValue;
-		vkCmdBeginRenderPass(renderCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(renderCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	}
+
+	VkCommandBuffer VulkanApp::BeginSecondaryCommandBuffer(size_t threadIndex)
+	{
+		// only the worker with this index touches the pool, so no locking is needed
+		auto& threadCommandPool = perFrameResources[currentFrame].threadCommandPools[threadIndex];
+		if (threadCommandPool.usedCount == threadCommandPool.secondaryBuffers.size())
+		{
+			auto allocated = deviceOptional->AllocateCommandBuffers(
+				threadCommandPool.pool,
+				1,
+				VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+			threadCommandPool.secondaryBuffers.push_back(allocated.at(0));
+		}
+		auto commandBuffer = threadCommandPool.secondaryBuffers[threadCommandPool.usedCount++];
+
+		VkCommandBufferInheritanceInfo inheritanceInfo = {};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.pNext = nullptr;
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = perImageResources[nextImage].swap.framebuffer;
+		inheritanceInfo.occlusionQueryEnable = VK_FALSE;
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.pNext = nullptr;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+		return commandBuffer;
+	}
+
+	void VulkanApp::RecordInParallel(const std::vector<std::function<void(VkCommandBuffer)>>& jobs)
+	{
+		if (jobs.empty())
+		{
+			return;
+		}
+
+		std::vector<VkCommandBuffer> secondaryBuffers(jobs.size());
+		threadPoolOptional->ParallelFor(jobs.size(), jobs.size(), [&](size_t job, size_t, size_t, size_t threadIndex)
+		{
+			auto commandBuffer = BeginSecondaryCommandBuffer(threadIndex);
+			jobs[job](commandBuffer);
+			vkEndCommandBuffer(commandBuffer);
+			secondaryBuffers[job] = commandBuffer;
+		});
+
+		vkCmdExecuteCommands(
+			perFrameResources[currentFrame].renderCommandBuffer,
+			gsl::narrow<uint32_t>(secondaryBuffers.size()),
+			secondaryBuffers.data());
 	}
 
-	void VulkanApp::BindPipeline2D()
+	void VulkanApp::BindPipeline2D(VkCommandBuffer renderCommandBuffer, VkDescriptorSet spriteSet, const glm::mat4& viewProjection)
 	{
-		auto renderCommandBuffer = perImageResources[nextImage].renderCommandBuffer;
 		vkCmdBindPipeline(renderCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, data2D.pipeline);
+		++frameCounters.pipelineBinds;
 
 		vkCmdSetViewport(renderCommandBuffer, 0, 1, &viewport);
 		vkCmdSetScissor(renderCommandBuffer, 0, 1, &scissorRect);
 
-		VkDeviceSize vertexBufferOffset = 0;
-		auto vertexBuffer = data2D.vertexBuffer.buffer.get();
-		vkCmdBindVertexBuffers(
-			renderCommandBuffer, 
-			0, 
-			1,
-			&vertexBuffer,
-			&vertexBufferOffset);
+		vkCmdPushConstants(
+			renderCommandBuffer,
+			data2D.pipelineLayout,
+			VK_SHADER_STAGE_VERTEX_BIT,
+			0,
+			sizeof(viewProjection),
+			&viewProjection);
 
-		std::array<VkDescriptorSet, 2> sets = { data2D.fragmentDescriptorSet, data2D.vertexDescriptorSet };
+		std::array<VkDescriptorSet, 2> sets = { data2D.staticDescriptorSet, spriteSet };
 
-		// bind sampler and images uniforms
+		// bind the textures and the frame's sprite buffer
 		vkCmdBindDescriptorSets(
 			renderCommandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -476,44 +719,523 @@ namespace vka
 			sets.data(),
 			0, 
 			nullptr);
+		++frameCounters.descriptorBinds;
+	}
+
+	void VulkanApp::BindPipeline3D(VkCommandBuffer renderCommandBuffer, VertexFormat vertexFormat)
+	{
+		auto quantized = vertexFormat == VertexFormat::Quantized;
+		vkCmdBindPipeline(
+			renderCommandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			quantized ? data3D.quantizedPipeline : data3D.pipeline);
+		++frameCounters.pipelineBinds;
+
+		vkCmdSetViewport(renderCommandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(renderCommandBuffer, 0, 1, &scissorRect);
+
+		std::array<VkBuffer, 2> vertexBuffers = { data3D.positionBuffer.buffer.get(), data3D.normalBuffer.buffer.get() };
+		if (quantized)
+		{
+			vertexBuffers = { data3D.quantizedPositionBuffer.buffer.get(), data3D.quantizedNormalBuffer.buffer.get() };
+		}
+		std::array<VkDeviceSize, 2> vertexBufferOffsets = { 0, 0 };
+		vkCmdBindVertexBuffers(
+			renderCommandBuffer,
+			0,
+			gsl::narrow<uint32_t>(vertexBuffers.size()),
+			vertexBuffers.data(),
+			vertexBufferOffsets.data());
+
+		vkCmdBindIndexBuffer(
+			renderCommandBuffer,
+			data3D.indexBuffer.buffer.get(),
+			0,
+			VK_INDEX_TYPE_UINT16);
+
+		const auto& frame = perFrameResources[currentFrame];
+		std::array<VkDescriptorSet, 2> sets = { frame.lighting.descriptorSet, frame.instances.descriptorSet };
+		vkCmdBindDescriptorSets(
+			renderCommandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			data3D.pipelineLayout,
+			0,
+			gsl::narrow<uint32_t>(sets.size()),
+			sets.data(),
+			0,
+			nullptr);
+		++frameCounters.descriptorBinds;
+	}
+
+	CameraState VulkanApp::CaptureCameraState()
+	{
+		return {
+			camera3D.getViewProjection(),
+			camera3D.getPosition(),
+			camera3D.getProjectionScale(),
+			camera.getMatrix(),
+			camera3D.getView(),
+			camera3D.getProjection(),
+			camera3D.getNearPlane(),
+			camera3D.getFarPlane(),
+			lodBias };
+	}
+
+	uint64_t VulkanApp::ModelSortKey(uint64_t modelIndex, float distance)
+	{
+		const auto& model = data3D.models.at(modelIndex);
+		return EncodeDrawKey({
+			DrawLayerOpaque3D,
+			static_cast<uint32_t>(model.vertexFormat),
+			0,
+			model.drawID,
+			DepthKey(distance, false) });
+	}
+
+	void VulkanApp::SortDraws()
+	{
+		data3D.drawPackets.clear();
+		for (size_t i = 0; i < data3D.draws.size(); ++i)
+		{
+			data3D.drawPackets.push_back({ data3D.draws[i].sortKey, gsl::narrow<uint32_t>(i) });
+		}
+		RadixSortDrawPackets(*threadPoolOptional, data3D.drawPackets, data3D.drawPacketScratch);
+
+		std::swap(data3D.draws, data3D.unsortedDraws);
+		data3D.draws.clear();
+		for (const auto& packet : data3D.drawPackets)
+		{
+			data3D.draws.push_back(data3D.unsortedDraws[packet.index]);
+		}
+	}
+
+	void VulkanApp::RecordPreparedDraws()
+	{
+		// multi draw indirect only queues commands here, EndRenderPass records them
+		if (multiDrawIndirect)
+		{
+			RecordModelDraws(VK_NULL_HANDLE, 0, data3D.draws.size());
+			return;
+		}
+
+		std::vector<std::function<void(VkCommandBuffer)>> jobs;
+		auto drawCount = data3D.draws.size();
+		auto partitionCount = std::min(
+			threadPoolOptional->GetThreadCount(),
+			(drawCount + MinDrawsPerPartition - 1) / MinDrawsPerPartition);
+		for (size_t partition = 0; partition < partitionCount; ++partition)
+		{
+			auto begin = drawCount * partition / partitionCount;
+			auto end = drawCount * (partition + 1) / partitionCount;
+			jobs.push_back([this, begin, end](VkCommandBuffer commandBuffer)
+			{
+				RecordModelDraws(commandBuffer, begin, end);
+			});
+		}
+		RecordInParallel(jobs);
+	}
+
+	void VulkanApp::RenderSnapshotModels(const RenderSnapshot& snapshot)
+	{
+		PrepareLighting(snapshot.camera, snapshot.lights);
+		PrepareModelInstances(snapshot.camera, snapshot.models.size(), [&snapshot](size_t i) -> const ModelInstance&
+		{
+			return snapshot.models[i];
+		});
+		RecordPreparedDraws();
+	}
+
+	void VulkanApp::PrepareLighting(const CameraState& camera, const std::vector<LightInstance>& lights)
+	{
+		auto& clusters = data3D.lightClusters;
+		clusters.Build(camera.projection, camera.nearPlane, camera.farPlane);
+		auto& viewLights = data3D.viewLights;
+		viewLights.clear();
+		for (const auto& light : lights)
+		{
+			viewLights.emplace_back(glm::vec3(camera.view * glm::vec4(light.position, 1.f)), light.radius);
+		}
+		clusters.Assign(viewLights);
+		const auto& indices = clusters.GetIndices();
+
+		// storage buffers may not be empty, so both keep room for one element
+		auto& lighting = perFrameResources[currentFrame].lighting;
+		if (lighting.lightCapacity < std::max(lights.size(), size_t(1)))
+		{
+			CreateLightBuffer(currentFrame, std::max(lights.size(), size_t(1)));
+		}
+		if (lighting.indexCapacity < std::max(indices.size(), size_t(1)))
+		{
+			CreateLightIndexBuffer(currentFrame, std::max(indices.size(), size_t(1)));
+		}
+
+		lighting.uniforms->view = camera.view;
+		lighting.uniforms->projection = camera.projection;
+		lighting.uniforms->clusters = clusters.GetParameters(
+			static_cast<float>(surfaceExtent.width),
+			static_cast<float>(surfaceExtent.height),
+			gsl::narrow<uint32_t>(lights.size()));
+		for (size_t i = 0; i < lights.size(); ++i)
+		{
+			lighting.lights[i] = { viewLights[i], lights[i].color };
+		}
+		std::copy(clusters.GetRanges().begin(), clusters.GetRanges().end(), lighting.ranges);
+		std::copy(indices.begin(), indices.end(), lighting.indices);
+
+		lighting.descriptorSet = perFrameResources[currentFrame].descriptorsOptional->Allocate(data3D.staticDescriptorSetLayout);
+		std::array<VkDescriptorBufferInfo, 4> bufferInfos = {};
+		std::array<VkBuffer, 4> buffers = {
+			lighting.uniformBuffer.buffer.get(),
+			lighting.lightBuffer.buffer.get(),
+			lighting.rangeBuffer.buffer.get(),
+			lighting.indexBuffer.buffer.get() };
+		for (size_t i = 0; i < buffers.size(); ++i)
+		{
+			bufferInfos[i].buffer = buffers[i];
+			bufferInfos[i].offset = 0;
+			bufferInfos[i].range = VK_WHOLE_SIZE;
+		}
+		data3D.lightingTemplateOptional->Update(lighting.descriptorSet, bufferInfos.data());
+	}
+
+	void VulkanApp::RenderSnapshotSprites(const RenderSnapshot& snapshot)
+	{
+		if (snapshot.sprites.empty())
+		{
+			return;
+		}
+		// the 2D camera looks down -z from z = 0; equal depths keep snapshot order
+		auto& packets = data2D.spritePackets;
+		packets.clear();
+		for (size_t i = 0; i < snapshot.sprites.size(); ++i)
+		{
+			auto depth = -snapshot.sprites[i].transform[3].z;
+			packets.push_back({ EncodeDrawKey({ DrawLayerBlended2D, 0, 0, 0, DepthKey(depth, true) }), gsl::narrow<uint32_t>(i) });
+		}
+		RadixSortDrawPackets(*threadPoolOptional, packets, data2D.spritePacketScratch);
+
+		auto& batcher = data2D.spriteBatcher;
+		batcher.Clear();
+		for (const auto& packet : packets)
+		{
+			const auto& instance = snapshot.sprites[packet.index];
+			const auto& sprite = data2D.sprites.at(instance.spriteIndex);
+			batcher.Add(MakeSpriteData(
+				instance.transform,
+				QuadRect(sprite.quad),
+				QuadUVRect(sprite.quad),
+				instance.color,
+				gsl::narrow<uint32_t>(sprite.imageOffset)));
+		}
+
+		// the GPU finished with this frame's buffer before BeginFrame returned
+		auto& frame = perFrameResources[currentFrame];
+		auto& sprites = frame.sprites;
+		if (sprites.capacity < batcher.size())
+		{
+			CreateSpriteBuffer(currentFrame, batcher.size());
+		}
+		sprites.descriptorSet = frame.descriptorsOptional->Allocate(data2D.dynamicDescriptorSetLayout);
+		VkDescriptorBufferInfo bufferInfo = {};
+		bufferInfo.buffer = sprites.buffer.buffer.get();
+		bufferInfo.offset = 0;
+		bufferInfo.range = VK_WHOLE_SIZE;
+		data2D.spriteTemplateOptional->Update(sprites.descriptorSet, &bufferInfo);
+
+		// per instance texture indices need descriptor indexing, otherwise each texture change is a new draw
+		const auto& batches = batcher.Write(sprites.mapped, 0, !data2D.bindless);
+		auto spriteSet = sprites.descriptorSet;
+		auto viewProjection = snapshot.camera.viewProjection2D;
+		RecordInParallel({ [this, &batches, spriteSet, viewProjection](VkCommandBuffer commandBuffer)
+		{
+			BindPipeline2D(commandBuffer, spriteSet, viewProjection);
+			for (const auto& batch : batches)
+			{
+				vkCmdDraw(commandBuffer, VerticesPerQuad, batch.instanceCount, 0, batch.firstInstance);
+			}
+			frameCounters.drawCalls += gsl::narrow<uint32_t>(batches.size());
+		} });
 	}
 
-	void VulkanApp::BindPipeline3D()
+	void VulkanApp::RecordModelDraws(VkCommandBuffer commandBuffer, size_t begin, size_t end)
 	{
+		// draws are sorted by pipeline first, so formats rarely change within a partition
+		auto boundVertexFormat = std::optional<VertexFormat>();
+		for (auto i = begin; i < end; ++i)
+		{
+			const auto& draw = data3D.draws[i];
+			if (!multiDrawIndirect && boundVertexFormat != draw.vertexFormat)
+			{
+				BindPipeline3D(commandBuffer, draw.vertexFormat);
+				boundVertexFormat = draw.vertexFormat;
+			}
+			RenderModel(
+				commandBuffer,
+				draw.modelIndex,
+				gsl::make_span(data3D.drawListRanges.data() + draw.firstRange, draw.rangeCount),
+				draw.firstInstance,
+				draw.instanceCount);
+		}
 	}
 
-	void VulkanApp::RenderModel(const uint64_t modelIndex, const glm::mat4 modelMatrix, const glm::vec4 modelColor)
+	void VulkanApp::RenderModel(VkCommandBuffer renderCommandBuffer, const uint64_t modelIndex, gsl::span<const IndexRange> indexRanges, const uint32_t firstInstance, const uint32_t instanceCount)
 	{
+		const auto& model = data3D.models.at(modelIndex);
+		const auto& mesh = model.full;
+
+		// with multi draw indirect the draws are only recorded by FlushIndirectDraws
+		if (multiDrawIndirect)
+		{
+			auto& commands = data3D.indirectCommands[static_cast<size_t>(model.vertexFormat)];
+			for (const auto& [firstIndex, indexCount] : indexRanges)
+			{
+				VkDrawIndexedIndirectCommand command = {};
+				command.indexCount = gsl::narrow<uint32_t>(indexCount);
+				command.instanceCount = instanceCount;
+				command.firstIndex = gsl::narrow<uint32_t>(firstIndex);
+				command.vertexOffset = gsl::narrow<int32_t>(mesh.firstVertex);
+				command.firstInstance = firstInstance;
+				commands.push_back(command);
+			}
+			return;
+		}
+
+		for (const auto& [firstIndex, indexCount] : indexRanges)
+		{
+			vkCmdDrawIndexed(
+				renderCommandBuffer,
+				gsl::narrow<uint32_t>(indexCount),
+				instanceCount,
+				gsl::narrow<uint32_t>(firstIndex),
+				gsl::narrow<int32_t>(mesh.firstVertex),
+				firstInstance);
+		}
+		frameCounters.drawCalls += gsl::narrow<uint32_t>(indexRanges.size());
 	}
 
 	void VulkanApp::EndRenderPass()
 	{
+		if (multiDrawIndirect)
+		{
+			RecordInParallel({ [this](VkCommandBuffer commandBuffer) { FlushIndirectDraws(commandBuffer); } });
+		}
+
+		auto& frame = perFrameResources[currentFrame];
+		auto renderCommandBuffer = frame.renderCommandBuffer;
+		vkCmdEndRenderPass(renderCommandBuffer);
+		vkEndCommandBuffer(renderCommandBuffer);
+
+		// color output waits for the presentation engine to release the image
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = nullptr;
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = &frame.imageAcquiredSemaphore;
+		submitInfo.pWaitDstStageMask = &waitStage;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &renderCommandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &perImageResources[nextImage].imageRenderedSemaphore;
+
+		std::unique_lock<std::mutex> queueLock(sharedQueueMutex, std::defer_lock);
+		if (presentQueueShared)
+		{
+			queueLock.lock();
+		}
+		uint64_t frameValue = 0;
+		auto submitResult = timelineOptional->Submit(
+			deviceOptional->GetGraphicsQueue(),
+			submitInfo,
+			frameValue);
+		HandleRenderErrors(submitResult);
+		frame.frameNumber = frameValue;
+		lastFrameCounts = {
+			frameCounters.pipelineBinds,
+			frameCounters.descriptorBinds,
+			frameCounters.drawCalls,
+			frameCounters.visibleInstances,
+			frameCounters.culledInstances,
+			frameCounters.occludedInstances };
+	}
+
+	void VulkanApp::FlushIndirectDraws(VkCommandBuffer renderCommandBuffer)
+	{
+		if (!multiDrawIndirect)
+		{
+			return;
+		}
+
+		size_t commandCount = 0;
+		for (const auto& commands : data3D.indirectCommands)
+		{
+			commandCount += commands.size();
+		}
+		if (commandCount == 0)
+		{
+			return;
+		}
+
+		auto& indirect = perFrameResources[currentFrame].indirect;
+		if (indirect.capacity < commandCount)
+		{
+			CreateIndirectBuffer(currentFrame, commandCount);
+		}
+
+		auto indirectBuffer = indirect.buffer.buffer.get();
+		auto countOffset = VkDeviceSize(0);
+		auto commandOffset = VkDeviceSize(IndirectCountHeaderSize);
+		for (auto format = 0U; format < data3D.indirectCommands.size(); ++format)
+		{
+			auto& commands = data3D.indirectCommands[format];
+			if (commands.empty())
+			{
+				countOffset += sizeof(uint32_t);
+				continue;
+			}
+
+			auto drawCount = gsl::narrow<uint32_t>(commands.size());
+			std::memcpy(indirect.mapped + countOffset, &drawCount, sizeof(uint32_t));
+			std::memcpy(indirect.mapped + commandOffset, commands.data(), commands.size() * sizeof(VkDrawIndexedIndirectCommand));
+
+			BindPipeline3D(renderCommandBuffer, static_cast<VertexFormat>(format));
+			// the count draw has one count slot per format, so lists past the
+			// device limit take the split path below instead
+			if (drawIndirectCount && drawCount <= maxDrawIndirectCount)
+			{
+				vkCmdDrawIndexedIndirectCountAMD(
+					renderCommandBuffer,
+					indirectBuffer,
+					commandOffset,
+					indirectBuffer,
+					countOffset,
+					drawCount,
+					sizeof(VkDrawIndexedIndirectCommand));
+				++frameCounters.drawCalls;
+			}
+			else
+			{
+				// drawCount is limited by the device, larger lists are split
+				for (uint32_t first = 0; first < drawCount; first += maxDrawIndirectCount)
+				{
+					vkCmdDrawIndexedIndirect(
+						renderCommandBuffer,
+						indirectBuffer,
+						commandOffset + first * sizeof(VkDrawIndexedIndirectCommand),
+						std::min(drawCount - first, maxDrawIndirectCount),
+						sizeof(VkDrawIndexedIndirectCommand));
+					++frameCounters.drawCalls;
+				}
+			}
+
+			countOffset += sizeof(uint32_t);
+			commandOffset += commands.size() * sizeof(VkDrawIndexedIndirectCommand);
+			commands.clear();
+		}
 	}
 
 	void VulkanApp::PresentImage()
 	{
+		// the frame is submitted, so its resources belong to the GPU until the timeline passes it
+		currentFrame = (currentFrame + 1) % perFrameResources.size();
+
+		PresentRequest request = { swapchain, nextImage, perImageResources[nextImage].imageRenderedSemaphore };
+		++pendingPresents;
+		while (!presentRequests.tryPush(request))
+		{
+			std::this_thread::yield();
+		}
+		{
+			std::lock_guard<std::mutex> lock(presentWakeMutex);
+		}
+		presentWake.notify_one();
 	}
 
-	void VulkanApp::PrepareRender(uint32_t instanceCount)
+	void VulkanApp::PresentThread()
 	{
-		if (perImageResources[nextImage].uniforms.matrices.dynamic.capacity < instanceCount)
+		for (;;)
 		{
-			VkDeviceSize alignment = 0;
-			auto dynamicBufferSize = sizeof(glm::mat4) * 2;
-			if (dynamicBufferSize < uniformBufferAlignment)
+			auto request = presentRequests.tryPop();
+			if (!request.has_value())
 			{
-				alignment = uniformBufferAlignment;
+				std::unique_lock<std::mutex> lock(presentWakeMutex);
+				presentWake.wait(lock, [this]() { return !presentRequests.empty() || !presentLoop; });
+				if (presentRequests.empty())
+				{
+					return;
+				}
+				continue;
 			}
-			else
+
+			VkPresentInfoKHR presentInfo = {};
+			presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+			presentInfo.pNext = nullptr;
+			presentInfo.waitSemaphoreCount = 1;
+			presentInfo.pWaitSemaphores = &request->waitSemaphore;
+			presentInfo.swapchainCount = 1;
+			presentInfo.pSwapchains = &request->swapchain;
+			presentInfo.pImageIndices = &request->imageIndex;
+			presentInfo.pResults = nullptr;
+
+			VkResult result;
+			{
+				std::unique_lock<std::mutex> queueLock(sharedQueueMutex, std::defer_lock);
+				if (presentQueueShared)
+				{
+					queueLock.lock();
+				}
+				result = vkQueuePresentKHR(presentQueue, &presentInfo);
+			}
+
+			// suboptimal and out of date are handled by the render thread before its next frame
+			if (result != VK_SUCCESS)
 			{
-				auto multiple = (float)dynamicBufferSize / (float)uniformBufferAlignment;
-				alignment = (VkDeviceSize)std::ceil(multiple) * uniformBufferAlignment;
+				auto expected = VK_SUCCESS;
+				presentResult.compare_exchange_strong(expected, result);
 			}
-			VkDeviceSize newSize = instanceCount * alignment;
-			CreateMatrixBuffer(nextImage, newSize);
+			--pendingPresents;
+		}
+	}
+
+	void VulkanApp::WaitForPresents()
+	{
+		while (pendingPresents != 0)
+		{
+			std::this_thread::yield();
 		}
 	}
 
+	void VulkanApp::PrepareRender(uint32_t instanceCount)
+	{
+		auto& frame = perFrameResources[currentFrame];
+		auto& instances = frame.instances;
+		instances.count = 0;
+		if (instances.capacity < instanceCount)
+		{
+			CreateInstanceBuffer(currentFrame, instanceCount);
+		}
+
+		// the frame's previous sets are done too, so allocating fresh ones is
+		// cheaper than tracking which still match
+		frame.descriptorsOptional->Reset();
+		instances.descriptorSet = frame.descriptorsOptional->Allocate(data3D.dynamicDescriptorSetLayout);
+		VkDescriptorBufferInfo bufferInfo = {};
+		bufferInfo.buffer = instances.buffer.buffer.get();
+		bufferInfo.offset = 0;
+		bufferInfo.range = VK_WHOLE_SIZE;
+		data3D.instanceTemplateOptional->Update(instances.descriptorSet, &bufferInfo);
+	}
+
+	uint32_t VulkanApp::WriteInstances(const InstanceData* data, size_t count)
+	{
+		auto& instances = perFrameResources[currentFrame].instances;
+		Expects(instances.count + count <= instances.capacity);
+		auto firstInstance = instances.count;
+		std::memcpy(instances.mapped + firstInstance, data, count * sizeof(InstanceData));
+		instances.count += count;
+		return gsl::narrow<uint32_t>(firstInstance);
+	}
+
 	enum class BufferType
 	{
 		Index,
@@ -528,7 +1250,7 @@ namespace vka
 		std::vector<T>& data,
 		BufferType bufferType,
 		VkCommandBuffer commandBuffer,
-		VkFence fence)
+		GpuTimeline& timeline)
 	{
 		auto dataByteLength = data.size() * sizeof(T);
 		auto stagingBuffer = CreateBufferUnique(
@@ -576,43 +1298,26 @@ namespace vka
 		bufferCopy.dstOffset = 0;
 		bufferCopy.size = dataByteLength;
 
-		CopyToBuffer(
+		RecordBufferCopy(
 			commandBuffer,
-			graphicsQueue,
 			stagingBuffer.buffer.get(),
 			buffer.buffer.get(),
-			bufferCopy,
-			fence);
+			bufferCopy);
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = nullptr;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		uint64_t copyValue = 0;
+		timeline.Submit(graphicsQueue, submitInfo, copyValue);
 
 		// wait for vertex buffer copy to finish
-		vkWaitForFences(device, 1, &fence, (VkBool32)true,
-			std::numeric_limits<uint64_t>::max());
-		vkResetFences(device, 1, &fence);
+		timeline.Wait(copyValue);
 
 		return std::move(buffer);
 	}
 
-	void VulkanApp::CreateVertexBuffers2D()
-	{
-		auto graphicsQueueFamilyID = deviceOptional->GetGraphicsQueueID();
-		auto graphicsQueue = deviceOptional->GetGraphicsQueue();
-
-		if (data2D.quads.size() == 0)
-		{
-			std::runtime_error("Error: no vertices loaded.");
-		}
-		// create vertex buffers
-
-		data2D.vertexBuffer = CreateVertexBufferStageData(device,
-			deviceOptional->GetAllocator(),
-			graphicsQueueFamilyID,
-			graphicsQueue,
-			data2D.quads,
-			BufferType::Vertex,
-			utilityCommandBuffer,
-			utilityCommandFence);
-	}
-
 	void VulkanApp::CreateVertexBuffers3D()
 	{
 		auto graphicsQueueFamilyID = deviceOptional->GetGraphicsQueueID();
@@ -624,20 +1329,51 @@ namespace vka
 		}
 		size_t indexCount = 0;
 		size_t vertexCount = 0;
+		size_t quantizedVertexCount = 0;
 		for (auto &[id, model] : data3D.models)
 		{
 			model.full.firstIndex = indexCount;
-			model.full.firstVertex = vertexCount;
 
 			auto newIndicesCount = model.full.indices.size();
 			auto newVerticesCount = model.full.positions.size();
 			indexCount += newIndicesCount;
-			vertexCount += newVerticesCount;
 
 			data3D.vertexIndices.insert(std::end(data3D.vertexIndices),
 				model.full.indices.begin(),
 				model.full.indices.end());
 
+			// LODs reuse the full mesh's vertices, only their indices are appended
+			for (auto& lod : model.full.lods)
+			{
+				lod.firstIndex = indexCount;
+				indexCount += lod.indices.size();
+				data3D.vertexIndices.insert(std::end(data3D.vertexIndices),
+					lod.indices.begin(),
+					lod.indices.end());
+			}
+
+			// quantized models live in their own vertex buffers, so vertex offsets are per format
+			if (model.vertexFormat == VertexFormat::Quantized)
+			{
+				model.full.firstVertex = quantizedVertexCount;
+				quantizedVertexCount += newVerticesCount;
+
+				auto bounds = ComputeQuantizationBounds(model.full.positions);
+				model.dequantize = bounds.GetDequantizeMatrix();
+				for (const auto& position : model.full.positions)
+				{
+					data3D.quantizedPositions.push_back(QuantizePosition(position, bounds));
+				}
+				for (const auto& normal : model.full.normals)
+				{
+					AppendQuantizedNormal(data3D.quantizedNormals, normal, bounds, data3D.normalEncoding);
+				}
+				continue;
+			}
+
+			model.full.firstVertex = vertexCount;
+			vertexCount += newVerticesCount;
+
 			data3D.vertexPositions.insert(std::end(data3D.vertexPositions),
 				model.full.positions.begin(),
 				model.full.positions.end());
@@ -659,7 +1395,7 @@ namespace vka
 			data3D.vertexIndices,
 			BufferType::Index,
 			utilityCommandBuffer,
-			utilityCommandFence);
+			*timelineOptional);
 
 		data3D.positionBuffer = CreateVertexBufferStageData<PositionType>(device,
 			allocator,
@@ -668,7 +1404,7 @@ namespace vka
 			data3D.vertexPositions,
 			BufferType::Vertex,
 			utilityCommandBuffer,
-			utilityCommandFence);
+			*timelineOptional);
 
 		data3D.normalBuffer = CreateVertexBufferStageData<NormalType>(device,
 			allocator,
@@ -677,24 +1413,284 @@ namespace vka
 			data3D.vertexNormals,
 			BufferType::Vertex,
 			utilityCommandBuffer,
-			utilityCommandFence);
+			*timelineOptional);
+
+		if (quantizedVertexCount == 0)
+		{
+			return;
+		}
+
+		data3D.quantizedPositionBuffer = CreateVertexBufferStageData<QuantizedPosition>(device,
+			allocator,
+			graphicsQueueFamilyID,
+			graphicsQueue,
+			data3D.quantizedPositions,
+			BufferType::Vertex,
+			utilityCommandBuffer,
+			*timelineOptional);
+
+		data3D.quantizedNormalBuffer = CreateVertexBufferStageData<uint8_t>(device,
+			allocator,
+			graphicsQueueFamilyID,
+			graphicsQueue,
+			data3D.quantizedNormals,
+			BufferType::Vertex,
+			utilityCommandBuffer,
+			*timelineOptional);
 	}
 
-	void VulkanApp::CreateMatrixBuffer(size_t imageIndex, VkDeviceSize newSize)
+	void VulkanApp::CreateGraphObjects()
 	{
-		VkMemoryPropertyFlags memProps = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		auto graph = LoadObjectGraph(LoadConfig("config/dependencyGraph.json"));
+		auto vertexCount = boost::num_vertices(graph);
+
+		// specialization data per pipeline and shader stage; both 3D pipelines share
+		// their shader modules, the specialization decides how normals are decoded
+		uint32_t imageCount = std::max(data2D.textureSlotsOptional->GetSlotCount(), 1U);
+		VertexSpecializationData floatSpecialization = { VK_FALSE };
+		VertexSpecializationData quantizedSpecialization = { VK_TRUE };
+		auto asBytes = [](auto& value) { return gsl::make_span((gsl::byte*)&value, sizeof(value)); };
+		std::map<std::pair<std::string, std::string>, gsl::span<gsl::byte>> specializations = {
+			{ { "config/3D/pipeline.json", "config/3D/vertexShader.json" }, asBytes(floatSpecialization) },
+			{ { "config/3D/quantizedPipeline.json", "config/3D/vertexShader.json" }, asBytes(quantizedSpecialization) } };
+		// the bindless fragment shader sizes its texture array at runtime
+		if (!data2D.bindless)
+		{
+			specializations[{ "config/2D/pipeline.json", "config/2D/fragmentShader.json" }] = asBytes(imageCount);
+		}
+
+		// each vertex writes only its own slot, dependents read it once it is built
+		struct GraphObject
+		{
+			json config;
+			VkRenderPass renderPass = VK_NULL_HANDLE;
+			VkShaderModule shaderModule = VK_NULL_HANDLE;
+			VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+			VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+			VkPipeline pipeline = VK_NULL_HANDLE;
+		};
+		std::vector<GraphObject> objects(vertexCount);
+
+		// dependencies in vertex order, which is also descriptor set order
+		auto dependenciesOf = [&graph](size_t vertex)
+		{
+			std::vector<size_t> dependencies;
+			for (auto [edge, end] = boost::in_edges(vertex, graph); edge != end; ++edge)
+			{
+				dependencies.push_back(boost::source(*edge, graph));
+			}
+			std::sort(dependencies.begin(), dependencies.end());
+			return dependencies;
+		};
+
+		// instance, device and swapchain are created on this thread around the build
+		auto isPending = [&graph](size_t vertex)
+		{
+			switch (graph[vertex].vulkanType)
+			{
+			case VulkanType::RenderPass:
+			case VulkanType::ShaderModule:
+			case VulkanType::DescriptorSetLayout:
+			case VulkanType::PipelineLayout:
+			case VulkanType::Pipeline:
+				return true;
+			default:
+				return false;
+			}
+		};
+
+		BuildObjectGraph(*threadPoolOptional, graph, isPending, [&](size_t vertex, size_t)
+		{
+			const auto& node = graph[vertex];
+			auto& object = objects[vertex];
+			// the 2D static layout was sized to the loaded textures at startup
+			object.config = node.path == "config/2D/staticDescriptorSetLayout.json" ?
+				configs.c2D.staticDescriptorSetLayout :
+				LoadConfig(ConfigVariant(node.path));
+			switch (node.vulkanType)
+			{
+			case VulkanType::RenderPass:
+				object.renderPass = deviceOptional->CreateRenderPass(surfaceFormat, object.config);
+				break;
+			case VulkanType::ShaderModule:
+				object.shaderModule = deviceOptional->CreateShaderModule(object.config["module"]);
+				break;
+			case VulkanType::DescriptorSetLayout:
+			{
+				// layouts with sampler bindings bake in the 2D sampler
+				std::vector<VkSampler> immutableSamplers;
+				for (const auto& bindingJson : object.config["bindings"])
+				{
+					VkDescriptorType descriptorType = bindingJson["descriptorType"];
+					if (descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+						descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+					{
+						immutableSamplers = { data2D.sampler };
+					}
+				}
+				object.setLayout = deviceOptional->CreateDescriptorSetLayout(object.config, immutableSamplers);
+				break;
+			}
+			case VulkanType::PipelineLayout:
+			{
+				std::vector<VkDescriptorSetLayout> setLayouts;
+				for (auto dependency : dependenciesOf(vertex))
+				{
+					if (graph[dependency].vulkanType == VulkanType::DescriptorSetLayout)
+					{
+						setLayouts.push_back(objects[dependency].setLayout);
+					}
+				}
+				object.pipelineLayout = deviceOptional->CreatePipelineLayout(setLayouts, object.config);
+				break;
+			}
+			case VulkanType::Pipeline:
+			{
+				// the shader stages are the shader module vertices this pipeline depends on
+				VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+				VkRenderPass pipelineRenderPass = VK_NULL_HANDLE;
+				std::map<std::string, VkShaderModule> stageModules;
+				std::map<VkShaderModule, gsl::span<gsl::byte>> specData;
+				auto pipelineJson = object.config;
+				pipelineJson["shaderStageConfigs"] = json::array();
+				for (auto dependency : dependenciesOf(vertex))
+				{
+					const auto& dependencyNode = graph[dependency];
+					const auto& dependencyObject = objects[dependency];
+					switch (dependencyNode.vulkanType)
+					{
+					case VulkanType::RenderPass:
+						pipelineRenderPass = dependencyObject.renderPass;
+						break;
+					case VulkanType::PipelineLayout:
+						pipelineLayout = dependencyObject.pipelineLayout;
+						break;
+					case VulkanType::ShaderModule:
+					{
+						auto stageJson = dependencyObject.config;
+						stageJson["module"]["jsonID"]["uri"] = dependencyNode.path;
+						pipelineJson["shaderStageConfigs"].push_back(stageJson);
+						stageModules[dependencyNode.path] = dependencyObject.shaderModule;
+						auto specialization = specializations.find({ node.path, dependencyNode.path });
+						if (specialization != specializations.end())
+						{
+							specData[dependencyObject.shaderModule] = specialization->second;
+						}
+						break;
+					}
+					default:
+						break;
+					}
+				}
+				object.pipeline = deviceOptional->CreateGraphicsPipeline(
+					pipelineLayout,
+					pipelineRenderPass,
+					stageModules,
+					specData,
+					pipelineJson);
+				break;
+			}
+			default:
+				break;
+			}
+		});
+
+		auto objectAt = [&](const std::string& path) -> const GraphObject&
+		{
+			for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+			{
+				if (graph[vertex].path == path)
+				{
+					return objects[vertex];
+				}
+			}
+			throw std::runtime_error("Object graph has no vertex for " + path);
+		};
+		renderPass = objectAt("config/renderPass.json").renderPass;
+
+		data2D.staticDescriptorSetLayout = objectAt("config/2D/staticDescriptorSetLayout.json").setLayout;
+		data2D.dynamicDescriptorSetLayout = objectAt("config/2D/dynamicDescriptorSetLayout.json").setLayout;
+		data2D.vertexShader = objectAt("config/2D/vertexShader.json").shaderModule;
+		data2D.fragmentShader = objectAt("config/2D/fragmentShader.json").shaderModule;
+		data2D.pipelineLayout = objectAt("config/2D/pipelineLayout.json").pipelineLayout;
+		data2D.pipeline = objectAt("config/2D/pipeline.json").pipeline;
+
+		data3D.staticDescriptorSetLayout = objectAt("config/3D/staticDescriptorSetLayout.json").setLayout;
+		data3D.dynamicDescriptorSetLayout = objectAt("config/3D/dynamicDescriptorSetLayout.json").setLayout;
+		data3D.vertexShader = objectAt("config/3D/vertexShader.json").shaderModule;
+		data3D.fragmentShader = objectAt("config/3D/fragmentShader.json").shaderModule;
+		data3D.pipelineLayout = objectAt("config/3D/pipelineLayout.json").pipelineLayout;
+		data3D.pipeline = objectAt("config/3D/pipeline.json").pipeline;
+		data3D.quantizedPipeline = objectAt("config/3D/quantizedPipeline.json").pipeline;
+	}
+
+	void VulkanApp::CreateIndirectBuffer(size_t frameIndex, size_t capacity)
+	{
+		auto& indirect = perFrameResources[frameIndex].indirect;
+		indirect.mapped = reinterpret_cast<uint8_t*>(CreateMappedBuffer(
+			indirect.buffer,
+			IndirectCountHeaderSize + capacity * sizeof(VkDrawIndexedIndirectCommand),
+			VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT));
+		indirect.capacity = capacity;
+	}
+
+	void VulkanApp::CreateInstanceBuffer(size_t frameIndex, size_t capacity)
+	{
+		auto& instances = perFrameResources[frameIndex].instances;
+		instances.mapped = reinterpret_cast<InstanceData*>(
+			CreateMappedBuffer(instances.buffer, capacity * sizeof(InstanceData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
+		instances.capacity = capacity;
+	}
+
+	void VulkanApp::CreateSpriteBuffer(size_t frameIndex, size_t capacity)
+	{
+		auto& sprites = perFrameResources[frameIndex].sprites;
+		sprites.mapped = reinterpret_cast<SpriteData*>(
+			CreateMappedBuffer(sprites.buffer, capacity * sizeof(SpriteData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
+		sprites.capacity = capacity;
+	}
+
+	void* VulkanApp::CreateMappedBuffer(UniqueAllocatedBuffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage)
+	{
+		VkMemoryPropertyFlags memProps = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 		if (deviceOptional->HostDeviceCombined())
 		{
-			memProps |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			memProps |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 		}
-		perImageResources[imageIndex].uniforms.matrices.dynamic.buffer = CreateBufferUnique(
+		// dedicated so the buffer's memory can stay mapped for its whole lifetime
+		buffer = CreateBufferUnique(
 			device,
 			deviceOptional->GetAllocator(),
-			newSize,
-			VkBufferUsageFlagBits::VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			size,
+			usage,
 			deviceOptional->GetGraphicsQueueID(),
 			memProps,
-			false);
+			true);
+
+		void* mapped = nullptr;
+		vkMapMemory(device,
+			buffer.allocation.get().memory,
+			buffer.allocation.get().offsetInDeviceMemory,
+			buffer.allocation.get().size,
+			0,
+			&mapped);
+		return mapped;
+	}
+
+	void VulkanApp::CreateLightBuffer(size_t frameIndex, size_t capacity)
+	{
+		auto& lighting = perFrameResources[frameIndex].lighting;
+		lighting.lights = reinterpret_cast<LightData*>(
+			CreateMappedBuffer(lighting.lightBuffer, capacity * sizeof(LightData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
+		lighting.lightCapacity = capacity;
+	}
+
+	void VulkanApp::CreateLightIndexBuffer(size_t frameIndex, size_t capacity)
+	{
+		auto& lighting = perFrameResources[frameIndex].lighting;
+		lighting.indices = reinterpret_cast<uint32_t*>(
+			CreateMappedBuffer(lighting.indexBuffer, capacity * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
+		lighting.indexCapacity = capacity;
 	}
 
 	void VulkanApp::SetClearColor(float r, float g, float b, float a)
@@ -711,70 +1707,85 @@ namespace vka
 	{
 		while (gameLoop != false)
 		{
-			auto currentTime = NowMilliseconds();
+			if (surfaceResized.exchange(false))
+			{
+				UpdateCameraSize();
+			}
+
 			// Update simulation to be in sync with actual time
-			size_t spriteCount = 0;
-			while (currentTime - currentSimulationTime > UpdateDuration)
+			updatePacer.BeginFrame(NowNanoseconds());
+			auto updated = false;
+			while (updatePacer.StepUpdate())
 			{
-				currentSimulationTime += UpdateDuration;
+				currentSimulationTime = std::chrono::time_point_cast<milliseconds>(updatePacer.GetSimulationTime());
 
 				Update(currentSimulationTime);
+				updated = true;
+			}
+
+			// the render thread records this state while the next steps simulate
+			if (updated)
+			{
+				auto& snapshot = renderSnapshots.GetWriteBuffer();
+				snapshot.simulationTime = currentSimulationTime;
+				snapshot.camera = CaptureCameraState();
+				snapshot.models.clear();
+				snapshot.sprites.clear();
+				snapshot.lights.clear();
+				ExtractRenderState(snapshot);
+				renderSnapshots.Publish();
 			}
+
+			SleepUntil(updatePacer.GetNextUpdateTime());
+		}
+	}
+
+	void VulkanApp::RenderThread()
+	{
+		const auto updateStep = std::chrono::duration_cast<nanoseconds>(UpdateDuration);
+		while (gameLoop != false)
+		{
+			// keeps drawing the newest snapshot until a fresher one is published
+			renderSnapshots.Acquire();
+			const auto& snapshot = renderSnapshots.GetReadBuffer();
+
+			framePacer.BeginFrame(NowNanoseconds());
 			try
 			{
-				VkFence imagePresentedFence = 0;
-				AcquireNextImage(nextImage, imagePresentedFence);
-				FrameRender(
-					device,
-					nextImage,
-					swapchain,
-					imagePresentedFence,
-					perImageResources[nextImage].renderCommandBuffer,
-					perImageResources[nextImage].renderCommandBufferExecutedFence,
-					perImageResources[nextImage].swap.framebuffer,
-					perImageResources[nextImage].imageRenderedSemaphore,
-					[this]() { Draw(); },
-					renderPass,
-					data2D.fragmentDescriptorSet,
-					data2D.vertexDescriptorSet,
-					data3D.vertexDescriptorSet,
-					data2D.pipelineLayout,
-					data3D.pipelineLayout,
-					data2D.pipeline,
-					data3D.pipeline,
-					data2D.vertexBuffer.buffer.get(),
-					data3D.indexBuffer.buffer.get(),
-					data3D.positionBuffer.buffer.get(),
-					data3D.normalBuffer.buffer.get(),
-					deviceOptional->GetGraphicsQueue(),
-					surfaceExtent,
-					clearValue);
+				HandleRenderErrors(presentResult.exchange(VK_SUCCESS));
+
+				// waiting on the timeline and the acquire blocks rather than spins;
+				// a timed out acquire just skips drawing this iteration
+				if (BeginFrame())
+				{
+					auto sinceSnapshot = NowNanoseconds() - snapshot.simulationTime;
+					auto interpolation = std::clamp(
+						static_cast<float>(sinceSnapshot.count()) / static_cast<float>(updateStep.count()),
+						0.f,
+						1.f);
+					// Draw begins the render pass once it knows its instance count
+					Draw(snapshot, interpolation);
+					EndRenderPass();
+					PresentImage();
+				}
+				framePacer.EndFrame();
 			}
 			catch (Results::ErrorDeviceLost)
 			{
+				gameLoop = false;
 				return;
 			}
 			catch (Results::ErrorSurfaceLost)
 			{
-				CreateSurface();
-				UpdateSurfaceSize();
-				CleanUpSwapchain();
-				CreateSwapchain();
-				UpdateCameraSize();
+				RecreateSwapchain(true);
 			}
 			catch (Results::Suboptimal)
 			{
-				UpdateSurfaceSize();
-				CleanUpSwapchain();
-				CreateSwapchain();
-				UpdateCameraSize();
+				RecreateSwapchain(false);
 			}
 			catch (Results::ErrorOutOfDate)
 			{
-				UpdateSurfaceSize();
-				CleanUpSwapchain();
-				CreateSwapchain();
-				UpdateCameraSize();
+				RecreateSwapchain(false);
 			}
 		}
 	}
@@ -782,5 +1793,6 @@ namespace vka
 	void VulkanApp::UpdateCameraSize()
 	{
 		camera.setSize(glm::vec2(static_cast<float>(surfaceExtent.width), static_cast<float>(surfaceExtent.height)));
+		camera3D.setSize(glm::vec2(static_cast<float>(surfaceExtent.width), static_cast<float>(surfaceExtent.height)));
 	}
 } // namespace vka
\ No newline at end of file
@@ -22,14 +22,30 @@
 #include "mymath.hpp"
 #include "CircularQueue.hpp"
 #include "TimeHelper.hpp"
+#include "FramePacer.hpp"
+#include "TripleBuffer.hpp"
+#include "SpscQueue.hpp"
 #include "nlohmann/json.hpp"
 #include "Vertex.hpp"
 #include "Results.hpp"
 #include "Debug.hpp"
 #include "Pool.hpp"
 #include "GLTF.hpp"
+#include "LOD.hpp"
+#include "Meshlet.hpp"
+#include "VertexQuantization.hpp"
+#include "ThreadPool.hpp"
+#include "GpuTimeline.hpp"
+#include "ObjectGraph.hpp"
+#include "ConfigBlob.hpp"
+#include "TextureSlots.hpp"
+#include "DescriptorAllocator.hpp"
+#include "DrawQueue.hpp"
+#include "InstanceCulling.hpp"
+#include "OcclusionBuffer.hpp"
+#include "SpriteBatch.hpp"
+#include "ClusteredLighting.hpp"
 #include "gsl.hpp"
-#include "boost/graph/adjacency_list.hpp"
 
 #include <iostream>
 #include <map>
@@ -44,6 +60,8 @@
 #include <vector>
 #include <iostream>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <optional>
 #include <algorithm>
 #include <array>
@@ -62,28 +80,180 @@ namespace vka
 {
 	using json = nlohmann::json;
 	using HashType = entt::HashedString::hash_type;
-	using IndexType = uint8_t;
+	using IndexType = uint16_t;
 	using PositionType = glm::vec3;
 	using NormalType = glm::vec3;
-	constexpr size_t MaxLights = 3U;
-	constexpr size_t BufferCount = 3U;
+	// frames the CPU may record ahead of the GPU, overridden by FramesInFlight in the init json
+	constexpr size_t DefaultFramesInFlight = 2U;
+	// binding of the 2D texture array in the static descriptor set
+	constexpr uint32_t TextureBinding2D = 2U;
+	// per frame descriptor pools grow by pools of this many sets
+	constexpr uint32_t DescriptorSetsPerPool = 16U;
+	// acquire blocks instead of polling, but wakes up often enough to notice shutdown
+	constexpr uint64_t AcquireTimeout = 100000000U;
+	// acquire blocks long before this many presents can queue up
+	constexpr size_t PresentQueueSize = 8U;
+	constexpr size_t LODCount = 3U;
+	// the indirect buffer starts with one draw count per vertex format
+	constexpr VkDeviceSize IndirectCountHeaderSize = 16U;
+	constexpr size_t VertexFormatCount = 2U;
+	// below these sizes splitting work across threads costs more than it saves
+	constexpr size_t MinEntitiesPerPartition = 256U;
+	constexpr size_t MinDrawsPerPartition = 64U;
+	// occluders are rasterized on the CPU at this resolution, the width a multiple of four
+	constexpr size_t OcclusionBufferWidth = 256U;
+	constexpr size_t OcclusionBufferHeight = 128U;
+
+	// per instance data read by the 3D vertex shader through gl_InstanceIndex
+	struct InstanceData
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+	};
+
+	// the 3D shaders' per frame uniform block
+	struct FrameUniforms
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		ClusterParameters clusters;
+	};
+
+	// layer field of draw sort keys, drawn in this order
+	constexpr uint32_t DrawLayerOpaque3D = 0U;
+	constexpr uint32_t DrawLayerBlended2D = 1U;
+
+	// a culled and LOD selected draw, ranges index into data3D.drawListRanges
+	struct ModelDraw
+	{
+		uint64_t sortKey;
+		uint64_t modelIndex;
+		VertexFormat vertexFormat;
+		size_t firstRange;
+		size_t rangeCount;
+		uint32_t firstInstance;
+		uint32_t instanceCount;
+	};
+
+	// state changes, draw calls and frustum culled 3D instances of one frame
+	struct FrameCounts
+	{
+		uint32_t pipelineBinds;
+		uint32_t descriptorBinds;
+		uint32_t drawCalls;
+		uint32_t visibleInstances;
+		uint32_t culledInstances;
+		uint32_t occludedInstances;
+	};
 
-	struct FragmentPushConstants
+	// camera values culling and LOD selection need, captured on the thread that owns the camera
+	struct CameraState
 	{
+		glm::mat4 viewProjection;
+		glm::vec3 position;
+		float projectionScale;
+		// of the 2D camera, sprites are drawn with it
+		glm::mat4 viewProjection2D;
+		// lights are clustered in view space
+		glm::mat4 view;
+		glm::mat4 projection;
+		float nearPlane;
+		float farPlane;
+		// VulkanApp::lodBias when captured
+		float lodBias;
+	};
+
+	struct ModelInstance
+	{
+		uint64_t modelIndex;
+		glm::mat4 transform;
 		glm::vec4 color;
+		// rasterize the model's collision mesh to hide instances behind it
+		bool occluder = false;
 	};
 
-	class VulkanApp
+	struct SpriteInstance
+	{
+		uint64_t spriteIndex;
+		glm::mat4 transform;
+		glm::vec4 color;
+	};
+
+	// a point light, it reaches nothing beyond radius
+	struct LightInstance
+	{
+		glm::vec3 position;
+		float radius;
+		// alpha scales the intensity
+		glm::vec4 color;
+	};
+
+	// what the render thread needs from one simulation step, filled by the game
+	// thread and handed over whole; vectors keep their capacity between frames
+	struct RenderSnapshot
+	{
+		TimePoint_ms simulationTime;
+		CameraState camera;
+		std::vector<ModelInstance> models;
+		std::vector<SpriteInstance> sprites;
+		std::vector<LightInstance> lights;
+	};
+
+	// a submitted frame waiting for the present thread
+	struct PresentRequest
 	{
-		friend class FrameRender;
+		VkSwapchainKHR swapchain;
+		uint32_t imageIndex;
+		VkSemaphore waitSemaphore;
+	};
+
+	struct VertexSpecializationData
+	{
+		VkBool32 octahedralNormals;
+	};
 
+	class VulkanApp
+	{
 	public:
 		GLFWwindow * window;
 		TimePoint_ms startupTimePoint;
 		TimePoint_ms currentSimulationTime;
-		bool gameLoop = true;
+		// runs fixed updates on the game thread
+		FramePacer updatePacer = FramePacer(UpdateDuration);
+		// TargetFrameRate in the init json caps the render thread, 0 leaves it to vsync
+		FramePacer framePacer = FramePacer(UpdateDuration);
+		// the game thread publishes a snapshot after each batch of updates, the render thread draws the newest
+		TripleBuffer<RenderSnapshot> renderSnapshots;
+		// set by the render thread after recreating the swapchain, the game thread owns the cameras
+		std::atomic<bool> surfaceResized = false;
+
+		// vkQueuePresentKHR can block for most of a vblank, so it runs on its own thread
+		SpscQueue<PresentRequest, PresentQueueSize> presentRequests;
+		std::atomic<uint32_t> pendingPresents = 0;
+		// first failure seen by the present thread, rethrown on the render thread
+		std::atomic<VkResult> presentResult = VK_SUCCESS;
+		std::atomic<bool> presentLoop = true;
+		// only used to sleep while there is nothing to present
+		std::mutex presentWakeMutex;
+		std::condition_variable presentWake;
+		VkQueue presentQueue;
+		// submit and present need external synchronization when they share a VkQueue
+		bool presentQueueShared = true;
+		std::mutex sharedQueueMutex;
+		std::atomic<bool> gameLoop = true;
 		LibraryHandle VulkanLibrary;
 		Camera2D camera;
+		Camera3D camera3D;
+		// positive values switch to coarser LODs sooner, each step doubles the tolerated pixel error;
+		// starts at LODBias from the init json, owned by the game thread like the cameras
+		float lodBias = 0.f;
+		// counts of the last submitted frame, read on the render thread
+		FrameCounts GetLastFrameCounts() const { return lastFrameCounts; }
+		// set when the device supports multiDrawIndirect and drawIndirectFirstInstance
+		bool multiDrawIndirect = false;
+		// set when VK_AMD_draw_indirect_count is enabled, draw counts are then read from the buffer
+		bool drawIndirectCount = false;
+		uint32_t maxDrawIndirectCount = 1U;
 
 		VkInstance instance;
 		std::optional<Instance> instanceOptional;
@@ -95,19 +265,23 @@ namespace vka
 		VkViewport viewport;
 		VkRect2D scissorRect;
 		std::optional<DeviceManager> deviceOptional;
+		// frames and uploads signal it, objects are retired against its values
+		std::optional<GpuTimeline> timelineOptional;
 		VkDevice device;
+		// workers for culling and secondary command buffer recording
+		std::optional<ThreadPool> threadPoolOptional;
 
 		struct {
 			struct {
 				json sampler;
-				json pipelineLayout;
-				json pipeline;
+				json staticDescriptorSetLayout;
+				json dynamicDescriptorSetLayout;
 			} c2D;
 			struct {
-				json pipelineLayout;
-				json pipeline;
+				json quantizedPipeline;
+				json staticDescriptorSetLayout;
+				json dynamicDescriptorSetLayout;
 			} c3D;
-			json renderPass;
 			json swapchain;
 		} configs;
 
@@ -116,21 +290,28 @@ namespace vka
 		VkSwapchainKHR swapchain;
 
 		struct {
+			// textures are indexed from one update after bind array, so loading
+			// one only writes its descriptor
+			bool bindless = false;
+			std::optional<TextureSlots> textureSlotsOptional;
 			VkSampler sampler;
 			VkDescriptorSetLayout staticDescriptorSetLayout;
 			VkDescriptorPool staticDescriptorPool;
-			VkDescriptorSet staticDescriptorSet;
+			VkDescriptorSet staticDescriptorSet = VK_NULL_HANDLE;
+			// the sprite buffer's set is allocated per frame, see PerFrameResources
 			VkDescriptorSetLayout dynamicDescriptorSetLayout;
-			VkDescriptorPool dynamicDescriptorPool;
-			VkDescriptorSet dynamicDescriptorSet;
 			VkShaderModule vertexShader;
 			VkShaderModule fragmentShader;
 			VkPipelineLayout pipelineLayout;
 			VkPipeline pipeline;
 			std::map<uint64_t, UniqueImage2D> images;
 			std::map<uint64_t, Sprite> sprites;
-			std::vector<Quad> quads;
-			UniqueAllocatedBuffer vertexBuffer;
+			// sprites sorted back to front, blending needs the far ones drawn first
+			std::vector<DrawPacket> spritePackets;
+			std::vector<DrawPacket> spritePacketScratch;
+			SpriteBatcher spriteBatcher;
+			// writes a frame's sprite buffer into its freshly allocated set
+			std::optional<DescriptorUpdateTemplate> spriteTemplateOptional;
 		} data2D;
 
 		struct {
@@ -141,53 +322,150 @@ namespace vka
 			UniqueAllocatedBuffer indexBuffer;
 			UniqueAllocatedBuffer positionBuffer;
 			UniqueAllocatedBuffer normalBuffer;
+			NormalEncoding normalEncoding;
+			std::vector<QuantizedPosition> quantizedPositions;
+			std::vector<uint8_t> quantizedNormals;
+			UniqueAllocatedBuffer quantizedPositionBuffer;
+			UniqueAllocatedBuffer quantizedNormalBuffer;
+			// instances gathered per model and LOD, drawn with one call per batch
+			std::map<std::pair<uint64_t, size_t>, std::vector<InstanceData>> instanceBatches;
+			// instances with partially culled meshlets need their own ranges
+			struct PartialInstance
+			{
+				uint64_t modelIndex;
+				InstanceData data;
+				size_t firstRange;
+				size_t rangeCount;
+			};
+			// each gather partition writes only to its own scratch
+			struct GatherScratch
+			{
+				// world space instance spheres, tested against the frustum before LOD selection
+				InstanceBounds bounds;
+				std::vector<uint8_t> visible;
+				size_t visibleCount = 0;
+				// frustum visible occluders, by instance index
+				std::vector<size_t> occluders;
+				size_t occludedCount = 0;
+				std::vector<IndexRange> drawRanges;
+				std::map<std::pair<uint64_t, size_t>, std::vector<InstanceData>> instanceBatches;
+				std::vector<PartialInstance> partialInstances;
+				std::vector<IndexRange> partialRanges;
+			};
+			std::vector<GatherScratch> gatherScratch;
+			OcclusionBuffer occlusionBuffer = OcclusionBuffer(OcclusionBufferWidth, OcclusionBufferHeight);
+			// draws prepared for recording this frame, in sort key order
+			std::vector<ModelDraw> draws;
+			std::vector<ModelDraw> unsortedDraws;
+			std::vector<DrawPacket> drawPackets;
+			std::vector<DrawPacket> drawPacketScratch;
+			std::vector<IndexRange> drawListRanges;
+			// indirect draws collected during the frame, indexed by VertexFormat
+			std::array<std::vector<VkDrawIndexedIndirectCommand>, VertexFormatCount> indirectCommands;
+			// both sets are allocated per frame, see PerFrameResources; the
+			// static layout holds the camera and the light clusters
 			VkDescriptorSetLayout staticDescriptorSetLayout;
-			VkDescriptorPool staticDescriptorPool;
-			VkDescriptorSet staticDescriptorSet;
 			VkDescriptorSetLayout dynamicDescriptorSetLayout;
-			VkDescriptorPool dynamicDescriptorPool;
-			VkDescriptorSet dynamicDescriptorSet; 
 			VkShaderModule vertexShader;
 			VkShaderModule fragmentShader;
 			VkPipelineLayout pipelineLayout;
 			VkPipeline pipeline;
+			VkPipeline quantizedPipeline;
+			// writes a frame's instance buffer into its freshly allocated set
+			std::optional<DescriptorUpdateTemplate> instanceTemplateOptional;
+			// writes a frame's uniforms and light buffers into its lighting set
+			std::optional<DescriptorUpdateTemplate> lightingTemplateOptional;
+			LightClusters lightClusters;
+			// view space light spheres of the frame being prepared
+			std::vector<glm::vec4> viewLights;
 		} data3D;
 
 		VkCommandPool utilityCommandPool;
 		VkCommandBuffer utilityCommandBuffer;
+		// image uploads still wait on this, buffer uploads go through the timeline
 		VkFence utilityCommandFence;
 
-		struct PerImageResources
+		// everything the CPU writes while recording a frame, reused once the timeline passes the frame
+		struct PerFrameResources
 		{
+			// camera, lights and clusters the 3D shaders read, written by PrepareLighting
+			struct {
+				UniqueAllocatedBuffer uniformBuffer;
+				FrameUniforms* uniforms = nullptr;
+				UniqueAllocatedBuffer rangeBuffer;
+				ClusterRange* ranges = nullptr;
+				UniqueAllocatedBuffer lightBuffer;
+				LightData* lights = nullptr;
+				size_t lightCapacity = 0;
+				UniqueAllocatedBuffer indexBuffer;
+				uint32_t* indices = nullptr;
+				size_t indexCapacity = 0;
+				VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+			} lighting;
+			struct {
+				UniqueAllocatedBuffer buffer;
+				InstanceData* mapped = nullptr;
+				size_t count = 0;
+				size_t capacity = 0;
+				VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+			} instances;
+			// sprite data written each frame, the vertex shader expands it into quads
 			struct {
-				struct {
-					struct {
-						UniqueAllocatedBuffer buffer;
-						size_t count;
-						size_t capacity;
-					} dynamic;
-					struct {
-						UniqueAllocatedBuffer buffer;
-					} fixed;
-				} matrices;
-				struct {
-					UniqueAllocatedBuffer buffer;
-				} lights;
-			} uniforms;
+				UniqueAllocatedBuffer buffer;
+				SpriteData* mapped = nullptr;
+				size_t capacity = 0;
+				VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+			} sprites;
+			struct {
+				UniqueAllocatedBuffer buffer;
+				uint8_t* mapped = nullptr;
+				size_t capacity = 0;
+			} indirect;
+			// one pool per worker thread, reset as a whole once the timeline passes the frame
+			struct ThreadCommandPool
+			{
+				VkCommandPool pool;
+				std::vector<VkCommandBuffer> secondaryBuffers;
+				size_t usedCount = 0;
+			};
+			std::vector<ThreadCommandPool> threadCommandPools;
+			// sets used only by this frame, all returned at once when it is reused
+			std::optional<DescriptorAllocator> descriptorsOptional;
+			VkCommandBuffer renderCommandBuffer;
+			VkSemaphore imageAcquiredSemaphore;
+			// timeline value signaled by this slot's last submit
+			uint64_t frameNumber = 0;
+		};
+		std::vector<PerFrameResources> perFrameResources;
+		size_t currentFrame = 0;
+
+		// secondary command buffers are recorded in parallel, so the frame's counts are atomic
+		struct {
+			std::atomic<uint32_t> pipelineBinds = 0;
+			std::atomic<uint32_t> descriptorBinds = 0;
+			std::atomic<uint32_t> drawCalls = 0;
+			std::atomic<uint32_t> visibleInstances = 0;
+			std::atomic<uint32_t> culledInstances = 0;
+			std::atomic<uint32_t> occludedInstances = 0;
+		} frameCounters;
+		FrameCounts lastFrameCounts = {};
+
+		// one per swapchain image, indexed by the acquired image index
+		struct PerImageResources
+		{
 			struct {
 				VkImage image;
 				VkImageView view;
 				VkFramebuffer framebuffer;
-
 			} swap;
-			VkCommandBuffer renderCommandBuffer;
-			VkFence renderCommandBufferExecutedFence;
-			VkSemaphore imageRenderedSemaphore;
+			VkSemaphore imageRenderedSemaphore = VK_NULL_HANDLE;
 		};
-		std::array<PerImageResources, BufferCount> perImageResources;
+		std::vector<PerImageResources> perImageResources;
+		// rendered semaphores of replaced swapchains and their image index, kept
+		// until presents can no longer wait on them
+		std::vector<std::pair<uint32_t, VkSemaphore>> replacedRenderedSemaphores;
 		VkDeviceSize uniformBufferAlignment;
 		VkCommandPool renderCommandPool;
-		Pool<VkFence> imagePresentedFencePool;
 		uint32_t nextImage;
 		VkClearValue clearValue;
 
@@ -200,11 +478,16 @@ namespace vka
 		virtual void LoadModels() = 0;
 		virtual void LoadImages() = 0;
 		virtual void Update(TimePoint_ms) = 0;
-		virtual void Draw() = 0;
+		// called on the game thread after updates; camera and time are already filled in
+		virtual void ExtractRenderState(RenderSnapshot& snapshot) = 0;
+		// called on the render thread, interpolation is how far real time has
+		// moved past the snapshot, in update steps
+		virtual void Draw(const RenderSnapshot& snapshot, float interpolation) = 0;
 
-		void CleanUpSwapchain();
+		// retires the old swapchain's objects instead of waiting for the device to idle
+		void RecreateSwapchain(bool surfaceLost);
 
-		void CreateSwapchain();
+		void CreateSwapchain(VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE);
 
 		void CreateSurface();
 
@@ -212,69 +495,109 @@ namespace vka
 
 		void Run(std::string vulkanInitJsonPath);
 
-		void LoadModelFromFile(std::string path, entt::HashedString fileName);
+		void LoadModelFromFile(std::string path, entt::HashedString fileName, VertexFormat vertexFormat = VertexFormat::Float);
 
 		void CreateImage2D(const HashType imageID, const Bitmap &bitmap);
 
+		void WriteTextureDescriptor(uint32_t slot, VkImageView view);
+
+		// config paths swapped for their descriptor indexing variants when enabled
+		std::string ConfigVariant(const std::string& path);
+
 		void CreateSprite(const HashType imageID, const HashType spriteName, const Quad quad);
 
 		void BeginRenderPass(const uint32_t& instanceCount);
 
-		void BindPipeline2D();
+		// sprites are drawn without vertex buffers, so only sets and the camera are bound
+		void BindPipeline2D(VkCommandBuffer commandBuffer, VkDescriptorSet spriteSet, const glm::mat4& viewProjection);
+
+		void BindPipeline3D(VkCommandBuffer commandBuffer, VertexFormat vertexFormat = VertexFormat::Float);
+
+		// records each job into its own secondary command buffer on the thread
+		// pool, then executes them in job order inside the current render pass
+		void RecordInParallel(const std::vector<std::function<void(VkCommandBuffer)>>& jobs);
 
-		void BindPipeline3D();
+		CameraState CaptureCameraState();
 
-		void RenderModel(const uint64_t modelIndex, const glm::mat4 modelMatrix, const glm::vec4 modelColor);
+		// culls and batches instances across the thread pool and writes their
+		// instance data, filling data3D.draws; getInstance(i) returns a ModelInstance
+		template<typename GetInstance>
+		void PrepareModelInstances(const CameraState& cameraState, size_t instanceCount, GetInstance&& getInstance);
+
+		// records data3D.draws[begin, end), safe to call from several threads at once
+		void RecordModelDraws(VkCommandBuffer commandBuffer, size_t begin, size_t end);
+
+		// records everything the last PrepareModelInstances produced
+		void RecordPreparedDraws();
+
+		void RenderSnapshotModels(const RenderSnapshot& snapshot);
+
+		// bins the lights into view space clusters and writes them with the
+		// camera for this frame; must precede any 3D draw of the frame
+		void PrepareLighting(const CameraState& camera, const std::vector<LightInstance>& lights);
+
+		// writes the snapshot's sprites into this frame's sprite buffer and
+		// draws them in as few instanced draws as the texture binding allows
+		void RenderSnapshotSprites(const RenderSnapshot& snapshot);
+
+		// with multi draw indirect the draw is only queued for EndRenderPass and
+		// the call must come from the thread that owns the frame
+		void RenderModel(VkCommandBuffer commandBuffer, const uint64_t modelIndex, gsl::span<const IndexRange> indexRanges, const uint32_t firstInstance, const uint32_t instanceCount);
 
 		void EndRenderPass();
 
 		void PresentImage();
 
 	private:
-		void AcquireNextImage(VkFence& fence);
+		bool AcquireNextImage(VkSemaphore imageAcquiredSemaphore);
+
+		// retires the replaced rendered semaphores an acquire of imageIndex frees
+		void RetireReplacedSemaphores(uint32_t imageIndex);
 
-		void CreateVertexBuffers2D();
+		bool BeginFrame();
 
 		void CreateVertexBuffers3D();
 
-		void CreateMatrixBuffer(size_t imageIndex, VkDeviceSize newSize);
+		// builds render passes, layouts, shaders and pipelines from config/dependencyGraph.json
+		void CreateGraphObjects();
+
+		void PrepareRender(uint32_t instanceCount);
+
+		// orders data3D.draws by sort key so pipeline and geometry changes are grouped
+		void SortDraws();
+
+		uint64_t ModelSortKey(uint64_t modelIndex, float distance);
+
+		void CreateInstanceBuffer(size_t frameIndex, size_t capacity);
+
+		void CreateSpriteBuffer(size_t frameIndex, size_t capacity);
+
+		// host visible and coherent, mapped for the buffer's lifetime
+		void* CreateMappedBuffer(UniqueAllocatedBuffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage);
+
+		void CreateLightBuffer(size_t frameIndex, size_t capacity);
+
+		void CreateLightIndexBuffer(size_t frameIndex, size_t capacity);
+
+		void CreateIndirectBuffer(size_t frameIndex, size_t capacity);
+
+		void FlushIndirectDraws(VkCommandBuffer commandBuffer);
+
+		VkCommandBuffer BeginSecondaryCommandBuffer(size_t threadIndex);
+
+		uint32_t WriteInstances(const InstanceData* instances, size_t count);
 
 		void SetClearColor(float r, float g, float b, float a);
 
 		void GameThread();
 
-		void UpdateCameraSize();
+		void RenderThread();
 
-		enum class VulkanType
-		{
-			Instance,
-			PhysicalDevice,
-			Surface,
-			Device,
-			RenderPass,
-			Swapchain,
-			ShaderModule,
-			DescriptorSetLayout,
-			DescriptorPool,
-			DescriptorSet,
-			PushConstantRange,
-			PipelineLayout,
-			Pipeline,
-			CommandPool,
-			CommandBuffer
-		};
+		void PresentThread();
 
-		struct NodeProps
-		{
-			VulkanType vulkanType;
-			std::string path;
-		};
-		void GraphTesting()
-		{
-			auto graph = boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS, NodeProps>();
-			boost::add_vertex(NodeProps{ VulkanType::Instance, std::string("config/instance.json") }, graph);
-			boost::add_vertex(NodeProps{ VulkanType::PhysicalDevice, std::string("config/physicalDevice.json") }, graph);
-		}
+		void WaitForPresents();
+
+		void UpdateCameraSize();
 };
 
 	enum class RenderResults
@@ -290,6 +613,8 @@ namespace vka
 			// successes
 		case VK_NOT_READY:
 			return RenderResults::Return;
+		case VK_TIMEOUT:
+			return RenderResults::Return;
 		case VK_SUCCESS:
 			return RenderResults::Continue;
 
@@ -312,132 +637,6 @@ namespace vka
 		return RenderResults::Continue;
 	}
 
-	static void FrameRender(
-		const VkDevice& device,
-		uint32_t& nextImage,
-		const VkSwapchainKHR& swapchain,
-		const VkFence& imagePresentedFence,
-		const VkCommandBuffer& renderCommandBuffer,
-		const VkFence& renderCommandBufferExecutedFence,
-		const VkFramebuffer& framebuffer,
-		const VkSemaphore& imageRenderedSemaphore,
-		std::function<void()> drawFunc,
-		const VkRenderPass& renderPass,
-		const VkDescriptorSet& fragmentDescriptorSet2D,
-		const VkDescriptorSet& vertexDescriptorSet2D,
-		const VkDescriptorSet& vertexDescriptorSet3D,
-		const VkPipelineLayout& pipelineLayout2D,
-		const VkPipelineLayout& pipelineLayout3D,
-		const VkPipeline& pipeline2D,
-		const VkPipeline& pipeline3D,
-		const VkBuffer& vertexBuffer2D,
-		const VkBuffer& indexBuffer3D,
-		const VkBuffer& positionBuffer3D,
-		const VkBuffer& normalBuffer3D,
-		const VkQueue& graphicsQueue,
-		const VkExtent2D& extent,
-		const VkClearValue& clearValue)
-	{
-		VkViewport viewport = {};
-		viewport.x = 0.f;
-		viewport.y = 0.f;
-		viewport.width = static_cast<float>(extent.width);
-		viewport.height = static_cast<float>(extent.height);
-		viewport.minDepth = 0.f;
-		viewport.maxDepth = 1.f;
-
-		VkRect2D scissorRect = {};
-		scissorRect.offset.x = 0;
-		scissorRect.offset.y = 0;
-		scissorRect.extent = extent;
-
-		// Wait for this frame's render command buffer to finish executing
-		vkWaitForFences(device,
-			1,
-			&renderCommandBufferExecutedFence,
-			true, std::numeric_limits<uint64_t>::max());
-		vkResetFences(device, 1, &renderCommandBufferExecutedFence);
-
-		// record the command buffer
-		VkCommandBufferBeginInfo beginInfo = {};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.pNext = nullptr;
-		beginInfo.flags = 0;
-		beginInfo.pInheritanceInfo = nullptr;
-		vkBeginCommandBuffer(renderCommandBuffer, &beginInfo);
-
-		VkRenderPassBeginInfo renderPassBeginInfo = {};
-		renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassBeginInfo.pNext = nullptr;
-		renderPassBeginInfo.renderPass = renderPass;
-		renderPassBeginInfo.framebuffer = framebuffer;
-		renderPassBeginInfo.renderArea = scissorRect;
-		renderPassBeginInfo.clearValueCount = 1;
-		renderPassBeginInfo.pClearValues = &clearValue;
-		vkCmdBeginRenderPass(renderCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-		vkCmdBindPipeline(renderCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline2D);
-
-		vkCmdSetViewport(renderCommandBuffer, 0, 1, &viewport);
-		vkCmdSetScissor(renderCommandBuffer, 0, 1, &scissorRect);
-
-		VkDeviceSize vertexBufferOffset = 0;
-		vkCmdBindVertexBuffers(renderCommandBuffer, 0, 1,
-			&vertexBuffer2D,
-			&vertexBufferOffset);
-
-		// bind sampler and images uniforms
-		vkCmdBindDescriptorSets(renderCommandBuffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			pipelineLayout2D,
-			0,
-			1, &fragmentDescriptorSet2D,
-			0, nullptr);
-
-		drawFunc();
-
-		// Finish recording draw command buffer
-		vkCmdEndRenderPass(renderCommandBuffer);
-		vkEndCommandBuffer(renderCommandBuffer);
-
-		// Submit draw command buffer
-		auto stageFlags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		VkSubmitInfo submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.pNext = nullptr;
-		submitInfo.waitSemaphoreCount = 0;
-		submitInfo.pWaitSemaphores = nullptr;
-		submitInfo.pWaitDstStageMask = nullptr;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &renderCommandBuffer;
-		submitInfo.signalSemaphoreCount = 1;
-		submitInfo.pSignalSemaphores = &imageRenderedSemaphore;
-
-		vkWaitForFences(device, 1, &imagePresentedFence, true, std::numeric_limits<uint64_t>::max());
-		vkResetFences(device, 1, &imagePresentedFence);
-
-		auto drawSubmitResult = vkQueueSubmit(graphicsQueue, 1,
-			&submitInfo, renderCommandBufferExecutedFence);
-
-		// Present image
-		VkPresentInfoKHR presentInfo = {};
-		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-		presentInfo.pNext = nullptr;
-		presentInfo.waitSemaphoreCount = 1;
-		presentInfo.pWaitSemaphores = &imageRenderedSemaphore;
-		presentInfo.swapchainCount = 1;
-		presentInfo.pSwapchains = &swapchain;
-		presentInfo.pImageIndices = &nextImage;
-		presentInfo.pResults = nullptr;
-
-		auto presentResult = vkQueuePresentKHR(
-			graphicsQueue,
-			&presentInfo);
-
-		HandleRenderErrors(presentResult);
-		fencePool.pool(imagePresentedFence);
-	}
-
 	static VulkanApp *GetUserPointer(GLFWwindow *window)
 	{
 		return reinterpret_cast<VulkanApp *>(glfwGetWindowUserPointer(window));
@@ -537,17 +736,192 @@ namespace vka
 	// 	std::vector<Sprite> createTextGroup(const Text::InitInfo & initInfo);
 	// };
 
-	template<typename ...Ts, typename ViewT>
-	inline void VulkanApp::RenderModelInstances(const ViewT & view)
+	template<typename GetInstance>
+	inline void VulkanApp::PrepareModelInstances(const CameraState& cameraState, size_t instanceCount, GetInstance&& getInstance)
 	{
-		auto count = view.size();
-		for (const auto& entity : view)
+		auto& threadPool = *threadPoolOptional;
+		auto partitionCount = std::min(
+			threadPool.GetThreadCount(),
+			(instanceCount + MinEntitiesPerPartition - 1) / MinEntitiesPerPartition);
+		if (data3D.gatherScratch.size() < partitionCount)
+		{
+			data3D.gatherScratch.resize(partitionCount);
+		}
+
+		// whole instances outside the frustum skip LOD selection and meshlet culling
+		auto frustum = FrustumFromMatrix(cameraState.viewProjection);
+		partitionCount = threadPool.ParallelFor(instanceCount, partitionCount, [&](size_t partition, size_t begin, size_t end, size_t)
+		{
+			auto& scratch = data3D.gatherScratch[partition];
+			scratch.bounds.Clear();
+			scratch.occluders.clear();
+			for (auto i = begin; i < end; ++i)
+			{
+				const auto& source = getInstance(i);
+				const auto& mesh = data3D.models.at(source.modelIndex).full;
+				glm::vec3 center;
+				float radius;
+				TransformSphere(source.transform, mesh.boundsCenter, mesh.boundsRadius, center, radius);
+				scratch.bounds.Push(center, radius);
+			}
+			scratch.visibleCount = CullSpheres(frustum, scratch.bounds, scratch.visible);
+			for (auto i = begin; i < end; ++i)
+			{
+				if (scratch.visible[i - begin] && getInstance(i).occluder)
+				{
+					scratch.occluders.push_back(i);
+				}
+			}
+		});
+
+		// the few occluders are rasterized here, the rest is tested against them in parallel
+		auto& occlusionBuffer = data3D.occlusionBuffer;
+		auto occlusionTest = false;
+		occlusionBuffer.Clear();
+		for (auto partition = 0U; partition < partitionCount; ++partition)
+		{
+			for (auto i : data3D.gatherScratch[partition].occluders)
+			{
+				const auto& source = getInstance(i);
+				const auto& collision = data3D.models.at(source.modelIndex).collision;
+				if (collision.indices.empty())
+				{
+					continue;
+				}
+				occlusionBuffer.RasterizeMesh(cameraState.viewProjection * source.transform, collision.positions, collision.indices);
+				occlusionTest = true;
+			}
+		}
+		if (occlusionTest)
+		{
+			occlusionBuffer.BuildHiZ();
+		}
+
+		threadPool.ParallelFor(instanceCount, partitionCount, [&](size_t partition, size_t begin, size_t end, size_t)
+		{
+			auto& scratch = data3D.gatherScratch[partition];
+			for (auto& [key, batch] : scratch.instanceBatches)
+			{
+				batch.clear();
+			}
+			scratch.partialInstances.clear();
+			scratch.partialRanges.clear();
+			scratch.occludedCount = 0;
+
+			for (auto i = begin; i < end; ++i)
+			{
+				if (!scratch.visible[i - begin])
+				{
+					continue;
+				}
+				const auto& source = getInstance(i);
+				// occluders would hide themselves
+				if (occlusionTest && !source.occluder && occlusionBuffer.IsSphereOccluded(
+					cameraState.viewProjection,
+					glm::vec3(scratch.bounds.centerX[i - begin], scratch.bounds.centerY[i - begin], scratch.bounds.centerZ[i - begin]),
+					scratch.bounds.radius[i - begin]))
+				{
+					++scratch.occludedCount;
+					continue;
+				}
+				const auto& transform = source.transform;
+				const auto& modelIndex = source.modelIndex;
+				const auto& model = data3D.models.at(modelIndex);
+				auto lod = SelectLOD(model.full, transform, cameraState.position, cameraState.projectionScale, cameraState.lodBias);
+				GetDrawRanges(model.full, lod, transform, cameraState.viewProjection, cameraState.position, scratch.drawRanges);
+				if (scratch.drawRanges.empty())
+				{
+					continue;
+				}
+
+				InstanceData instance = { transform * model.dequantize, source.color };
+				auto fullRange = GetLODRange(model.full, lod);
+				if (scratch.drawRanges.size() == 1 && scratch.drawRanges[0] == fullRange)
+				{
+					scratch.instanceBatches[{ modelIndex, lod }].push_back(instance);
+					continue;
+				}
+				scratch.partialInstances.push_back({
+					modelIndex,
+					instance,
+					scratch.partialRanges.size(),
+					scratch.drawRanges.size() });
+				scratch.partialRanges.insert(
+					scratch.partialRanges.end(),
+					scratch.drawRanges.begin(),
+					scratch.drawRanges.end());
+			}
+		});
+
+		// merge in partition order so the draw list does not depend on scheduling
+		for (auto& [key, batch] : data3D.instanceBatches)
+		{
+			batch.clear();
+		}
+		size_t visibleCount = 0;
+		size_t occludedCount = 0;
+		for (auto partition = 0U; partition < partitionCount; ++partition)
+		{
+			visibleCount += data3D.gatherScratch[partition].visibleCount;
+			occludedCount += data3D.gatherScratch[partition].occludedCount;
+			for (const auto& [key, batch] : data3D.gatherScratch[partition].instanceBatches)
+			{
+				auto& merged = data3D.instanceBatches[key];
+				merged.insert(merged.end(), batch.begin(), batch.end());
+			}
+		}
+
+		frameCounters.visibleInstances += gsl::narrow<uint32_t>(visibleCount - occludedCount);
+		frameCounters.culledInstances += gsl::narrow<uint32_t>(instanceCount - visibleCount);
+		frameCounters.occludedInstances += gsl::narrow<uint32_t>(occludedCount);
+
+		data3D.draws.clear();
+		data3D.drawListRanges.clear();
+		for (const auto& [key, batch] : data3D.instanceBatches)
+		{
+			if (batch.empty())
+			{
+				continue;
+			}
+			const auto& [modelIndex, lod] = key;
+			// the nearest instance decides where the batch sorts
+			auto nearest = std::numeric_limits<float>::max();
+			for (const auto& instance : batch)
+			{
+				nearest = std::min(nearest, glm::distance(cameraState.position, glm::vec3(instance.model[3])));
+			}
+			data3D.draws.push_back({
+				ModelSortKey(modelIndex, nearest),
+				modelIndex,
+				data3D.models.at(modelIndex).vertexFormat,
+				data3D.drawListRanges.size(),
+				1,
+				WriteInstances(batch.data(), batch.size()),
+				gsl::narrow<uint32_t>(batch.size()) });
+			data3D.drawListRanges.push_back(GetLODRange(data3D.models.at(modelIndex).full, lod));
+		}
+
+		for (auto partition = 0U; partition < partitionCount; ++partition)
 		{
-			const auto&[t, c, m] = view.get<Ts...>(entity);
-			const glm::mat4& transform = t;
-			const glm::vec4& color = c;
-			const uint64_t& modelIndex = m;
+			const auto& scratch = data3D.gatherScratch[partition];
+			for (const auto& partial : scratch.partialInstances)
+			{
+				data3D.draws.push_back({
+					ModelSortKey(partial.modelIndex, glm::distance(cameraState.position, glm::vec3(partial.data.model[3]))),
+					partial.modelIndex,
+					data3D.models.at(partial.modelIndex).vertexFormat,
+					data3D.drawListRanges.size(),
+					partial.rangeCount,
+					WriteInstances(&partial.data, 1),
+					1 });
+				auto rangeBegin = scratch.partialRanges.begin() + partial.firstRange;
+				data3D.drawListRanges.insert(
+					data3D.drawListRanges.end(),
+					rangeBegin,
+					rangeBegin + partial.rangeCount);
+			}
 		}
+		SortDraws();
 	}
 
-} // namespace vka
\ No newline at end of file
+} // namespace vka
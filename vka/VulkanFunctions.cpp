@@ -1,6 +1,7 @@
 #define WIN32_LEAN_AND_MEAN
 #define NOMINMAX
 #include "vulkan/vulkan.h"
+#include "VulkanExtensions.hpp"
 
 #define VK_EXPORTED_FUNCTION( fun ) PFN_##fun fun;
 #define VK_GLOBAL_LEVEL_FUNCTION( fun ) PFN_##fun fun;
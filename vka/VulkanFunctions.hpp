@@ -1,5 +1,6 @@
 #pragma once
 #include "vulkan/vulkan.h"
+#include "VulkanExtensions.hpp"
 
 #define VK_EXPORTED_FUNCTION( fun ) extern PFN_##fun fun;
 #define VK_GLOBAL_LEVEL_FUNCTION( fun) extern PFN_##fun fun;
@@ -49,8 +49,8 @@ VK_INSTANCE_LEVEL_FUNCTION( vkDebugReportMessageEXT )
 // VK_INSTANCE_LEVEL_FUNCTION( vkGetDisplayModePropertiesKHR )
 // VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceExternalImageFormatPropertiesNV )
 // VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceGeneratedCommandsPropertiesNVX )
-// VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceFeatures2KHR )
-// VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceProperties2KHR )
+VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceFeatures2KHR )
+VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceProperties2KHR )
 // VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceFormatProperties2KHR )
 // VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceImageFormatProperties2KHR )
 // VK_INSTANCE_LEVEL_FUNCTION( vkGetPhysicalDeviceQueueFamilyProperties2KHR )
@@ -220,7 +220,10 @@ VK_DEVICE_LEVEL_FUNCTION( vkAcquireNextImageKHR )
 // VK_DEVICE_LEVEL_FUNCTION( vkCmdSetViewportWScalingNV )
 // VK_DEVICE_LEVEL_FUNCTION( vkCmdSetDiscardRectangleEXT )
 // VK_DEVICE_LEVEL_FUNCTION( vkCmdSetSampleLocationsEXT )
-// VK_DEVICE_LEVEL_FUNCTION( vkCmdDrawIndexedIndirectCountAMD )
+VK_DEVICE_LEVEL_FUNCTION( vkCmdDrawIndexedIndirectCountAMD )
+VK_DEVICE_LEVEL_FUNCTION( vkGetSemaphoreCounterValueKHR )
+VK_DEVICE_LEVEL_FUNCTION( vkWaitSemaphoresKHR )
+VK_DEVICE_LEVEL_FUNCTION( vkSignalSemaphoreKHR )
 // VK_DEVICE_LEVEL_FUNCTION( vkDebugMarkerSetObjectNameEXT )
 // VK_DEVICE_LEVEL_FUNCTION( vkDebugMarkerSetObjectTagEXT )
 // VK_DEVICE_LEVEL_FUNCTION( vkGetMemoryWin32HandleNV )
@@ -252,9 +255,9 @@ VK_DEVICE_LEVEL_FUNCTION( vkAcquireNextImageKHR )
 // VK_DEVICE_LEVEL_FUNCTION( vkBindImageMemory2KHR )
 // VK_DEVICE_LEVEL_FUNCTION( vkGetDeviceGroupPresentCapabilitiesKHX )
 // VK_DEVICE_LEVEL_FUNCTION( vkAcquireNextImage2KHX )
-// VK_DEVICE_LEVEL_FUNCTION( vkCreateDescriptorUpdateTemplateKHR )
-// VK_DEVICE_LEVEL_FUNCTION( vkDestroyDescriptorUpdateTemplateKHR )
-// VK_DEVICE_LEVEL_FUNCTION( vkUpdateDescriptorSetWithTemplateKHR )
+VK_DEVICE_LEVEL_FUNCTION( vkCreateDescriptorUpdateTemplateKHR )
+VK_DEVICE_LEVEL_FUNCTION( vkDestroyDescriptorUpdateTemplateKHR )
+VK_DEVICE_LEVEL_FUNCTION( vkUpdateDescriptorSetWithTemplateKHR )
 // VK_DEVICE_LEVEL_FUNCTION( vkGetDeviceGroupSurfacePresentModesKHX )
 // VK_DEVICE_LEVEL_FUNCTION( vkSetHdrMetadataEXT )
 // VK_DEVICE_LEVEL_FUNCTION( vkGetSwapchainStatusKHR )
@@ -38,16 +38,4 @@ namespace vka
 		}
 		return json();
 	}*/
-	
-	template <typename moduleT>
-	static moduleT&& StoreHandle(
-		moduleT&& module, 
-		const json& moduleJson, 
-		std::map<std::string, moduleT>& moduleMap)
-	{
-		std::string uri = moduleJson["jsonID"]["uri"];
-		moduleMap[uri] = module;
-
-		return std::move(module);
-	}
 }
\ No newline at end of file